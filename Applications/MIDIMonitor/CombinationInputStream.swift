@@ -40,6 +40,14 @@ class CombinationInputStream: NSObject {
     weak var delegate: CombinationInputStreamDelegate?
     weak var messageDestination: MessageDestination?
 
+    var latencyMonitor: LatencyMonitor? {
+        didSet {
+            portInputStream.latencyMonitor = latencyMonitor
+            virtualInputStream.latencyMonitor = latencyMonitor
+            spyingInputStream?.latencyMonitor = latencyMonitor
+        }
+    }
+
     var sourceGroups: [CombinationInputStreamSourceGroup] {
         var groups = [portGroup, virtualGroup]
 
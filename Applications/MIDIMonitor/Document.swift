@@ -19,11 +19,15 @@ class Document: NSDocument {
         updateVirtualEndpointName()
 
         stream.delegate = self
-        stream.messageDestination = messageFilter
+        stream.latencyMonitor = latencyMonitor
+        // Meter everything the sources send, before it's filtered
+        stream.messageDestination = rateMeter
+        rateMeter.messageDestination = messageFilter
         messageFilter.filterMask = Message.TypeMask.all
         messageFilter.channelMask = VoiceMessage.ChannelMask.all
 
-        messageFilter.messageDestination = history
+        messageFilter.messageDestination = messageMult
+        messageMult.addDestination(history)
         history.delegate = self
 
         // If the user changed the value of this old obsolete preference, bring its value forward to our new preference
@@ -48,11 +52,18 @@ class Document: NSDocument {
 
     // MIDI processing
     private let stream: CombinationInputStream
+    private let rateMeter = MessageRateMeter()
+    let latencyMonitor = LatencyMonitor()
     private let messageFilter = MessageFilter()
+    private let messageMult = MessageMult()
     private let history = MessageHistory()
+    private var recorder: MessageRecorder?
+    private var replayer: MessageReplayer?
+    private var replayOutputStream: PortOutputStream?
 
     // Transient data
     private var isSysExUpdateQueued = false
+    private var recordingStatusTimer: Timer?
 
 }
 
@@ -358,6 +369,10 @@ extension Document {
         return history.savedMessages
     }
 
+    var messageIndex: MessageIndex {
+        history.index
+    }
+
 }
 
 extension Document {
@@ -409,6 +424,125 @@ extension Document {
         history.clearSavedMessages()
     }
 
+    var sourceRates: [MessageRateMeter.SourceRates] {
+        return rateMeter.sourceRates
+    }
+
+    func resetPeakRates() {
+        rateMeter.resetPeaks()
+    }
+
+}
+
+extension Document {
+
+    // MARK: Recording to disk
+
+    // While recording, every event that passes the filter is also streamed to capture files
+    // in a directory, regardless of how many events the window remembers.
+
+    var isRecordingToDisk: Bool {
+        return recorder?.isRecording ?? false
+    }
+
+    var recordingStatistics: MessageRecorder.Statistics? {
+        return recorder?.statistics
+    }
+
+    func startRecordingToDisk(directoryURL: URL) throws {
+        stopRecordingToDisk()
+
+        let newRecorder = MessageRecorder(directoryURL: directoryURL, baseName: displayName ?? "MIDI Monitor")
+        newRecorder.delegate = self
+        try newRecorder.start()
+
+        recorder = newRecorder
+        messageMult.addDestination(newRecorder)
+
+        recordingStatusTimer = Timer.scheduledTimer(timeInterval: 0.5, target: self, selector: #selector(self.updateRecordingStatus), userInfo: nil, repeats: true)
+        updateRecordingStatus()
+    }
+
+    func stopRecordingToDisk() {
+        guard let recorder else { return }
+
+        messageMult.removeDestination(recorder)
+        recorder.stop()
+        self.recorder = nil
+
+        recordingStatusTimer?.invalidate()
+        recordingStatusTimer = nil
+        updateRecordingStatus()
+    }
+
+    override func close() {
+        stopRecordingToDisk()
+        stopReplaying()
+        super.close()
+    }
+
+    @objc private func updateRecordingStatus() {
+        monitorWindowController?.updateRecordingStatus()
+    }
+
+}
+
+extension Document {
+
+    // MARK: Replaying
+
+    // Plays events to a destination, with the timing they were received with, to reproduce what a device was sent.
+
+    var isReplaying: Bool {
+        return replayer?.isPlaying ?? false
+    }
+
+    var replayDestinations: [Destination] {
+        // Don't offer our own virtual destination, since replaying into it would feed back
+        guard let context = (NSApp.delegate as? AppController)?.midiContext else { return [] }
+        return context.destinations.filter { !$0.isOwnedByThisProcess }
+    }
+
+    func startReplaying(_ messages: [Message], to destination: Destination, speed: Double, loops: Bool) {
+        stopReplaying()
+
+        let outputStream: PortOutputStream
+        if let replayOutputStream {
+            outputStream = replayOutputStream
+        }
+        else {
+            guard let context = (NSApp.delegate as? AppController)?.midiContext else { return }
+            outputStream = PortOutputStream(midiContext: context)
+            replayOutputStream = outputStream
+        }
+        outputStream.destinations = [destination]
+
+        let newReplayer = MessageReplayer(messages: messages, outputStream: outputStream)
+        newReplayer.speed = speed
+        newReplayer.loops = loops
+        replayer = newReplayer
+        newReplayer.start { [weak self] in
+            self?.replayer = nil
+        }
+    }
+
+    func stopReplaying() {
+        replayer?.stop()
+        replayer = nil
+    }
+
+}
+
+extension Document: MessageRecorderDelegate {
+
+    func messageRecorder(_ recorder: MessageRecorder, didFailWithError error: Error) {
+        stopRecordingToDisk()
+
+        if let window = monitorWindowController?.window {
+            presentError(error, modalFor: window, delegate: nil, didPresent: nil, contextInfo: nil)
+        }
+    }
+
 }
 
 extension Document {
@@ -7,6 +7,7 @@
 
 import Cocoa
 import SnoizeMIDI
+import UniformTypeIdentifiers
 
 class MonitorWindowController: NSWindowController {
 
@@ -59,14 +60,21 @@ class MonitorWindowController: NSWindowController {
     @IBOutlet private var maxMessageCountField: NSTextField!
     @IBOutlet private var sysExProgressIndicator: NSProgressIndicator!
     @IBOutlet private var sysExProgressField: NSTextField!
+    @IBOutlet private var rateMeterField: NSTextField!
 
     // Transient data
     private var oneChannel: Int = 1
     private var inputSourceGroups: [CombinationInputStreamSourceGroup] = []
     private var displayedMessages: [Message] = []
+    private var displayQuery: MessageIndex.Query?   // nil when showing every saved message
+    private var displayQuerySearch: MessageIndex.Search?
+    private var displayQueryPositions: [Int] = []
+    private var displayQueryEndPosition = 0
+    private var timeRangeToShow: ClosedRange<MIDITimeStamp>?
     private var messagesNeedScrollToBottom: Bool = false
     private var nextMessagesRefreshDate: NSDate?
     private var nextMessagesRefreshTimer: Timer?
+    private var rateMeterTimer: Timer?
     private var isRestoringWindowSettings = false
     private var doneSettingDocument = false
 
@@ -109,6 +117,8 @@ extension MonitorWindowController {
         messagesTableView.doubleAction = #selector(self.showDetailsOfSelectedMessages(_:))
 
         hideSysExProgressIndicator()
+
+        rateMeterTimer = Timer.scheduledTimer(timeInterval: 0.5, target: self, selector: #selector(self.updateRateMeter), userInfo: nil, repeats: true)
     }
 
     override var document: AnyObject? {
@@ -164,6 +174,24 @@ extension MonitorWindowController: NSUserInterfaceValidations {
             return selectedMessages.count > 0
         case #selector(self.clearMessages(_:)):
             return messagesTableView.numberOfRows > 0
+        case #selector(self.exportStandardMIDIFile(_:)):
+            return !(midiDocument?.savedMessages.isEmpty ?? true)
+        case #selector(self.showOnlySelectedTimeRange(_:)):
+            return selectedMessages.count > 0
+        case #selector(self.showAllTimes(_:)):
+            return timeRangeToShow != nil
+        case #selector(self.toggleReplaying(_:)):
+            if let menuItem = item as? NSMenuItem {
+                menuItem.title = (midiDocument?.isReplaying ?? false) ? Self.stopReplayingTitle : Self.startReplayingTitle
+            }
+            return midiDocument?.isReplaying ?? false || !(midiDocument?.savedMessages.isEmpty ?? true)
+        case #selector(self.showLatency(_:)):
+            return midiDocument != nil
+        case #selector(self.toggleRecordingToDisk(_:)):
+            if let menuItem = item as? NSMenuItem {
+                menuItem.title = (midiDocument?.isRecordingToDisk ?? false) ? Self.stopRecordingTitle : Self.startRecordingTitle
+            }
+            return midiDocument != nil
         default:
             return false
         }
@@ -395,6 +423,8 @@ extension MonitorWindowController {
             oneChannel = midiDocument.oneChannelToShow
         }
         oneChannelField.objectValue = NSNumber(value: oneChannel)
+
+        updateDisplayQuery()
     }
 
     @IBAction func toggleFilterShown(_ sender: Any?) {
@@ -526,6 +556,8 @@ extension MonitorWindowController: NSTableViewDataSource {
         guard let midiDocument else { return }
 
         midiDocument.clearSavedMessages()
+        midiDocument.resetPeakRates()
+        updateRateMeter()
     }
 
     @IBAction func setMaximumMessageCount(_ sender: Any?) {
@@ -578,7 +610,12 @@ extension MonitorWindowController: NSTableViewDataSource {
         guard let midiDocument else { return }
 
         let oldMessages = displayedMessages
-        let newMessages = midiDocument.savedMessages
+        let newMessages = if let displayQuery {
+            messagesMatchingDisplayQuery(displayQuery, in: midiDocument.messageIndex)
+        }
+        else {
+            midiDocument.savedMessages
+        }
         displayedMessages = newMessages
 
         // Keep the same messages selected, if possible
@@ -635,6 +672,374 @@ extension MonitorWindowController: NSTableViewDataSource {
 
 }
 
+extension MonitorWindowController {
+
+    // MARK: Display query
+
+    // The filter controls decide which incoming events are remembered. They also decide which of the remembered
+    // events are shown, along with an optional time range, so narrowing the filter narrows what's already in the list.
+    // The remembered events may be huge, so they're searched using the document's MessageIndex:
+    // a full search runs in the background and adds its results as they're found, and after that,
+    // only newly arrived events need to be searched.
+
+    @IBAction func showOnlySelectedTimeRange(_ sender: Any?) {
+        let timeStamps = selectedMessages.map(\.hostTimeStamp)
+        guard let earliest = timeStamps.min(), let latest = timeStamps.max() else { return }
+
+        timeRangeToShow = earliest ... latest
+        updateDisplayQuery()
+    }
+
+    @IBAction func showAllTimes(_ sender: Any?) {
+        timeRangeToShow = nil
+        updateDisplayQuery()
+    }
+
+    private func updateDisplayQuery() {
+        guard let midiDocument else { return }
+
+        var query: MessageIndex.Query? = MessageIndex.Query(typeMask: midiDocument.filterMask, channelMask: midiDocument.channelMask, timeRange: timeRangeToShow)
+        if query?.isUnrestricted ?? false {
+            query = nil
+        }
+        guard query != displayQuery else { return }
+
+        displayQuerySearch?.cancel()
+        displayQuerySearch = nil
+        displayQueryPositions = []
+        displayQuery = query
+
+        if let query {
+
+            let messageIndex = midiDocument.messageIndex
+            displayQueryEndPosition = messageIndex.endPosition
+            displayQuerySearch = messageIndex.search(query) { [weak self] positions, isFinished in
+                guard let self else { return }
+                self.displayQueryPositions += positions
+                if isFinished {
+                    self.displayQuerySearch = nil
+                }
+                self.updateMessages(scrollingToBottom: false)
+            }
+        }
+
+        updateMessages(scrollingToBottom: false)
+    }
+
+    private func messagesMatchingDisplayQuery(_ query: MessageIndex.Query, in messageIndex: MessageIndex) -> [Message] {
+        // Forget any events which are no longer remembered
+        if let firstRememberedIndex = displayQueryPositions.firstIndex(where: { $0 >= messageIndex.startPosition }) {
+            displayQueryPositions.removeFirst(firstRememberedIndex)
+        }
+        else {
+            displayQueryPositions.removeAll()
+        }
+
+        // Once the background search is done, search any events that arrived since it started
+        if displayQuerySearch == nil && displayQueryEndPosition < messageIndex.endPosition {
+            let newPositions = max(displayQueryEndPosition, messageIndex.startPosition) ..< messageIndex.endPosition
+            messageIndex.enumerateMatches(query, positions: newPositions) { positions in
+                displayQueryPositions += positions
+                return true
+            }
+            displayQueryEndPosition = messageIndex.endPosition
+        }
+
+        return displayQueryPositions.compactMap { messageIndex.message(atPosition: $0) }
+    }
+
+}
+
+extension MonitorWindowController {
+
+    // MARK: Recording to disk
+
+    private static let startRecordingTitle = String(localized: "Start Recording to Disk…", comment: "menu item to start recording events to disk")
+    private static let stopRecordingTitle = String(localized: "Stop Recording to Disk", comment: "menu item to stop recording events to disk")
+
+    @IBAction func toggleRecordingToDisk(_ sender: Any?) {
+        guard let midiDocument, let window else { return }
+
+        if midiDocument.isRecordingToDisk {
+            midiDocument.stopRecordingToDisk()
+            return
+        }
+
+        let openPanel = NSOpenPanel()
+        openPanel.canChooseFiles = false
+        openPanel.canChooseDirectories = true
+        openPanel.canCreateDirectories = true
+        openPanel.allowsMultipleSelection = false
+        openPanel.prompt = String(localized: "Record", comment: "button in panel to choose a folder to record events into")
+        openPanel.message = String(localized: "Choose a folder for the recorded events. A new file will be started when each file gets large.", comment: "message in panel to choose a folder to record events into")
+
+        openPanel.beginSheetModal(for: window) { response in
+            guard response == .OK, let directoryURL = openPanel.url else { return }
+
+            do {
+                try midiDocument.startRecordingToDisk(directoryURL: directoryURL)
+            }
+            catch {
+                midiDocument.presentError(error, modalFor: window, delegate: nil, didPresent: nil, contextInfo: nil)
+            }
+        }
+    }
+
+    func updateRecordingStatus() {
+        guard let window else { return }
+
+        if let statistics = midiDocument?.recordingStatistics {
+            let format = String(localized: "Recording to disk: %ld events, %@, %ld dropped", comment: "window subtitle while recording: event count, size, dropped event count")
+            window.subtitle = String.localizedStringWithFormat(format, statistics.recordedMessageCount, String.abbreviatedByteCount(statistics.recordedByteCount), statistics.droppedMessageCount)
+        }
+        else {
+            window.subtitle = ""
+        }
+    }
+
+}
+
+extension MonitorWindowController {
+
+    // MARK: Replaying
+
+    private static let startReplayingTitle = String(localized: "Replay Events…", comment: "menu item to replay events to a destination")
+    private static let stopReplayingTitle = String(localized: "Stop Replaying", comment: "menu item to stop replaying events")
+
+    @IBAction func toggleReplaying(_ sender: Any?) {
+        guard let midiDocument, let window else { return }
+
+        if midiDocument.isReplaying {
+            midiDocument.stopReplaying()
+            return
+        }
+
+        let destinations = midiDocument.replayDestinations
+        guard !destinations.isEmpty else {
+            let alert = NSAlert()
+            alert.messageText = String(localized: "There are no destinations to replay to.", comment: "message when replaying is impossible because there are no destinations")
+            alert.beginSheetModal(for: window, completionHandler: nil)
+            return
+        }
+
+        let destinationPopUp = NSPopUpButton(frame: .zero, pullsDown: false)
+        for destination in destinations {
+            destinationPopUp.addItem(withTitle: destination.displayName ?? "")
+            destinationPopUp.lastItem?.representedObject = destination
+        }
+
+        let speedPopUp = NSPopUpButton(frame: .zero, pullsDown: false)
+        for speed in [0.25, 0.5, 1.0, 2.0, 4.0] {
+            let format = String(localized: "%g× speed", comment: "replay speed menu item, like \"2× speed\"")
+            speedPopUp.addItem(withTitle: String.localizedStringWithFormat(format, speed))
+            speedPopUp.lastItem?.representedObject = speed
+        }
+        speedPopUp.selectItem(at: 2)
+
+        let loopCheckBox = NSButton(checkboxWithTitle: String(localized: "Loop", comment: "checkbox to replay events over and over"), target: nil, action: nil)
+
+        let selectedMessages = self.selectedMessages
+        let selectionCheckBox = NSButton(checkboxWithTitle: String(localized: "Only the selected events", comment: "checkbox to replay only the selected events"), target: nil, action: nil)
+        selectionCheckBox.isEnabled = selectedMessages.count > 1
+        selectionCheckBox.state = selectionCheckBox.isEnabled ? .on : .off
+
+        let stackView = NSStackView(views: [destinationPopUp, speedPopUp, loopCheckBox, selectionCheckBox])
+        stackView.orientation = .vertical
+        stackView.alignment = .leading
+        stackView.setFrameSize(stackView.fittingSize)
+
+        let alert = NSAlert()
+        alert.messageText = String(localized: "Replay Events", comment: "title of alert to replay events to a destination")
+        alert.informativeText = String(localized: "Events will be sent to the destination with the same timing they were received with.", comment: "explanation in alert to replay events")
+        alert.accessoryView = stackView
+        alert.addButton(withTitle: String(localized: "Replay", comment: "button to start replaying events"))
+        alert.addButton(withTitle: String(localized: "Cancel", comment: "Cancel button title"))
+        alert.beginSheetModal(for: window) { response in
+            guard response == .alertFirstButtonReturn,
+                  let destination = destinationPopUp.selectedItem?.representedObject as? Destination,
+                  let speed = speedPopUp.selectedItem?.representedObject as? Double
+            else { return }
+
+            let messages = selectionCheckBox.state == .on ? selectedMessages : midiDocument.savedMessages
+            midiDocument.startReplaying(messages, to: destination, speed: speed, loops: loopCheckBox.state == .on)
+        }
+    }
+
+}
+
+extension MonitorWindowController {
+
+    // MARK: Rate meter
+
+    // Shows the total rate of incoming events, before filtering. The tool tip breaks it down by source and type.
+
+    @objc private func updateRateMeter() {
+        guard let midiDocument else { return }
+
+        let sourceRates = midiDocument.sourceRates
+        let totalMessagesPerSecond = sourceRates.reduce(0) { $0 + $1.rate.messagesPerSecond }
+
+        let format = String(localized: "%.0f events/sec", comment: "rate meter: total events received per second")
+        rateMeterField.stringValue = sourceRates.isEmpty ? "" : String.localizedStringWithFormat(format, totalMessagesPerSecond)
+        rateMeterField.toolTip = sourceRates.isEmpty ? nil : sourceRates.map(Self.rateDescription).joined(separator: "\n\n")
+    }
+
+    private static func rateDescription(_ sourceRates: MessageRateMeter.SourceRates) -> String {
+        let sourceName = sourceRates.endpoint?.displayName ?? String(localized: "Unknown source", comment: "rate meter: name for events that didn't come from a known source")
+
+        let sourceFormat = String(localized: "%@: %.0f events/sec, %@/sec (peak %.0f events/sec, %@/sec)", comment: "rate meter tool tip: source name, events per second, bytes per second, peak events per second, peak bytes per second")
+        var lines = [String.localizedStringWithFormat(sourceFormat, sourceName, sourceRates.rate.messagesPerSecond, String.abbreviatedByteCount(Int(sourceRates.rate.bytesPerSecond)), sourceRates.peakRate.messagesPerSecond, String.abbreviatedByteCount(Int(sourceRates.peakRate.bytesPerSecond)))]
+
+        let typeFormat = String(localized: "    %@: %.0f events/sec", comment: "rate meter tool tip: event type, events per second")
+        for (typeName, rate) in sourceRates.ratesByType {
+            lines.append(String.localizedStringWithFormat(typeFormat, typeName, rate.messagesPerSecond))
+        }
+
+        return lines.joined(separator: "\n")
+    }
+
+}
+
+extension MonitorWindowController {
+
+    // MARK: Latency
+
+    @IBAction func showLatency(_ sender: Any?) {
+        guard let midiDocument, let window else { return }
+
+        let latencyMonitor = midiDocument.latencyMonitor
+
+        let textView = NSTextView(frame: NSRect(x: 0, y: 0, width: 560, height: 220))
+        textView.isEditable = false
+        textView.font = NSFont.monospacedSystemFont(ofSize: NSFont.smallSystemFontSize, weight: .regular)
+        textView.string = Self.latencySummary(latencyMonitor.sourceHistograms)
+        let scrollView = NSScrollView(frame: textView.frame)
+        scrollView.hasVerticalScroller = true
+        scrollView.borderType = .bezelBorder
+        scrollView.documentView = textView
+
+        let alert = NSAlert()
+        alert.messageText = String(localized: "Latency", comment: "title of latency statistics alert")
+        alert.informativeText = String(localized: "How long events took to get from their time stamps into MIDI Monitor, to be parsed, and to be processed, in milliseconds. If the time to queue and parse is long, the app was too busy to keep up.", comment: "explanation in latency statistics alert")
+        alert.accessoryView = scrollView
+        alert.addButton(withTitle: String(localized: "OK", comment: "OK button in latency statistics alert"))
+        alert.addButton(withTitle: String(localized: "Export…", comment: "button in latency statistics alert to save the histograms to a file"))
+        alert.addButton(withTitle: String(localized: "Reset", comment: "button in latency statistics alert to forget the measurements so far"))
+        alert.beginSheetModal(for: window) { response in
+            switch response {
+            case .alertSecondButtonReturn:
+                // Wait for the alert to go away before showing the save panel
+                DispatchQueue.main.async {
+                    self.exportLatency(latencyMonitor.csvData)
+                }
+            case .alertThirdButtonReturn:
+                latencyMonitor.reset()
+            default:
+                break
+            }
+        }
+    }
+
+    private func exportLatency(_ data: Data) {
+        guard let midiDocument, let window else { return }
+
+        let savePanel = NSSavePanel()
+        savePanel.allowedContentTypes = [.commaSeparatedText]
+        savePanel.allowsOtherFileTypes = true
+        savePanel.nameFieldStringValue = midiDocument.displayName + " " + String(localized: "Latency", comment: "added to the document name to make the name of an exported latency file") + ".csv"
+
+        savePanel.beginSheetModal(for: window) { response in
+            guard response == .OK, let url = savePanel.url else { return }
+
+            do {
+                try data.write(to: url, options: .atomic)
+            }
+            catch {
+                let alert = NSAlert(error: error)
+                alert.beginSheetModal(for: window, completionHandler: nil)
+            }
+        }
+    }
+
+    private static func latencySummary(_ sourceHistograms: [LatencyMonitor.SourceHistograms]) -> String {
+        guard !sourceHistograms.isEmpty else {
+            return String(localized: "No events have been received yet.", comment: "latency statistics when there is nothing to show")
+        }
+
+        func column(_ string: String, _ width: Int) -> String {
+            string.count >= width ? string + " " : string.padding(toLength: width, withPad: " ", startingAt: 0)
+        }
+
+        func milliseconds(_ nanoseconds: UInt64) -> String {
+            String(format: "%.3f", Double(nanoseconds) / 1_000_000)
+        }
+
+        let header = [
+            column(String(localized: "Stage", comment: "latency statistics column: stage"), 18),
+            column(String(localized: "Events", comment: "latency statistics column: number of events"), 10),
+            column(String(localized: "Median", comment: "latency statistics column: median"), 10),
+            column("99%", 10),
+            column("99.9%", 10),
+            String(localized: "Max", comment: "latency statistics column: maximum")
+        ].joined()
+
+        var lines: [String] = []
+        for source in sourceHistograms {
+            lines.append(source.endpoint?.displayName ?? String(localized: "Unknown source", comment: "rate meter: name for events that didn't come from a known source"))
+            lines.append("  " + header)
+            for stage in LatencyMonitor.Stage.allCases {
+                guard let histogram = source.histograms[stage], !histogram.isEmpty else { continue }
+                lines.append("  " + [
+                    column(stage.name, 18),
+                    column(String(histogram.totalCount), 10),
+                    column(milliseconds(histogram.value(atPercentile: 50)), 10),
+                    column(milliseconds(histogram.value(atPercentile: 99)), 10),
+                    column(milliseconds(histogram.value(atPercentile: 99.9)), 10),
+                    milliseconds(histogram.maxValue)
+                ].joined())
+            }
+            lines.append("")
+        }
+        return lines.joined(separator: "\n")
+    }
+
+}
+
+extension MonitorWindowController {
+
+    // MARK: Export
+
+    @IBAction func exportStandardMIDIFile(_ sender: Any?) {
+        guard let midiDocument, let window else { return }
+
+        let savePanel = NSSavePanel()
+        savePanel.allowedContentTypes = [.midi]
+        savePanel.allowsOtherFileTypes = true
+        savePanel.canSelectHiddenExtension = true
+        savePanel.nameFieldStringValue = midiDocument.displayName + ".mid"
+
+        savePanel.beginSheetModal(for: window) { response in
+            guard response == .OK, let url = savePanel.url else { return }
+
+            // Captures can be large, so write the file in the background, with the messages as they are now.
+            let messages = midiDocument.savedMessages
+            DispatchQueue.global(qos: .userInitiated).async {
+                do {
+                    try StandardMIDIFileWriter.writeFile(at: url) { writer in
+                        try writer.writeWithOriginalTiming(messages)
+                    }
+                }
+                catch {
+                    DispatchQueue.main.async {
+                        midiDocument.presentError(error, modalFor: window, delegate: nil, didPresent: nil, contextInfo: nil)
+                    }
+                }
+            }
+        }
+    }
+
+}
+
 extension MonitorWindowController {
 
     // MARK: Window settings
@@ -723,6 +1128,8 @@ extension MonitorWindowController: NSWindowDelegate {
         NotificationCenter.default.removeObserver(self, name: .displayPreferenceChanged, object: nil)
         nextMessagesRefreshTimer?.invalidate()
         nextMessagesRefreshTimer = nil
+        rateMeterTimer?.invalidate()
+        rateMeterTimer = nil
     }
 
     // NSWindowRestoration-related:
@@ -0,0 +1,59 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import SnoizeMIDI
+
+final class CalibrationTest {
+
+    // Runs the sysex speed calibrator against a SyntheticMIDIInterface whose loopback acts like a device
+    // that can only take in `bytesPerSecond`, and loses bytes when sysex is sent faster than that.
+    // The calibrator should never pick a speed faster than the device can take, no matter how the
+    // device's buffer lets a slightly faster speed get through now and then.
+
+    init(bytesPerSecond: Int) {
+        self.bytesPerSecond = bytesPerSecond
+    }
+
+    let bytesPerSecond: Int
+
+    func run() throws {
+        let syntheticInterface = SyntheticMIDIInterface()
+        syntheticInterface.loopsBack = true
+        syntheticInterface.loopbackBytesPerSecond = bytesPerSecond
+        let midiContext = MIDIContext(syntheticInterface: syntheticInterface)
+
+        guard let destination = midiContext.findDestination(name: "Synthetic Destination 1"),
+              let source = midiContext.findSource(name: "Synthetic Source 1")
+        else { throw CommandLineError.calibration("The synthetic device has no loopback") }
+
+        let calibrator = SysExSpeedCalibrator(destination: destination, source: source)
+        calibrator.trialHandler = { trial in
+            let bufferSize = trial.bufferSize > 0 ? "\(trial.bufferSize)" : "default"
+            print("\(trial.bytesPerSecond) bytes/sec, buffer size \(bufferSize): \(trial.succeeded ? "OK" : "Failed")")
+        }
+
+        var result: SysExSpeedCalibrator.Result?
+        calibrator.start { result = $0 }
+        while result == nil && RunLoop.main.run(mode: .default, before: .distantFuture) {
+            // The calibrator does its work on the main queue
+        }
+
+        guard let result else { return }
+        print("Lost \(syntheticInterface.loopbackLostByteCount) bytes in the loopback")
+        guard let calibratedBytesPerSecond = result.bytesPerSecond else {
+            throw CommandLineError.calibration("No speed worked, but the loopback takes \(bytesPerSecond) bytes/sec")
+        }
+
+        let bufferSize = result.bufferSize > 0 ? "\(result.bufferSize)" : "default"
+        print("Calibrated to \(calibratedBytesPerSecond) bytes/sec, buffer size \(bufferSize)")
+        if calibratedBytesPerSecond > bytesPerSecond {
+            throw CommandLineError.calibration("Calibrated faster than the loopback takes (\(bytesPerSecond) bytes/sec)")
+        }
+    }
+
+}
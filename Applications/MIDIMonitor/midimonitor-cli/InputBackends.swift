@@ -0,0 +1,170 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import SnoizeMIDI
+
+protocol InputBackend {
+
+    var inputStream: SnoizeMIDI.InputStream { get }
+
+    // Sends messages to the input stream's message destination, on the main queue, until the input ends.
+    // Some inputs never end.
+    func run() throws
+
+}
+
+final class CoreMIDIInputBackend: NSObject, InputBackend {
+
+    // Listens to CoreMIDI sources: the ones with the given names, or all of them.
+    // New sources are listened to as they appear, if no names were given.
+
+    init(midiContext: MIDIContext, sourceNames: [String]) throws {
+        for name in sourceNames where midiContext.findSource(name: name) == nil {
+            throw CommandLineError.unknownSource(name)
+        }
+
+        self.midiContext = midiContext
+        self.sourceNames = sourceNames
+        portInputStream = PortInputStream(midiContext: midiContext)
+        super.init()
+
+        selectSources()
+
+        NotificationCenter.default.addObserver(self, selector: #selector(self.midiObjectListChanged(_:)), name: .midiObjectListChanged, object: midiContext)
+    }
+
+    deinit {
+        NotificationCenter.default.removeObserver(self, name: .midiObjectListChanged, object: midiContext)
+    }
+
+    var inputStream: SnoizeMIDI.InputStream {
+        portInputStream
+    }
+
+    func run() throws {
+        RunLoop.main.run()
+    }
+
+    // MARK: Private
+
+    private let midiContext: MIDIContext
+    private let sourceNames: [String]
+    private let portInputStream: PortInputStream
+
+    private func selectSources() {
+        if sourceNames.isEmpty {
+            portInputStream.sources = Set(midiContext.sources)
+        }
+        else {
+            portInputStream.sources = Set(sourceNames.compactMap { midiContext.findSource(name: $0) })
+        }
+    }
+
+    @objc private func midiObjectListChanged(_ notification: Notification) {
+        if sourceNames.isEmpty {
+            selectSources()
+        }
+    }
+
+}
+
+final class ByteStreamInputBackend: InputBackend {
+
+    // Reads raw MIDI bytes from a file, or from standard input if the path is "-".
+    // No MIDI hardware or CoreMIDI setup is involved, so this works anywhere, and as fast as the bytes can be read.
+
+    init(midiContext: MIDIContext, path: String) throws {
+        if path == "-" {
+            fileDescriptor = STDIN_FILENO
+            name = "stdin"
+        }
+        else {
+            fileDescriptor = open(path, O_RDONLY)
+            guard fileDescriptor >= 0 else { throw CommandLineError.posix("open \(path)", errno) }
+            name = (path as NSString).lastPathComponent
+        }
+
+        byteStreamInputStream = ByteStreamInputStream(midiContext: midiContext, name: name)
+    }
+
+    deinit {
+        if fileDescriptor != STDIN_FILENO {
+            close(fileDescriptor)
+        }
+    }
+
+    var inputStream: SnoizeMIDI.InputStream {
+        byteStreamInputStream
+    }
+
+    func run() throws {
+        let buffer = UnsafeMutableRawPointer.allocate(byteCount: Self.bufferSize, alignment: 1)
+        defer { buffer.deallocate() }
+
+        while true {
+            let count = read(fileDescriptor, buffer, Self.bufferSize)
+            if count > 0 {
+                // The stream copies what it needs, so the buffer can be reused
+                byteStreamInputStream.takeBytes(Data(bytesNoCopy: buffer, count: count, deallocator: .none))
+            }
+            else if count == 0 {
+                break
+            }
+            else if errno != EINTR {
+                throw CommandLineError.posix("read \(name)", errno)
+            }
+        }
+
+        byteStreamInputStream.finish()
+    }
+
+    // MARK: Private
+
+    private let fileDescriptor: Int32
+    private let name: String
+    private let byteStreamInputStream: ByteStreamInputStream
+
+    private static let bufferSize = 64 * 1024
+
+}
+
+final class SyntheticInputBackend: InputBackend {
+
+    // Listens to a SyntheticMIDIInterface's sources while it sends a fixed amount of generated traffic,
+    // through the same CoreMIDI code paths as real sources, but with no MIDI hardware.
+    // The same options always give the same messages, so runs can be compared.
+
+    init(midiContext: MIDIContext, syntheticInterface: SyntheticMIDIInterface, traffic: SyntheticMIDIInterface.Traffic) {
+        self.syntheticInterface = syntheticInterface
+        self.traffic = traffic
+        portInputStream = PortInputStream(midiContext: midiContext)
+        portInputStream.sources = Set(midiContext.sources)
+    }
+
+    var inputStream: SnoizeMIDI.InputStream {
+        portInputStream
+    }
+
+    func run() throws {
+        var finished = false
+        syntheticInterface.start([traffic]) {
+            finished = true
+        }
+
+        while !finished && RunLoop.main.run(mode: .default, before: .distantFuture) {
+            // Keep handling the messages that the stream passes along on the main queue
+        }
+    }
+
+    // MARK: Private
+
+    private let syntheticInterface: SyntheticMIDIInterface
+    private let traffic: SyntheticMIDIInterface.Traffic
+    private let portInputStream: PortInputStream
+
+}
@@ -0,0 +1,194 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import SnoizeMIDI
+
+class StandardOutputSink: NSObject, MessageDestination {
+
+    // Writes a line for each message to standard output.
+    //
+    // Each batch of messages is formatted into one reused buffer and written with one call,
+    // then flushed, so a reader at the other end of a pipe sees messages as soon as they arrive.
+
+    // MARK: MessageDestination
+
+    func takeMIDIMessages(_ messages: [Message]) {
+        lineBytes.removeAll(keepingCapacity: true)
+        for message in messages {
+            appendLine(message)
+        }
+
+        lineBytes.withUnsafeBufferPointer { buffer in
+            _ = fwrite(buffer.baseAddress, 1, buffer.count, stdout)
+        }
+        fflush(stdout)
+    }
+
+    // MARK: Subclasses
+
+    var lineBytes: [UInt8] = []
+
+    func appendLine(_ message: Message) {
+        // Subclasses must override
+    }
+
+    func append(_ string: String) {
+        lineBytes.append(contentsOf: string.utf8)
+    }
+
+}
+
+final class TextSink: StandardOutputSink {
+
+    // The same columns as MIDI Monitor's window, formatted the same way, separated by tabs
+
+    override func appendLine(_ message: Message) {
+        append(message.timeStampForDisplay)
+        lineBytes.append(Self.tab)
+        append(message.originatingEndpointForDisplay)
+        lineBytes.append(Self.tab)
+        append(message.typeForDisplay)
+        lineBytes.append(Self.tab)
+        append(message.channelForDisplay)
+        lineBytes.append(Self.tab)
+        append(message.dataForDisplay)
+        lineBytes.append(Self.newline)
+    }
+
+    private static let tab = UInt8(ascii: "\t")
+    private static let newline = UInt8(ascii: "\n")
+
+}
+
+final class NDJSONSink: StandardOutputSink {
+
+    // One JSON object per line, like:
+    //   {"time_ns":1234567890,"source":"Keyboard","type":"note-on","channel":1,"bytes":"903c40"}
+    //
+    // This skips the display formatting that the text output does, which is much of the cost of showing
+    // a message: numbers and the message's bytes are written straight into the output buffer,
+    // and source names are escaped once per source.
+
+    deinit {
+        messageBytes.deallocate()
+    }
+
+    override func appendLine(_ message: Message) {
+        append("{\"time_ns\":")
+        append(String(SMConvertHostTimeToNanos(message.hostTimeStamp)))
+
+        if let endpoint = message.originatingEndpoint {
+            append(",\"source\":")
+            lineBytes.append(contentsOf: escapedSourceName(endpoint))
+        }
+
+        append(",\"type\":\"")
+        append(message.messageType.commandLineName ?? "unknown")
+        lineBytes.append(Self.quote)
+
+        if let voiceMessage = message as? VoiceMessage {
+            append(",\"channel\":")
+            append(String(voiceMessage.channel))
+        }
+
+        append(",\"bytes\":\"")
+        appendHexBytes(message)
+        append("\"}\n")
+    }
+
+    // MARK: Private
+
+    private var escapedSourceNames: [ObjectIdentifier: [UInt8]] = [:]
+    private var messageBytes = UnsafeMutablePointer<UInt8>.allocate(capacity: 256)
+    private var messageBytesCapacity = 256
+
+    private static let quote = UInt8(ascii: "\"")
+    private static let hexDigits = Array("0123456789abcdef".utf8)
+
+    private func escapedSourceName(_ endpoint: Endpoint) -> [UInt8] {
+        let key = ObjectIdentifier(endpoint)
+        if let escaped = escapedSourceNames[key] {
+            return escaped
+        }
+
+        var escaped = [Self.quote]
+        for scalar in (endpoint.displayName ?? "").unicodeScalars {
+            switch scalar {
+            case "\"", "\\":
+                escaped.append(UInt8(ascii: "\\"))
+                escaped.append(contentsOf: String(scalar).utf8)
+            case _ where scalar.value < 0x20:
+                escaped.append(contentsOf: String(format: "\\u%04x", scalar.value).utf8)
+            default:
+                escaped.append(contentsOf: String(scalar).utf8)
+            }
+        }
+        escaped.append(Self.quote)
+
+        escapedSourceNames[key] = escaped
+        return escaped
+    }
+
+    private func appendHexBytes(_ message: Message) {
+        let length = message.fullDataLength
+        if length > messageBytesCapacity {
+            messageBytes.deallocate()
+            messageBytesCapacity = length
+            messageBytes = UnsafeMutablePointer<UInt8>.allocate(capacity: messageBytesCapacity)
+        }
+
+        let count = message.copyFullData(to: messageBytes)
+        lineBytes.reserveCapacity(lineBytes.count + count * 2)
+        for index in 0 ..< count {
+            let byte = messageBytes[index]
+            lineBytes.append(Self.hexDigits[Int(byte >> 4)])
+            lineBytes.append(Self.hexDigits[Int(byte & 0x0F)])
+        }
+    }
+
+}
+
+extension Message.TypeMask {
+
+    // Names for each type, in the order of their bits
+    static let commandLineNames = [
+        "note-on", "note-off", "aftertouch", "control", "program", "channel-pressure", "pitch-wheel",
+        "time-code", "song-position", "song-select", "tune-request",
+        "clock", "start", "stop", "continue", "active-sense", "reset",
+        "sysex",
+        "invalid"
+    ]
+
+    // Names for groups of types
+    static let commandLineGroups: [String: Message.TypeMask] = [
+        "voice": [.noteOn, .noteOff, .aftertouch, .control, .program, .channelPressure, .pitchWheel],
+        "common": [.timeCode, .songPositionPointer, .songSelect, .tuneRequest],
+        "realtime": [.clock, .start, .stop, .continue, .activeSense, .reset],
+        "all": .all
+    ]
+
+    init?(commandLineName name: String) {
+        if let index = Self.commandLineNames.firstIndex(of: name) {
+            self.init(rawValue: 1 << index)
+        }
+        else if let group = Self.commandLineGroups[name] {
+            self = group
+        }
+        else {
+            return nil
+        }
+    }
+
+    // For a mask with exactly one type in it
+    var commandLineName: String? {
+        guard rawValue.nonzeroBitCount == 1 else { return nil }
+        let index = rawValue.trailingZeroBitCount
+        return index < Self.commandLineNames.count ? Self.commandLineNames[index] : nil
+    }
+
+}
@@ -0,0 +1,264 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import SnoizeMIDI
+
+// midimonitor-cli shows the MIDI that MIDI Monitor would show, without any UI.
+//
+// Messages go from an input backend, through a MessageFilter, to a sink: text or NDJSON on standard output,
+// or capture files. The input can be CoreMIDI sources, or raw MIDI bytes from a file or a pipe.
+// Raw bytes need no MIDI hardware, so the same parsing and filtering can be run on a build machine,
+// or benchmarked by feeding it a large file. Synthetic input generates traffic through the CoreMIDI code paths,
+// without CoreMIDI.
+// --calibrate checks the sysex speed calibrator against a synthetic device that loses sysex sent too fast.
+
+enum CommandLineError: Error, CustomStringConvertible {
+    case usage(String)
+    case unknownSource(String)
+    case posix(String, Int32)
+    case noCoreMIDI
+    case calibration(String)
+
+    var description: String {
+        switch self {
+        case .usage(let problem):
+            return problem
+        case .unknownSource(let name):
+            return "There is no MIDI source named \"\(name)\". Use --list-sources to see them."
+        case .posix(let operation, let code):
+            return "\(operation): \(String(cString: strerror(code)))"
+        case .noCoreMIDI:
+            return "Couldn't connect to CoreMIDI."
+        case .calibration(let problem):
+            return problem
+        }
+    }
+}
+
+struct Options {
+
+    enum Output {
+        case text
+        case ndjson
+        case capture(URL)
+    }
+
+    var inputPath: String?      // nil for CoreMIDI
+    var syntheticPattern: SyntheticMIDIInterface.Traffic.Pattern?
+    var syntheticCount = 10000
+    var syntheticRate = 0.0
+    var sourceNames: [String] = []
+    var output = Output.text
+    var typeMask = Message.TypeMask.all
+    var channelMask = VoiceMessage.ChannelMask.all
+    var listSources = false
+    var calibrationBytesPerSecond: Int?
+
+    static let usage = """
+        usage: midimonitor-cli [options]
+
+          --input FILE          read raw MIDI bytes from FILE, or from standard input if FILE is "-",
+                                instead of from CoreMIDI sources
+          --synthetic PATTERN   generate traffic instead of reading it: clock, sweep, sysex, or bursts
+          --count N             how many messages (or bursts) to generate (default: 10000)
+          --rate N              how many to generate per second (default: as fast as possible)
+          --source NAME         listen to the CoreMIDI source named NAME (may be repeated; default: all sources)
+          --list-sources        print the names of the CoreMIDI sources and exit
+          --format text|ndjson  how to write messages to standard output (default: text)
+          --capture DIR         record messages to capture files in DIR, instead of writing them to standard output
+          --types LIST          only show these types of messages (comma separated; default: all)
+          --exclude LIST        don't show these types of messages
+          --channels LIST       only show voice messages on these channels, 1-16 (comma separated; default: all)
+          --calibrate RATE      calibrate the sysex speed of a synthetic loopback that loses bytes sent faster than
+                                RATE bytes/sec, and fail if the calibrated speed is faster than that
+
+        Types: \(Message.TypeMask.commandLineNames.joined(separator: ", ")),
+               or the groups \(Message.TypeMask.commandLineGroups.keys.sorted().joined(separator: ", "))
+        """
+
+    init(arguments: [String]) throws {
+        var arguments = arguments[...]
+
+        func value(_ option: String) throws -> String {
+            guard let value = arguments.popFirst() else { throw CommandLineError.usage("\(option) needs a value") }
+            return value
+        }
+
+        func typeMask(_ option: String) throws -> Message.TypeMask {
+            try value(option).split(separator: ",").reduce(into: Message.TypeMask()) { mask, name in
+                guard let namedMask = Message.TypeMask(commandLineName: String(name)) else {
+                    throw CommandLineError.usage("Unknown message type \"\(name)\"")
+                }
+                mask.formUnion(namedMask)
+            }
+        }
+
+        while let argument = arguments.popFirst() {
+            switch argument {
+            case "--input":
+                inputPath = try value(argument)
+            case "--synthetic":
+                switch try value(argument) {
+                case "clock":
+                    syntheticPattern = .clock
+                case "sweep":
+                    syntheticPattern = .controlSweep(channel: 0, controller: 1)
+                case "sysex":
+                    syntheticPattern = .sysEx(length: 1024 * 1024)
+                case "bursts":
+                    syntheticPattern = .bursts(size: 64)
+                case let pattern:
+                    throw CommandLineError.usage("Unknown synthetic pattern \"\(pattern)\"")
+                }
+            case "--count":
+                guard let count = Int(try value(argument)), count >= 0 else { throw CommandLineError.usage("--count needs a number") }
+                syntheticCount = count
+            case "--rate":
+                guard let rate = Double(try value(argument)), rate >= 0 else { throw CommandLineError.usage("--rate needs a number") }
+                syntheticRate = rate
+            case "--source":
+                sourceNames.append(try value(argument))
+            case "--list-sources":
+                listSources = true
+            case "--format":
+                switch try value(argument) {
+                case "text":
+                    output = .text
+                case "ndjson":
+                    output = .ndjson
+                case let format:
+                    throw CommandLineError.usage("Unknown format \"\(format)\"")
+                }
+            case "--capture":
+                output = .capture(URL(fileURLWithPath: try value(argument), isDirectory: true))
+            case "--types":
+                typeMask = try typeMask(argument)
+            case "--exclude":
+                typeMask.subtract(try typeMask(argument))
+            case "--channels":
+                channelMask = try value(argument).split(separator: ",").reduce(into: VoiceMessage.ChannelMask()) { mask, string in
+                    guard let channel = Int(string), (1...16).contains(channel) else {
+                        throw CommandLineError.usage("Channels must be from 1 to 16")
+                    }
+                    mask.formUnion(VoiceMessage.ChannelMask(channel: channel))
+                }
+            case "--calibrate":
+                guard let rate = Int(try value(argument)), rate > 0 else { throw CommandLineError.usage("--calibrate needs a number") }
+                calibrationBytesPerSecond = rate
+            case "--help", "-h":
+                print(Self.usage)
+                exit(0)
+            default:
+                throw CommandLineError.usage("Unknown option \"\(argument)\"")
+            }
+        }
+
+        if (inputPath != nil || syntheticPattern != nil) && !sourceNames.isEmpty {
+            throw CommandLineError.usage("--source can't be used with --input or --synthetic")
+        }
+        if inputPath != nil && syntheticPattern != nil {
+            throw CommandLineError.usage("--input can't be used with --synthetic")
+        }
+        if calibrationBytesPerSecond != nil && (inputPath != nil || syntheticPattern != nil || !sourceNames.isEmpty) {
+            throw CommandLineError.usage("--calibrate can't be used with --input, --synthetic, or --source")
+        }
+    }
+
+}
+
+func run(_ options: Options) throws {
+    if let calibrationBytesPerSecond = options.calibrationBytesPerSecond {
+        try CalibrationTest(bytesPerSecond: calibrationBytesPerSecond).run()
+        fflush(stdout)
+        return
+    }
+
+    // InputStream needs a MIDIContext even when it doesn't read from CoreMIDI
+    let syntheticInterface = options.syntheticPattern.map { _ in SyntheticMIDIInterface() }
+    let midiContext = syntheticInterface.map { MIDIContext(syntheticInterface: $0) } ?? MIDIContext()
+
+    if options.listSources {
+        guard midiContext.connectedToCoreMIDI else { throw CommandLineError.noCoreMIDI }
+        for source in midiContext.sources {
+            print(source.displayName ?? "")
+        }
+        return
+    }
+
+    let backend: InputBackend
+    if let inputPath = options.inputPath {
+        backend = try ByteStreamInputBackend(midiContext: midiContext, path: inputPath)
+    }
+    else if let syntheticInterface, let pattern = options.syntheticPattern {
+        let traffic = SyntheticMIDIInterface.Traffic(pattern: pattern, count: options.syntheticCount, rate: options.syntheticRate)
+        backend = SyntheticInputBackend(midiContext: midiContext, syntheticInterface: syntheticInterface, traffic: traffic)
+    }
+    else {
+        guard midiContext.connectedToCoreMIDI else { throw CommandLineError.noCoreMIDI }
+        backend = try CoreMIDIInputBackend(midiContext: midiContext, sourceNames: options.sourceNames)
+    }
+
+    let messageFilter = MessageFilter()
+    messageFilter.filterMask = options.typeMask
+    messageFilter.channelMask = options.channelMask
+
+    let sink: MessageDestination
+    var recorder: MessageRecorder?
+    switch options.output {
+    case .text:
+        sink = TextSink()
+    case .ndjson:
+        sink = NDJSONSink()
+    case .capture(let directoryURL):
+        let messageRecorder = MessageRecorder(directoryURL: directoryURL, baseName: "midimonitor-cli")
+        try messageRecorder.start()
+        sink = messageRecorder
+        recorder = messageRecorder
+    }
+
+    // The stream and the filter only hold their destinations weakly
+    backend.inputStream.messageDestination = messageFilter
+    messageFilter.messageDestination = sink
+
+    // Listening to CoreMIDI only ends when interrupted, so handle that on the main queue, and finish writing
+    // capture files. (Reading bytes keeps the main queue busy until the input ends, so leave the signals alone.)
+    var signalSources: [DispatchSourceSignal] = []
+    for signalNumber in [SIGINT, SIGTERM] where options.inputPath == nil && options.syntheticPattern == nil {
+        signal(signalNumber, SIG_IGN)
+        let signalSource = DispatchSource.makeSignalSource(signal: signalNumber, queue: .main)
+        signalSource.setEventHandler {
+            recorder?.stop()
+            fflush(stdout)
+            exit(0)
+        }
+        signalSource.resume()
+        signalSources.append(signalSource)
+    }
+
+    try withExtendedLifetime((messageFilter, sink, signalSources)) {
+        try backend.run()
+    }
+
+    recorder?.stop()
+    fflush(stdout)
+}
+
+do {
+    try run(Options(arguments: Array(CommandLine.arguments.dropFirst())))
+}
+catch let error as CommandLineError {
+    FileHandle.standardError.write(Data("midimonitor-cli: \(error)\n".utf8))
+    if case .usage = error {
+        FileHandle.standardError.write(Data((Options.usage + "\n").utf8))
+    }
+    exit(1)
+}
+catch {
+    FileHandle.standardError.write(Data("midimonitor-cli: \(error.localizedDescription)\n".utf8))
+    exit(1)
+}
@@ -47,25 +47,37 @@ class CombinationOutputStream: NSObject, MessageDestination {
     }
 
     var selectedDestination: OutputStreamDestination? {
+        get {
+            selectedDestinations.first
+        }
+        set {
+            selectedDestinations = newValue.map { [$0] } ?? []
+        }
+    }
+
+    // Several port destinations may be selected at once. Then each message is sent to all of them
+    // at the same time, each at its own speed. The first one is the one shown as selected.
+    var selectedDestinations: [OutputStreamDestination] {
         get {
             if virtualStream != nil {
-                return virtualStreamDestination
+                return [virtualStreamDestination]
             }
-            else if portStream != nil {
-                return portStream!.destinations.first
+            else if let portStream {
+                // Keep the order they were selected in. Any others are replacements for ones that were selected.
+                let orderedDestinations = selectedPortDestinations.filter { portStream.destinations.contains($0) }
+                return orderedDestinations + portStream.destinations.filter { !orderedDestinations.contains($0) }
             }
             else {
-                return nil
+                return []
             }
         }
         set {
-            if newValue != nil {
-                if let newDestination = newValue as? Destination {
-                    selectDestination(newDestination)
-                }
-                else {
-                    selectDestination(nil) // Use the virtual stream
-                }
+            let newPortDestinations = newValue.compactMap { $0 as? Destination }
+            if !newPortDestinations.isEmpty {
+                selectDestinations(newPortDestinations)
+            }
+            else if !newValue.isEmpty {
+                selectDestinations([]) // Use the virtual stream
             }
             else {
                 // Deselect everything
@@ -82,13 +94,17 @@ class CombinationOutputStream: NSObject, MessageDestination {
     var persistentSettings: [String: Any]? {
         var persistentSettings: [String: Any] = [:]
 
-        if let stream = portStream {
-            if let destination = stream.destinations.first {
+        if portStream != nil {
+            let destinations = selectedDestinations.compactMap { $0 as? Destination }
+            if let destination = destinations.first {
                 persistentSettings["portEndpointUniqueID"] = NSNumber(value: destination.uniqueID)
                 if let name = destination.name {
                     persistentSettings["portEndpointName"] = name
                 }
             }
+            if destinations.count > 1 {
+                persistentSettings["additionalPortEndpointUniqueIDs"] = destinations.dropFirst().map { NSNumber(value: $0.uniqueID) }
+            }
         }
         else if let stream = virtualStream {
             persistentSettings["virtualEndpointUniqueID"] = NSNumber(value: stream.endpoint.uniqueID)
@@ -101,13 +117,17 @@ class CombinationOutputStream: NSObject, MessageDestination {
         // If the endpoint indicated by the persistent settings couldn't be found, its name is returned
 
         if let number = settings["portEndpointUniqueID"] as? NSNumber {
+            // Additional destinations that can't be found are just left out
+            let additionalNumbers = settings["additionalPortEndpointUniqueIDs"] as? [NSNumber] ?? []
+            let additionalEndpoints = additionalNumbers.compactMap { midiContext.findDestination(uniqueID: $0.int32Value) }
+
             if let endpoint = midiContext.findDestination(uniqueID: number.int32Value) {
-                selectDestination(endpoint)
+                selectDestinations([endpoint] + additionalEndpoints)
             }
             else if let endpointName = settings["portEndpointName"] as? String {
                 // Maybe an endpoint with this name still exists, but with a different unique ID.
                 if let endpoint = midiContext.findDestination(name: endpointName) {
-                    selectDestination(endpoint)
+                    selectDestinations([endpoint] + additionalEndpoints)
                 }
                 else {
                     return endpointName
@@ -120,7 +140,7 @@ class CombinationOutputStream: NSObject, MessageDestination {
         else if let number = settings["virtualEndpointUniqueID"] as? NSNumber {
             removeVirtualStream()
             virtualEndpointUniqueID = number.int32Value
-            selectDestination(nil) // Use the virtual stream
+            selectDestinations([]) // Use the virtual stream
         }
 
         return nil
@@ -153,18 +173,25 @@ class CombinationOutputStream: NSObject, MessageDestination {
         }
     }
 
+    // Overrides customSysExBufferSize for particular destinations, by unique ID
+    var destinationCustomSysExBufferSizes: [MIDIUniqueID: Int] = [:] {
+        didSet {
+            portStream?.destinationCustomSysExBufferSizes = destinationCustomSysExBufferSizes
+        }
+    }
+
     func cancelPendingSysExSendRequests() {
         if stream == portStream {
             portStream?.cancelPendingSysExSendRequests()
         }
     }
 
-    var currentSysExSendRequest: SysExSendRequest? {
+    var currentSysExSendRequests: [SysExSendRequest] {
         if stream == portStream {
-            return portStream?.pendingSysExSendRequests.first
+            return portStream?.pendingSysExSendRequests ?? []
         }
         else {
-            return nil
+            return []
         }
     }
 
@@ -189,13 +216,17 @@ class CombinationOutputStream: NSObject, MessageDestination {
     private let virtualStreamDestination: SingleOutputStreamDestination
     private var virtualEndpointUniqueID: MIDIUniqueID = 0
 
-    private func selectDestination(_ destination: Destination?) {
-        if let destination {
+    // The port destinations, in the order they were selected
+    private var selectedPortDestinations: [Destination] = []
+
+    private func selectDestinations(_ destinations: [Destination]) {
+        if !destinations.isEmpty {
             // Set up the port stream
             if portStream == nil {
                 createPortStream()
             }
-            portStream?.destinations = Set([destination])
+            selectedPortDestinations = destinations
+            portStream?.destinations = Set(destinations)
 
             removeVirtualStream()
         }
@@ -216,12 +247,14 @@ class CombinationOutputStream: NSObject, MessageDestination {
         stream.ignoresTimeStamps = ignoresTimeStamps
         stream.sendsSysExAsynchronously = sendsSysExAsynchronously
         stream.customSysExBufferSize = customSysExBufferSize
+        stream.destinationCustomSysExBufferSizes = destinationCustomSysExBufferSizes
         stream.delegate = self
         portStream = stream
     }
 
     private func removePortStream() {
         portStream = nil
+        selectedPortDestinations = []
     }
 
     private func createVirtualStream() {
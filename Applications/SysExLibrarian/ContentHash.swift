@@ -0,0 +1,213 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import SnoizeMIDI
+
+struct ContentHash: Hashable {
+
+    // A 128-bit hash of an entry's sysex messages, used to find entries with identical contents.
+    // It's fast, but not cryptographic.
+
+    let low: UInt64
+    let high: UInt64
+
+    init(low: UInt64, high: UInt64) {
+        self.low = low
+        self.high = high
+    }
+
+    // 16 bytes, little-endian, low half first
+    init?(data: Data) {
+        guard data.count == 16 else { return nil }
+        var values: (UInt64, UInt64) = (0, 0)
+        withUnsafeMutableBytes(of: &values) { _ = data.copyBytes(to: $0) }
+        low = UInt64(littleEndian: values.0)
+        high = UInt64(littleEndian: values.1)
+    }
+
+    var data: Data {
+        var values = (low.littleEndian, high.littleEndian)
+        return withUnsafeBytes(of: &values) { Data($0) }
+    }
+
+    // The hash of the messages' bytes, as they would be saved in a .syx file
+    init(messages: [SystemExclusiveMessage]) {
+        var hasher = ContentHasher()
+        for message in messages {
+            message.withFullMessageBuffers { buffers in
+                for buffer in buffers {
+                    hasher.update(buffer)
+                }
+            }
+        }
+        self = hasher.finalize()
+    }
+
+}
+
+struct ContentHasher {
+
+    // MurmurHash3, x64 128-bit variant, computed incrementally:
+    // bytes may be passed to update() in pieces of any size, and give the same result
+    // as if they were passed all at once.
+
+    init(seed: UInt64 = 0) {
+        h1 = seed
+        h2 = seed
+    }
+
+    mutating func update(_ bytes: UnsafeRawBufferPointer) {
+        var offset = 0
+        let count = bytes.count
+        totalByteCount &+= UInt64(count)
+
+        // Fill up a partial block left over from last time
+        if pendingByteCount > 0 {
+            let copyStart = pendingByteCount
+            let copyCount = min(16 - copyStart, count)
+            withUnsafeMutableBytes(of: &pendingBlock) { pendingBytes in
+                UnsafeMutableRawBufferPointer(rebasing: pendingBytes[copyStart ..< copyStart + copyCount])
+                    .copyMemory(from: UnsafeRawBufferPointer(rebasing: bytes[0 ..< copyCount]))
+            }
+            pendingByteCount += copyCount
+            offset = copyCount
+
+            guard pendingByteCount == 16 else { return }
+            mixBlock(UInt64(littleEndian: pendingBlock.0), UInt64(littleEndian: pendingBlock.1))
+            pendingByteCount = 0
+        }
+
+        // Whole blocks straight from the input
+        while count - offset >= 16 {
+            let k1 = UInt64(littleEndian: bytes.loadUnaligned(fromByteOffset: offset, as: UInt64.self))
+            let k2 = UInt64(littleEndian: bytes.loadUnaligned(fromByteOffset: offset + 8, as: UInt64.self))
+            mixBlock(k1, k2)
+            offset += 16
+        }
+
+        // Save the rest for next time
+        if offset < count {
+            pendingBlock = (0, 0)
+            withUnsafeMutableBytes(of: &pendingBlock) { pendingBytes in
+                pendingBytes.copyMemory(from: UnsafeRawBufferPointer(rebasing: bytes[offset ..< count]))
+            }
+            pendingByteCount = count - offset
+        }
+    }
+
+    mutating func update(_ data: Data) {
+        data.withUnsafeBytes { update($0) }
+    }
+
+    func finalize() -> ContentHash {
+        var h1 = self.h1
+        var h2 = self.h2
+
+        if pendingByteCount > 0 {
+            // The unused bytes of the pending block are zero, so they don't affect the result
+            var k1 = UInt64(littleEndian: pendingBlock.0)
+            var k2 = UInt64(littleEndian: pendingBlock.1)
+
+            if pendingByteCount > 8 {
+                k2 &*= Self.c2
+                k2 = Self.rotateLeft(k2, 33)
+                k2 &*= Self.c1
+                h2 ^= k2
+            }
+
+            k1 &*= Self.c1
+            k1 = Self.rotateLeft(k1, 31)
+            k1 &*= Self.c2
+            h1 ^= k1
+        }
+
+        h1 ^= totalByteCount
+        h2 ^= totalByteCount
+        h1 &+= h2
+        h2 &+= h1
+        h1 = Self.finalMix(h1)
+        h2 = Self.finalMix(h2)
+        h1 &+= h2
+        h2 &+= h1
+
+        return ContentHash(low: h1, high: h2)
+    }
+
+    // MARK: Private
+
+    private var h1: UInt64
+    private var h2: UInt64
+    private var totalByteCount: UInt64 = 0
+    private var pendingBlock: (UInt64, UInt64) = (0, 0)
+    private var pendingByteCount = 0
+
+    private static let c1: UInt64 = 0x87C3_7B91_1142_53D5
+    private static let c2: UInt64 = 0x4CF5_AD43_2745_937F
+
+    private mutating func mixBlock(_ block1: UInt64, _ block2: UInt64) {
+        var k1 = block1
+        var k2 = block2
+
+        k1 &*= Self.c1
+        k1 = Self.rotateLeft(k1, 31)
+        k1 &*= Self.c2
+        h1 ^= k1
+
+        h1 = Self.rotateLeft(h1, 27)
+        h1 &+= h2
+        h1 = h1 &* 5 &+ 0x52DC_E729
+
+        k2 &*= Self.c2
+        k2 = Self.rotateLeft(k2, 33)
+        k2 &*= Self.c1
+        h2 ^= k2
+
+        h2 = Self.rotateLeft(h2, 31)
+        h2 &+= h1
+        h2 = h2 &* 5 &+ 0x3849_5AB5
+    }
+
+    private static func rotateLeft(_ value: UInt64, _ shift: UInt64) -> UInt64 {
+        (value << shift) | (value >> (64 - shift))
+    }
+
+    private static func finalMix(_ value: UInt64) -> UInt64 {
+        var k = value
+        k ^= k >> 33
+        k &*= 0xFF51_AFD7_ED55_8CCD
+        k ^= k >> 33
+        k &*= 0xC4CE_B9FE_1A85_EC53
+        k ^= k >> 33
+        return k
+    }
+
+}
+
+struct ContentHashFileStamp: Equatable {
+
+    // The size and modification time of a file when its contents were hashed.
+    // If either has changed since, the hash can't be trusted to match the file.
+
+    let size: Int64
+    let modificationNanoseconds: Int64     // since 1970
+
+    init(size: Int64, modificationNanoseconds: Int64) {
+        self.size = size
+        self.modificationNanoseconds = modificationNanoseconds
+    }
+
+    // Returns nil if the file can't be found
+    init?(fileAtPath path: String) {
+        var fileStatus = stat()
+        guard stat(path, &fileStatus) == 0 else { return nil }
+
+        size = Int64(fileStatus.st_size)
+        modificationNanoseconds = Int64(fileStatus.st_mtimespec.tv_sec) * 1_000_000_000 + Int64(fileStatus.st_mtimespec.tv_nsec)
+    }
+
+}
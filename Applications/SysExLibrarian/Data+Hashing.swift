@@ -10,50 +10,89 @@ import CommonCrypto
 
 extension Data {
 
-    // swiftlint:disable redundant_void_return
-    // (Yes, I can remove the four instances of `-> Void` below, but then that produces a real warning.
-    //  SwiftLint is being overly sensitive.)
-
     var md5HexHash: String {
-        let digestLength = Int(CC_MD5_DIGEST_LENGTH)
-        var digest = [UInt8](repeating: 0, count: digestLength)
+        var hasher = MD5Hasher()
+        hasher.update(self)
+        return hasher.finalizeHex()
+    }
+
+    var sha1HexHash: String {
+        var hasher = SHA1Hasher()
+        hasher.update(self)
+        return hasher.finalizeHex()
+    }
+
+}
 
-        withUnsafeBytes { (selfBufferPtr: UnsafeRawBufferPointer) -> Void in
-            digest.withUnsafeMutableBufferPointer { ( digestBufferPtr: inout UnsafeMutableBufferPointer<UInt8>) -> Void in
-                // Note: This generates a warning about MD5 being deprecated because it's cryptographically broken.
-                // We aren't using it for cryptography, though.
-                // Sadly, there is STILL no way to silence deprecation warnings in Swift:
-                // https://forums.swift.org/t/swift-should-allow-for-suppression-of-warnings-especially-those-that-come-from-objective-c/19216/72
-                CC_MD5(selfBufferPtr.baseAddress, CC_LONG(self.count), digestBufferPtr.baseAddress)
-            }
-        }
+// Hashers that take their input a piece at a time, so the input never needs to be in one buffer.
 
-        var result = ""
-        for index in 0 ..< digestLength {
-            result += String(format: "%02x", digest[index])
-        }
+struct MD5Hasher {
 
-        return result
+    init() {
+        CC_MD5_Init(&context)
     }
 
-    var sha1HexHash: String {
-        let digestLength = Int(CC_SHA1_DIGEST_LENGTH)
-        var digest = [UInt8](repeating: 0, count: digestLength)
+    mutating func update(_ bytes: UnsafeRawBufferPointer) {
+        // Note: These generate warnings about MD5 being deprecated because it's cryptographically broken.
+        // We aren't using it for cryptography, though.
+        // Sadly, there is STILL no way to silence deprecation warnings in Swift:
+        // https://forums.swift.org/t/swift-should-allow-for-suppression-of-warnings-especially-those-that-come-from-objective-c/19216/72
+        forEachChunk(of: bytes) { CC_MD5_Update(&context, $0.baseAddress, CC_LONG($0.count)) }
+    }
+
+    mutating func update(_ data: Data) {
+        data.withUnsafeBytes { update($0) }
+    }
+
+    mutating func finalizeHex() -> String {
+        var digest = [UInt8](repeating: 0, count: Int(CC_MD5_DIGEST_LENGTH))
+        CC_MD5_Final(&digest, &context)
+        return hexString(digest)
+    }
+
+    // MARK: Private
 
-        withUnsafeBytes { (selfBufferPtr: UnsafeRawBufferPointer) -> Void in
-            digest.withUnsafeMutableBufferPointer { ( digestBufferPtr: inout UnsafeMutableBufferPointer<UInt8>) -> Void in
-                CC_SHA1(selfBufferPtr.baseAddress, CC_LONG(self.count), digestBufferPtr.baseAddress)
-            }
-        }
+    private var context = CC_MD5_CTX()
 
-        var result = ""
-        for index in 0 ..< digestLength {
-            result += String(format: "%02x", digest[index])
-        }
+}
+
+struct SHA1Hasher {
+
+    init() {
+        CC_SHA1_Init(&context)
+    }
+
+    mutating func update(_ bytes: UnsafeRawBufferPointer) {
+        forEachChunk(of: bytes) { CC_SHA1_Update(&context, $0.baseAddress, CC_LONG($0.count)) }
+    }
+
+    mutating func update(_ data: Data) {
+        data.withUnsafeBytes { update($0) }
+    }
 
-        return result
+    mutating func finalizeHex() -> String {
+        var digest = [UInt8](repeating: 0, count: Int(CC_SHA1_DIGEST_LENGTH))
+        CC_SHA1_Final(&digest, &context)
+        return hexString(digest)
     }
 
-    // swiftlint:enable redundant_void_return
+    // MARK: Private
+
+    private var context = CC_SHA1_CTX()
+
+}
+
+private func forEachChunk(of bytes: UnsafeRawBufferPointer, _ body: (UnsafeRawBufferPointer) -> Void) {
+    // CommonCrypto takes a 32-bit length, so give it large inputs in pieces
+    let maxChunkSize = 1 << 30
+    var offset = 0
+    while offset < bytes.count {
+        let chunkSize = min(bytes.count - offset, maxChunkSize)
+        body(UnsafeRawBufferPointer(rebasing: bytes[offset ..< offset + chunkSize]))
+        offset += chunkSize
+    }
+}
 
+private func hexString(_ digest: [UInt8]) -> String {
+    digest.map { String(format: "%02x", $0) }.joined()
 }
@@ -99,6 +99,7 @@ class DetailsWindowController: GeneralWindowController {
     @IBOutlet private var sha1ChecksumField: NSTextField!
 
     private let dataController = HFController()
+    private var checksumsByRow: [Int: (md5: String, sha1: String)] = [:]
     private let dataLayoutRep = HFLayoutRepresenter()
 
     private func synchronizeMessageDataDisplay() {
@@ -116,8 +117,35 @@ class DetailsWindowController: GeneralWindowController {
         byteArray.insertByteSlice(byteSlice, in: HFRange(location: 0, length: 0))
         dataController.byteArray = byteArray
 
-        md5ChecksumField.stringValue = data.count > 0 ? data.md5HexHash : ""
-        sha1ChecksumField.stringValue = data.count > 0 ? data.sha1HexHash : ""
+        showChecksums(ofData: data, row: selectedRow)
+    }
+
+    private func showChecksums(ofData data: Data, row: Int) {
+        // Hashing a large message takes a while, so do it in the background, and only once per message
+        if data.isEmpty {
+            md5ChecksumField.stringValue = ""
+            sha1ChecksumField.stringValue = ""
+        }
+        else if let checksums = checksumsByRow[row] {
+            md5ChecksumField.stringValue = checksums.md5
+            sha1ChecksumField.stringValue = checksums.sha1
+        }
+        else {
+            md5ChecksumField.stringValue = ""
+            sha1ChecksumField.stringValue = ""
+
+            DispatchQueue.global(qos: .userInitiated).async { [weak self] in
+                let checksums = (md5: data.md5HexHash, sha1: data.sha1HexHash)
+                DispatchQueue.main.async {
+                    guard let self else { return }
+                    self.checksumsByRow[row] = checksums
+                    if self.messagesTableView.selectedRow == row {
+                        self.md5ChecksumField.stringValue = checksums.md5
+                        self.sha1ChecksumField.stringValue = checksums.sha1
+                    }
+                }
+            }
+        }
     }
 
     private func minimumWindowSize(_ proposedWindowFrameSize: NSSize) -> NSSize {
@@ -45,10 +45,14 @@ class ExportController {
         savePanel.beginSheetModal(for: window) { response in
             guard response == .OK else { return }
 
-            if let fileData = asSMF ? SystemExclusiveMessage.standardMIDIFileData(forMessages: messages) : SystemExclusiveMessage.data(forMessages: messages),
-               let url = savePanel.url {
+            if !messages.isEmpty, let url = savePanel.url {
                 do {
-                    try fileData.write(to: url)
+                    if asSMF {
+                        try SystemExclusiveMessage.writeStandardMIDIFile(forMessages: messages, to: url)
+                    }
+                    else {
+                        try SystemExclusiveMessage.writeData(forMessages: messages, to: url)
+                    }
                 }
                 catch {
                     let alert = NSAlert(error: error)
@@ -23,7 +23,13 @@ class FindMissingController {
         self.entriesWithMissingFiles = entries
         self.completion = completion
 
-        findNextMissingFile()
+        if entries.count > 1 {
+            // Locating many files one at a time is tedious, so offer to search for them
+            offerToSearchForMissingFiles()
+        }
+        else {
+            findNextMissingFile()
+        }
     }
 
     // MARK: Private
@@ -33,6 +39,7 @@ class FindMissingController {
 
     private var entriesWithMissingFiles: [LibraryEntry] = []
     private var completion: (() -> Void)?
+    private var relinker: LibraryRelinker?
 
 }
 
@@ -116,4 +123,128 @@ extension FindMissingController /* Private */ {
         self.entriesWithMissingFiles = []
     }
 
+    private func offerToSearchForMissingFiles() {
+        guard let window = mainWindowController?.window else { return }
+
+        let alert = NSAlert()
+        alert.messageText = String(localized: "Missing Files", comment: "title of alert for many missing files")
+        let informativeFormat = String(localized: "The files for %ld items could not be found. Would you like to search folders for them, or locate each one?", comment: "format of message for many missing files")
+        alert.informativeText = String.localizedStringWithFormat(informativeFormat, entriesWithMissingFiles.count)
+        alert.addButton(withTitle: String(localized: "Search…", comment: "Search button in missing files alert"))
+        alert.addButton(withTitle: String(localized: "Locate Each…", comment: "Locate Each button in missing files alert"))
+        alert.addButton(withTitle: String(localized: "Cancel", comment: "Cancel button in alert"))
+        alert.beginSheetModal(for: window) { response in
+            alert.window.orderOut(nil)
+
+            switch response {
+            case .alertFirstButtonReturn:   // Search
+                self.runOpenSheetForSearchFolders()
+            case .alertSecondButtonReturn:  // Locate Each
+                self.findNextMissingFile()
+            default:                        // Cancel
+                self.cancelFindMissing()
+            }
+        }
+    }
+
+    private func runOpenSheetForSearchFolders() {
+        guard let window = mainWindowController?.window else { return }
+
+        let openPanel = NSOpenPanel()
+        openPanel.canChooseFiles = false
+        openPanel.canChooseDirectories = true
+        openPanel.allowsMultipleSelection = true
+        openPanel.prompt = String(localized: "Search", comment: "prompt of open panel for folders to search for missing files")
+        openPanel.message = String(localized: "Choose the folders to search for the missing files.", comment: "message of open panel for folders to search for missing files")
+        openPanel.beginSheetModal(for: window) { response in
+            openPanel.orderOut(nil)
+
+            if response == .OK && openPanel.urls.count > 0 {
+                self.searchForMissingFiles(inFolders: openPanel.urls.map(\.path))
+            }
+            else {
+                self.cancelFindMissing()
+            }
+        }
+    }
+
+    private func searchForMissingFiles(inFolders folderPaths: [String]) {
+        guard let window = mainWindowController?.window, let library else { return }
+
+        let relinker = LibraryRelinker(library: library)
+        self.relinker = relinker
+
+        // Show that we're searching, with a button to stop
+        let alert = NSAlert()
+        alert.messageText = String(localized: "Searching for Missing Files", comment: "title of alert while searching for missing files")
+        alert.informativeText = String(localized: "Looking for files with the same contents as the missing ones.", comment: "message of alert while searching for missing files")
+        alert.addButton(withTitle: String(localized: "Stop", comment: "Stop button in alert while searching for missing files"))
+        let progressIndicator = NSProgressIndicator()
+        progressIndicator.style = .bar
+        progressIndicator.isIndeterminate = true
+        progressIndicator.frame = NSRect(x: 0, y: 0, width: 200, height: 20)
+        progressIndicator.startAnimation(nil)
+        alert.accessoryView = progressIndicator
+
+        alert.beginSheetModal(for: window) { response in
+            if response == .alertFirstButtonReturn /* Stop */ {
+                relinker.cancel()
+                self.relinker = nil
+                self.cancelFindMissing()
+            }
+        }
+
+        relinker.findFiles(forEntries: entriesWithMissingFiles, searching: folderPaths) { matches, statistics in
+            self.relinker = nil
+            window.endSheet(alert.window, returnCode: .stop)
+
+            for match in matches {
+                match.entry.path = match.path
+                match.entry.setNameFromFile()
+            }
+
+            let matchedEntries = Set(matches.map { ObjectIdentifier($0.entry) })
+            self.entriesWithMissingFiles.removeAll { matchedEntries.contains(ObjectIdentifier($0)) }
+
+            if UserDefaults.standard.bool(forKey: Self.logSearchStatisticsDefaultsKey) {
+                NSLog("Searched %d folders, %d files (%.0f files/s), read %d candidates (%d bytes), found %d of %d missing files, in %.3f s",
+                      statistics.directoryCount, statistics.fileCount, statistics.filesPerSecond,
+                      statistics.candidateFileCount, statistics.hashedByteCount,
+                      statistics.matchCount, statistics.missingEntryCount, statistics.duration)
+            }
+
+            self.showSearchResults(statistics)
+        }
+    }
+
+    private func showSearchResults(_ statistics: LibraryRelinker.Statistics) {
+        guard let window = mainWindowController?.window else { return }
+
+        let alert = NSAlert()
+        alert.messageText = String(localized: "Search Finished", comment: "title of alert after searching for missing files")
+        let informativeFormat = String(localized: "Found %ld of %ld missing files, after looking at %ld files in %ld folders.", comment: "format of message after searching for missing files")
+        alert.informativeText = String.localizedStringWithFormat(informativeFormat, statistics.matchCount, statistics.missingEntryCount, statistics.fileCount, statistics.directoryCount)
+
+        // With no buttons added, the alert has an OK button
+        if !entriesWithMissingFiles.isEmpty {
+            alert.addButton(withTitle: String(localized: "Locate Each…", comment: "Locate Each button in missing files alert"))
+            alert.addButton(withTitle: String(localized: "Cancel", comment: "Cancel button in alert"))
+        }
+
+        alert.beginSheetModal(for: window) { response in
+            alert.window.orderOut(nil)
+
+            if response == .alertFirstButtonReturn {
+                // Locate the rest one at a time, or finish if there are none
+                self.findNextMissingFile()
+            }
+            else {
+                self.cancelFindMissing()
+            }
+        }
+    }
+
+    // Set this default to YES to log how the search for missing files went
+    private static let logSearchStatisticsDefaultsKey = "SSELogMissingFileSearchStatistics"
+
 }
@@ -58,6 +58,8 @@ class ImportController {
     private weak var library: Library?
 
     private var workQueue: DispatchQueue?
+    private var progress: ImportProgress?
+    private var progressTimer: Timer?
 
     // Transient data
     private var filePathsToImport: [String] = []
@@ -119,8 +121,8 @@ extension ImportController /* Private */ {
         }
         else {
             // Add entries immediately
-            let (newEntries, badFiles) = addFilesToLibrary(filePathsToImport)
-            finishImport(newEntries, badFiles)
+            let result = makeEntries(forFiles: filePathsToImport, existingEntriesByFilePath: library?.entriesByFilePath() ?? [:], progress: nil)
+            addEntriesAndFinishImport(result)
         }
     }
 
@@ -130,7 +132,7 @@ extension ImportController /* Private */ {
     //
 
     private func importFilesShowingProgress() {
-        guard let mainWindow = mainWindowController?.window else { return }
+        guard let mainWindow = mainWindowController?.window, let library else { return }
 
         importCancelled = false
         updateImportStatusDisplay("", 0, 0)
@@ -139,12 +141,24 @@ extension ImportController /* Private */ {
             self.importSheetWindow.orderOut(nil)
         }
 
+        // The work queue only updates the progress's counters. Look at them periodically,
+        // instead of having the work queue ask the main queue to update the display for every file.
+        let progress = ImportProgress()
+        self.progress = progress
+        let timer = Timer(timeInterval: 0.1, repeats: true) { [weak self] _ in
+            self?.updateImportStatusDisplayFromProgress()
+        }
+        RunLoop.main.add(timer, forMode: .common)
+        progressTimer = timer
+
+        // Look up the library's entries here, since getting their paths isn't safe on the work queue
         let paths = self.filePathsToImport
+        let existingEntriesByFilePath = library.entriesByFilePath()
         if workQueue == nil {
             workQueue = DispatchQueue(label: "Import", qos: .userInitiated)
         }
         workQueue?.async {
-            self.workQueueImportFiles(paths)
+            self.workQueueImportFiles(paths, existingEntriesByFilePath, progress)
         }
     }
 
@@ -168,136 +182,177 @@ extension ImportController /* Private */ {
         }
     }
 
+    private func updateImportStatusDisplayFromProgress() {
+        guard let progress else { return }
+
+        let (filePath, finishedFileCount, fileCount) = progress.currentValues
+        if finishedFileCount > 0 {
+            updateImportStatusDisplay(filePath, finishedFileCount - 1, fileCount)
+        }
+    }
+
     //
     // Import with progress display
     // Work queue: recurse through directories, filter out inappropriate files, and import
     //
 
-    private func workQueueImportFiles(_ paths: [String]) {
+    private func workQueueImportFiles(_ paths: [String], _ existingEntriesByFilePath: [String: LibraryEntry], _ progress: ImportProgress) {
         autoreleasepool {
             let expandedAndFilteredFilePaths = workQueueExpandAndFilterFiles(paths)
 
-            var newEntries = [LibraryEntry]()
-            var badFiles = [String]()
+            var result = MakeEntriesResult()
             if expandedAndFilteredFilePaths.count > 0 {
-                (newEntries, badFiles) = addFilesToLibrary(expandedAndFilteredFilePaths)
+                result = makeEntries(forFiles: expandedAndFilteredFilePaths, existingEntriesByFilePath: existingEntriesByFilePath, progress: progress)
             }
 
             DispatchQueue.main.async {
-                self.doneImportingInWorkQueue(newEntries, badFiles)
+                self.doneImportingInWorkQueue(result)
             }
         }
     }
 
     private func workQueueExpandAndFilterFiles(_ paths: [String]) -> [String] {
         guard let library else { return [] }
-        let fileManager = FileManager.default
 
-        var acceptableFilePaths = [String]()
+        // Look at the paths in parallel, but keep the results in the same order as the paths,
+        // so the files are imported in the same order every time.
+        var acceptableFilePathsByIndex = [[String]](repeating: [], count: paths.count)
+        acceptableFilePathsByIndex.withUnsafeMutableBufferPointer { bufferPtr in
+            let resultsBufferPtr = bufferPtr
+            DispatchQueue.concurrentPerform(iterations: paths.count) { pathIndex in
+                guard !importCancelled else { return }
 
-        for path in paths {
-            if importCancelled {
-                acceptableFilePaths.removeAll()
-                break
+                autoreleasepool {
+                    resultsBufferPtr[pathIndex] = workQueueAcceptableFilePaths(paths[pathIndex], library)
+                }
             }
+        }
 
-            var isDirectory = ObjCBool(false)
-            if !fileManager.fileExists(atPath: path, isDirectory: &isDirectory) {
-                continue
-            }
+        if importCancelled {
+            return []
+        }
+
+        return Array(acceptableFilePathsByIndex.joined())
+    }
 
-            autoreleasepool {
-                if isDirectory.boolValue {
-                    // Handle this directory's contents recursively
-                    do {
-                        let childPaths = try fileManager.contentsOfDirectory(atPath: path)
+    private func workQueueAcceptableFilePaths(_ path: String, _ library: Library) -> [String] {
+        let fileManager = FileManager.default
 
-                        var fullChildPaths = [String]()
-                        for childPath in childPaths {
-                            let fullChildPath = NSString(string: path).appendingPathComponent(childPath) as String
-                            fullChildPaths.append(fullChildPath)
-                        }
+        var isDirectory = ObjCBool(false)
+        if !fileManager.fileExists(atPath: path, isDirectory: &isDirectory) {
+            return []
+        }
 
-                        let acceptableChildren = workQueueExpandAndFilterFiles(fullChildPaths)
-                        acceptableFilePaths.append(contentsOf: acceptableChildren)
-                    }
-                    catch {
-                        // ignore
-                    }
-                }
-                else {
-                    if fileManager.isReadableFile(atPath: path) && library.typeOfFile(atPath: path) != .unknown {
-                        acceptableFilePaths.append(path)
-                    }
-                }
+        if isDirectory.boolValue {
+            // Handle this directory's contents recursively
+            do {
+                let childPaths = try fileManager.contentsOfDirectory(atPath: path)
+                let fullChildPaths = childPaths.map { NSString(string: path).appendingPathComponent($0) as String }
+                return workQueueExpandAndFilterFiles(fullChildPaths)
+            }
+            catch {
+                // ignore
+                return []
             }
         }
-
-        return acceptableFilePaths
+        else if fileManager.isReadableFile(atPath: path) && library.typeOfFile(atPath: path) != .unknown {
+            return [path]
+        }
+        else {
+            return []
+        }
     }
 
-    private func doneImportingInWorkQueue(_ newEntries: [LibraryEntry], _ badFiles: [String]) {
+    private func doneImportingInWorkQueue(_ result: MakeEntriesResult) {
+        progressTimer?.invalidate()
+        progressTimer = nil
+        progress = nil
+
         if let window = mainWindowController?.window,
            let sheet = window.attachedSheet {
             window.endSheet(sheet)
         }
 
-        finishImport(newEntries, badFiles)
+        addEntriesAndFinishImport(result)
     }
 
     //
-    // Check if each file is already in the library, and then try to add each new one
+    // Check if each file is already in the library, and then try to make an entry for each new one
     //
 
-    private func addFilesToLibrary(_ paths: [String]) -> ([LibraryEntry], [String]) {
-        // Returns successfully created library entries, and paths for files that could not
-        // be successfully imported.
+    private struct MakeEntriesResult {
+        var existingEntries: [LibraryEntry] = []
+        var newEntries: [LibraryEntry] = []     // not in the library yet
+        var badFilePaths: [String] = []         // files that could not be successfully imported
+    }
+
+    private enum FileResult {
+        case notAttempted
+        case entry(LibraryEntry)
+        case bad
+    }
+
+    private func makeEntries(forFiles paths: [String], existingEntriesByFilePath: [String: LibraryEntry], progress: ImportProgress?) -> MakeEntriesResult {
         // NOTE: This may be happening in the main queue or workQueue.
+        // Reading and parsing the files happens in parallel; the resulting entries are in the same order as the paths.
 
-        guard let library else { return ([], []) }
+        guard let library else { return MakeEntriesResult() }
 
-        var addedEntries = [LibraryEntry]()
-        var badFilePaths = [String]()
+        var result = MakeEntriesResult()
 
         // Find the files which are already in the library, and pull them out.
-        let (existingEntries, filePaths) = library.findEntries(forFilePaths: paths)
-
-        // Try to add each file to the library, keeping track of the successful ones.
-        let fileCount = filePaths.count
-        for (fileIndex, filePath) in filePaths.enumerated() {
-            // If we're not in the main thread, update progress information and tell the main thread to update its UI.
-            if !Thread.isMainThread {
-                if importCancelled {
-                    break
+        let (existingEntries, filePaths) = Library.findEntries(forFilePaths: paths, in: existingEntriesByFilePath)
+        result.existingEntries = existingEntries
+
+        progress?.setFileCount(filePaths.count)
+
+        var fileResults = [FileResult](repeating: .notAttempted, count: filePaths.count)
+        fileResults.withUnsafeMutableBufferPointer { bufferPtr in
+            // Each iteration writes only its own element
+            let fileResultsBufferPtr = bufferPtr
+            DispatchQueue.concurrentPerform(iterations: filePaths.count) { fileIndex in
+                // Only the progress display can cancel
+                if progress != nil && importCancelled {
+                    return
                 }
 
-                DispatchQueue.main.async {
-                    self.updateImportStatusDisplay(filePath, fileIndex, fileCount)
+                let filePath = filePaths[fileIndex]
+                autoreleasepool {
+                    if let entry = library.makeEntry(forFile: filePath) {
+                        fileResultsBufferPtr[fileIndex] = .entry(entry)
+                    }
+                    else {
+                        fileResultsBufferPtr[fileIndex] = .bad
+                    }
                 }
-            }
 
-            autoreleasepool {
-                if let addedEntry = library.addEntry(forFile: filePath) {
-                    addedEntries.append(addedEntry)
-                }
-                else {
-                    badFilePaths.append(filePath)
-                }
+                progress?.noteFileFinished(filePath)
             }
         }
 
-        addedEntries.append(contentsOf: existingEntries)
+        for (fileIndex, fileResult) in fileResults.enumerated() {
+            switch fileResult {
+            case .notAttempted:
+                break
+            case .entry(let entry):
+                result.newEntries.append(entry)
+            case .bad:
+                result.badFilePaths.append(filePaths[fileIndex])
+            }
+        }
 
-        return (addedEntries, badFilePaths)
+        return result
     }
 
     //
     // Finishing up
     //
 
-    private func finishImport(_ newEntries: [LibraryEntry], _ badFiles: [String]) {
-        mainWindowController?.showNewEntries(newEntries)
-        showErrorMessageForFilesWithNoSysEx(badFiles)
+    private func addEntriesAndFinishImport(_ result: MakeEntriesResult) {
+        library?.addEntries(result.newEntries)
+
+        mainWindowController?.showNewEntries(result.newEntries + result.existingEntries)
+        showErrorMessageForFilesWithNoSysEx(result.badFilePaths)
         finishedImport()
     }
 
@@ -334,3 +389,38 @@ extension ImportController /* Private */ {
     }
 
 }
+
+private final class ImportProgress {
+
+    // Counts the files that have been imported so far. Updated from any thread.
+
+    func setFileCount(_ fileCount: Int) {
+        lock.lock()
+        defer { lock.unlock() }
+
+        self.fileCount = fileCount
+    }
+
+    func noteFileFinished(_ filePath: String) {
+        lock.lock()
+        defer { lock.unlock() }
+
+        finishedFileCount += 1
+        lastFinishedFilePath = filePath
+    }
+
+    var currentValues: (filePath: String, finishedFileCount: Int, fileCount: Int) {
+        lock.lock()
+        defer { lock.unlock() }
+
+        return (lastFinishedFilePath, finishedFileCount, fileCount)
+    }
+
+    // MARK: Private
+
+    private let lock = NSLock()
+    private var fileCount = 0
+    private var finishedFileCount = 0
+    private var lastFinishedFilePath = ""
+
+}
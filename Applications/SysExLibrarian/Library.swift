@@ -43,35 +43,52 @@ class Library: NSObject {
 
         preflightFileDirectory()    // can't produce any fatal errors for launch
         loadEntries()
+        validateEntries()
         return nil
     }
 
     private(set) var entries: [LibraryEntry] = []
 
+    // Messages recently read from entries' files
+    let messageCache = LibraryMessageCache(byteBudget: 64 * 1024 * 1024)
+
+    // How long it took to load the entries at startup, in seconds.
+    // Set the default SSELogLibraryLoadDuration to YES to log it.
+    private(set) var loadDuration: TimeInterval = 0
+
+    // How long it took to find all the entries' files in the background after startup, in seconds,
+    // or nil if that isn't finished yet. Logged along with loadDuration.
+    private(set) var validationDuration: TimeInterval?
+
     func addEntry(forFile filePath: String) -> LibraryEntry? {
         // NOTE: This will return nil, and add no entry, if no messages are in the file
+        guard let entry = makeEntry(forFile: filePath) else { return nil }
+        addEntries([entry])
+        return entry
+    }
 
-        // Setting the entry path and name will cause us to be notified of a change, and we'll autosave.
-        // However, the add might not succeed--if it doesn't, make sure our dirty flag isn't set if it shouldn't be.
-        let wasDirty = isDirty
-
+    func makeEntry(forFile filePath: String) -> LibraryEntry? {
+        // Make an entry for the file, but don't add it to the library yet.
+        // Returns nil if no messages are in the file.
+        // This reads and parses the file, so it may take a while, but it's safe to call on any thread.
         let entry = LibraryEntry(library: self)
         entry.path = filePath
 
-        if entry.messages.count > 0 {
-            entry.setNameFromFile()
+        guard entry.messages.count > 0 else { return nil }
+        entry.setNameFromFile()
+        return entry
+    }
+
+    func addEntries(_ newEntries: [LibraryEntry]) {
+        // Add entries from makeEntry(forFile:), in order
+        for entry in newEntries {
             entries.append(entry)
-            return entry
-        }
-        else {
-            if !wasDirty {
-                isDirty = false
-            }
-            return nil
+            assignStoreIdentifier(to: entry)
+            noteEntryChanged(entry)
         }
     }
 
-    func addNewEntry(sysexData: Data) throws -> LibraryEntry? {
+    func addNewEntry(sysexMessages: [SystemExclusiveMessage]) throws -> LibraryEntry? {
         let fileManager = FileManager.default
 
         // ensure the file directory exists; if not we can't write there
@@ -82,7 +99,7 @@ class Library: NSObject {
         let newFilePath = NSString(string: fileDirectoryPath).appendingPathComponent(newFileNameWithExtension)
         let uniqueNewFilePath = fileManager.uniqueFilename(from: newFilePath)
 
-        try NSData(data: sysexData).write(toFile: uniqueNewFilePath, options: .atomic)
+        try SystemExclusiveMessage.writeData(forMessages: sysexMessages, to: URL(fileURLWithPath: uniqueNewFilePath))
 
         let fileAttributes: [FileAttributeKey: Any] = [
             .hfsTypeCode: Self.sysExFileTypeCode,
@@ -107,13 +124,42 @@ class Library: NSObject {
             if let entryIndex = entries.firstIndex(of: entryToRemove) {
                 NotificationCenter.default.post(name: .libraryEntryWillBeRemoved, object: entries[entryIndex])
                 entries.remove(at: entryIndex)
+                entryToRemove.forgetCachedMessages()
+
+                if let identifier = entryToRemove.storeIdentifier {
+                    changedEntries[identifier] = nil
+                    removedIdentifiers.insert(identifier)
+                    entryToRemove.storeIdentifier = nil
+                }
+
+                pendingChange.changedEntries[ObjectIdentifier(entryToRemove)] = nil
+                pendingChange.removedEntries.append(entryToRemove)
             }
         }
 
-        noteEntryChanged()
+        noteLibraryChanged()
     }
 
-    func noteEntryChanged() {
+    func noteEntryChanged(_ entry: LibraryEntry) {
+        // Entries that aren't in the library (not added yet, or already removed) don't have an identifier.
+        // Their changes don't matter, and they may be on another thread, so ignore them.
+        guard let identifier = entry.storeIdentifier else { return }
+
+        changedEntries[identifier] = entry
+        pendingChange.changedEntries[ObjectIdentifier(entry)] = entry
+        noteLibraryChanged()
+    }
+
+    // What changed in the library since the last libraryDidChange notification.
+    // The notification's userInfo has it under changeUserInfoKey, so observers can update incrementally.
+    struct Change {
+        var changedEntries: [ObjectIdentifier: LibraryEntry] = [:]  // added or changed
+        var removedEntries: [LibraryEntry] = []
+    }
+
+    static let changeUserInfoKey = "SSELibraryChange"
+
+    private func noteLibraryChanged() {
         isDirty = true
         autosave()
 
@@ -121,12 +167,17 @@ class Library: NSObject {
             willPostLibraryDidChangeNotification = true
             DispatchQueue.main.async {
                 self.willPostLibraryDidChangeNotification = false
-                NotificationCenter.default.post(name: .libraryDidChange, object: self)
+                let change = self.pendingChange
+                self.pendingChange = Change()
+                NotificationCenter.default.post(name: .libraryDidChange, object: self, userInfo: [Self.changeUserInfoKey: change])
             }
         }
     }
 
     func autosave() {
+        // Once the user has been told that a library can't be written, don't keep trying
+        guard store?.isReadOnly != true || !hasShownSaveError else { return }
+
         NSObject.cancelPreviousPerformRequests(withTarget: self, selector: #selector(save), object: nil)
         perform(#selector(save), with: nil, afterDelay: 0)
     }
@@ -134,31 +185,38 @@ class Library: NSObject {
     @objc func save() {
         guard isDirty else { return }
 
-        let propertyList = ["Entries": entries.compactMap({ $0.dictionaryValues })]
         var maybeLibraryFilePath: String?
 
         do {
-            let libraryFilePath = try baseLibraryFilePath()
-            maybeLibraryFilePath = libraryFilePath
-
-            let fileData = try PropertyListSerialization.data(fromPropertyList: propertyList, format: .xml, options: 0)
-            try NSData(data: fileData).write(toFile: libraryFilePath, options: .atomic)
-
-            let fileAttributes: [FileAttributeKey: Any] = [
-                .hfsTypeCode: Self.libraryFileTypeCode,
-                .hfsCreatorCode: Self.applicationCreatorCode,
-                .extensionHidden: true
-            ]
-            do {
-                try FileManager.default.setAttributes(fileAttributes, ofItemAtPath: libraryFilePath)
+            let store = try libraryStore()
+            maybeLibraryFilePath = store.snapshotPath
+
+            // Usually, only append the entries that changed to the journal, so the time it takes
+            // depends on the size of the change, not the size of the library.
+            if needsSnapshot || store.shouldCompact {
+                try store.writeSnapshot(entries.compactMap { storedEntry(for: $0) })
+                needsSnapshot = false
             }
-            catch {
-                // If we fail to set attributes, it doesn't really matter
+            else {
+                let updates = entries.compactMap { entry in
+                    entry.storeIdentifier.flatMap { changedEntries[$0] != nil ? storedEntry(for: entry) : nil }
+                }
+                try store.appendChanges(updates: updates, removals: removedIdentifiers.sorted())
             }
 
+            changedEntries = [:]
+            removedIdentifiers = []
             isDirty = false
+            hasShownSaveError = false
         }
         catch {
+            // The journal may now end with a partial record, so start over with a full snapshot next time.
+            needsSnapshot = true
+
+            // Saving is tried again after every change, so only tell the user once, until a save works
+            guard !hasShownSaveError else { return }
+            hasShownSaveError = true
+
             // Present the error, Can't continue saving, but can continue with the app.
             // This is not fantastic UI, but it works.  This should not happen unless the user is trying to provoke us, anyway.
             let messageText = String(localized: "Error", comment: "title of error alert")
@@ -213,14 +271,25 @@ class Library: NSObject {
         }
     }
 
-    func findEntries(forFilePaths filePaths: [String]) -> ([LibraryEntry], [String]) {
+    // Getting an entry's path may update the entry and the library, so this must be called on the main queue.
+    // The result can then be used on any queue, with findEntries(forFilePaths:in:).
+    func entriesByFilePath() -> [String: LibraryEntry] {
+        dispatchPrecondition(condition: .onQueue(.main))
+
         var entriesByFilePath: [String: LibraryEntry] = [:]
         for entry in entries {
             if let filePath = entry.path {
                 entriesByFilePath[filePath] = entry
             }
         }
+        return entriesByFilePath
+    }
 
+    func findEntries(forFilePaths filePaths: [String]) -> ([LibraryEntry], [String]) {
+        Self.findEntries(forFilePaths: filePaths, in: entriesByFilePath())
+    }
+
+    static func findEntries(forFilePaths filePaths: [String], in entriesByFilePath: [String: LibraryEntry]) -> ([LibraryEntry], [String]) {
         var nonMatchingFilePaths: [String] = []
         var matchingEntries: [LibraryEntry] = []
 
@@ -236,6 +305,47 @@ class Library: NSObject {
         return (matchingEntries, nonMatchingFilePaths)
     }
 
+    func findDuplicateEntries(completion: @escaping ([[LibraryEntry]]) -> Void) {
+        // Find groups of entries whose messages are identical, and call `completion` with them,
+        // on the main queue. Each group, and the list of groups, is in library order.
+        // Only entries whose files are present are included, so every entry in a group has a file
+        // that really is identical to the others.
+        // Entries without a hash, or whose files have changed since they were hashed, need to have their files
+        // read and hashed first. That happens in parallel, in the background.
+
+        let entriesToHash: [(entry: LibraryEntry, path: String, fileType: FileType)] = entries.compactMap { entry in
+            guard entry.isFilePresentIgnoringCachedValue, let path = entry.path, entry.validContentHash(atPath: path) == nil else { return nil }
+            return (entry, path, typeOfFile(atPath: path))
+        }
+
+        DispatchQueue.global(qos: .userInitiated).async {
+            var hashes = [(ContentHash, ContentHashFileStamp)?](repeating: nil, count: entriesToHash.count)
+            hashes.withUnsafeMutableBufferPointer { bufferPtr in
+                let hashesBufferPtr = bufferPtr
+                DispatchQueue.concurrentPerform(iterations: entriesToHash.count) { index in
+                    autoreleasepool {
+                        // Before reading, so if the file changes while it's being read, the hash won't be trusted
+                        guard let fileStamp = ContentHashFileStamp(fileAtPath: entriesToHash[index].path) else { return }
+                        let messages = LibraryEntry.readMessages(fromFileAtPath: entriesToHash[index].path, fileType: entriesToHash[index].fileType)
+                        if !messages.isEmpty {
+                            hashesBufferPtr[index] = (ContentHash(messages: messages), fileStamp)
+                        }
+                    }
+                }
+            }
+
+            DispatchQueue.main.async {
+                for (index, hashAndStamp) in hashes.enumerated() {
+                    if let (hash, fileStamp) = hashAndStamp {
+                        entriesToHash[index].entry.setContentHash(hash, fileStamp: fileStamp)
+                    }
+                }
+
+                completion(self.duplicateEntryGroups())
+            }
+        }
+    }
+
     func moveFilesInLibraryDirectoryToTrash(forEntries entriesToTrash: [LibraryEntry]) {
         var filesToTrash: [String] = []
 
@@ -256,6 +366,18 @@ class Library: NSObject {
 
     private var isDirty = false
     private var willPostLibraryDidChangeNotification = false
+    private var pendingChange = Change()
+
+    // Changes that haven't been saved yet
+    private var changedEntries: [UInt64: LibraryEntry] = [:]
+    private var removedIdentifiers: Set<UInt64> = []
+    private var needsSnapshot = false
+    private var hasShownSaveError = false
+
+    private var store: LibraryStore?
+    private var nextStoreIdentifier: UInt64 = 1
+
+    private let validator = LibraryValidator()
 
     private let rawSysExContentType = UTType.rawSysEx
     private let standardMIDIContentType = UTType.midi
@@ -277,6 +399,7 @@ extension Library /* Defaults keys */ {
     static let libraryFileDirectoryBookmarkDefaultsKey = "SSELibraryFileDirectoryBookmark"
     static let libraryFileDirectoryAliasDefaultsKey = "SSELibraryFileDirectoryAlias"
     static let libraryFileDirectoryPathDefaultsKey = "SSELibraryFileDirectoryPath"
+    static let logLoadDurationDefaultsKey = "SSELogLibraryLoadDuration"
 
 }
 
@@ -409,6 +532,76 @@ extension Library /* Private */ {
         // We should be called only once, at startup
         precondition(entries.isEmpty)
 
+        let startTime = DispatchTime.now()
+
+        var didLoadFromStore = false
+        do {
+            if let storedEntries = try libraryStore().load() {
+                entries = storedEntries.map { storedEntry in
+                    let entry = LibraryEntry(library: self, dictionary: storedEntry.dictionary)
+                    entry.storeIdentifier = storedEntry.identifier
+                    nextStoreIdentifier = max(nextStoreIdentifier, storedEntry.identifier + 1)
+                    return entry
+                }
+                didLoadFromStore = true
+            }
+        }
+        catch {
+            reportLoadEntriesError(store?.snapshotPath, error)
+        }
+
+        if !didLoadFromStore {
+            // There is no store yet, or it was damaged and has been moved aside (or it couldn't be,
+            // and the store won't write over it). Read the old property list file, if any,
+            // and migrate it by writing a snapshot. Leave the old file alone, for older versions of the app.
+            loadLegacyEntries()
+            entries.forEach { assignStoreIdentifier(to: $0) }
+            needsSnapshot = true
+        }
+
+        loadDuration = Double(DispatchTime.now().uptimeNanoseconds - startTime.uptimeNanoseconds) / 1_000_000_000
+        if UserDefaults.standard.bool(forKey: Self.logLoadDurationDefaultsKey) {
+            NSLog("Loaded %d library entries in %.3f ms", entries.count, loadDuration * 1000)
+        }
+
+        // Ignore any changes that came from reading entries, but save the snapshot if we need one
+        changedEntries = [:]
+        isDirty = needsSnapshot
+        if isDirty {
+            autosave()
+        }
+    }
+
+    private func validateEntries() {
+        // Resolving every entry's alias at startup would mean waiting for the filesystem (or the network)
+        // once per entry before the window could appear. Instead, entries are shown with what was saved,
+        // and their files are looked for in the background. Any that are missing show up as they're found.
+        let startTime = DispatchTime.now()
+
+        // Replace any validation that's still going
+        validator.cancel()
+
+        let entriesToValidate = entries
+        entriesToValidate.forEach { $0.beginAwaitingValidation() }
+
+        validator.validate(entriesToValidate, resultHandler: { results in
+            for (entry, result) in results {
+                entry.applyValidationResult(result)
+            }
+        }, completion: { [weak self] in
+            guard let self else { return }
+            let duration = Double(DispatchTime.now().uptimeNanoseconds - startTime.uptimeNanoseconds) / 1_000_000_000
+            self.validationDuration = duration
+            if UserDefaults.standard.bool(forKey: Self.logLoadDurationDefaultsKey) {
+                let missingCount = entriesToValidate.filter { !$0.isFilePresent }.count
+                NSLog("Found files for %d library entries (%d missing) in %.3f ms", entriesToValidate.count - missingCount, missingCount, duration * 1000)
+            }
+        })
+    }
+
+    private func loadLegacyEntries() {
+        // Before the library store existed, the library was saved as a property list.
+
         var errorToReport: Error?
 
         var maybeLibraryFilePath: String?
@@ -451,9 +644,52 @@ extension Library /* Private */ {
         if let errorToReport {
             reportLoadEntriesError(maybeLibraryFilePath, errorToReport)
         }
+    }
+
+    private func duplicateEntryGroups() -> [[LibraryEntry]] {
+        // Only entries whose files are present, with hashes that still match them.
+        // A missing file, or a hash from before its file changed, says nothing about what's on disk now.
+        var orderedHashes: [ContentHash] = []
+        var entriesByContentHash: [ContentHash: [LibraryEntry]] = [:]
+        for entry in entries {
+            guard entry.isFilePresentIgnoringCachedValue,
+                  let path = entry.path,
+                  let contentHash = entry.validContentHash(atPath: path)
+            else { continue }
+
+            if entriesByContentHash[contentHash] == nil {
+                orderedHashes.append(contentHash)
+            }
+            entriesByContentHash[contentHash, default: []].append(entry)
+        }
+
+        return orderedHashes.compactMap { contentHash in
+            guard let group = entriesByContentHash[contentHash], group.count > 1 else { return nil }
+            return group
+        }
+    }
+
+    private func libraryStore() throws -> LibraryStore {
+        if let store {
+            return store
+        }
+
+        let directoryPath = NSString(string: try baseLibraryFilePath()).deletingLastPathComponent
+        let newStore = LibraryStore(
+            snapshotPath: NSString(string: directoryPath).appendingPathComponent("SysEx Librarian Library Index"),
+            journalPath: NSString(string: directoryPath).appendingPathComponent("SysEx Librarian Library Journal"))
+        store = newStore
+        return newStore
+    }
+
+    private func assignStoreIdentifier(to entry: LibraryEntry) {
+        entry.storeIdentifier = nextStoreIdentifier
+        nextStoreIdentifier += 1
+    }
 
-        // Ignore any changes that came from reading entries
-        isDirty = false
+    private func storedEntry(for entry: LibraryEntry) -> LibraryStore.StoredEntry? {
+        guard let identifier = entry.storeIdentifier else { return nil }
+        return LibraryStore.StoredEntry(identifier: identifier, dictionary: entry.dictionaryValues)
     }
 
     private func reportLoadEntriesError(_ maybeLibraryFilePath: String?, _ errorToReport: Error) {
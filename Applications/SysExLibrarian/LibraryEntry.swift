@@ -22,6 +22,9 @@ class LibraryEntry: NSObject {
 
     unowned var library: Library!
 
+    // Identifies this entry in the library's saved store. Assigned by the library when the entry is added.
+    var storeIdentifier: UInt64?
+
     var dictionaryValues: [String: Any] {
         var dict: [String: Any] = [:]
 
@@ -37,6 +40,10 @@ class LibraryEntry: NSObject {
             dict["name"] = name
         }
 
+        if let lastKnownPath {
+            dict["path"] = lastKnownPath
+        }
+
         if let manufacturer {
             dict["manufacturerName"] = manufacturer
         }
@@ -49,6 +56,12 @@ class LibraryEntry: NSObject {
             dict["messageCount"] = messageCount
         }
 
+        if let contentHash, let contentHashFileStamp {
+            dict["contentHash"] = contentHash.data
+            dict["contentHashFileSize"] = contentHashFileStamp.size
+            dict["contentHashFileModificationTime"] = contentHashFileStamp.modificationNanoseconds
+        }
+
         if let programNumber {
             dict["programNumber"] = programNumber
         }
@@ -58,39 +71,73 @@ class LibraryEntry: NSObject {
 
     var path: String? {
         get {
-            let wasFilePresent = hasLookedForFile && privateIsFilePresent
+            // An entry awaiting validation is shown as if its file is present
+            let wasFilePresent = isAwaitingValidation || (hasLookedForFile && privateIsFilePresent)
             hasLookedForFile = true
+            isAwaitingValidation = false
 
             let filePath = alias?.path(allowingMountingUI: false)
+            var isPresent = false
+            var displayName: String?
             if let extantFilePath = filePath {
-                privateIsFilePresent = FileManager.default.fileExists(atPath: extantFilePath)
-                if privateIsFilePresent {
-                    name = FileManager.default.displayName(atPath: extantFilePath)
+                isPresent = FileManager.default.fileExists(atPath: extantFilePath)
+                if isPresent {
+                    displayName = FileManager.default.displayName(atPath: extantFilePath)
                 }
             }
-            else {
-                privateIsFilePresent = false
-            }
-
-            if privateIsFilePresent != wasFilePresent {
-                library.noteEntryChanged()
-            }
 
+            updateFileStatus(path: filePath, isFilePresent: isPresent, displayName: displayName, wasFilePresent: wasFilePresent)
             return filePath
         }
         set {
             alias = newValue != nil ? Alias(path: newValue!) : nil
             oldAliasRecordData = nil
+            lastKnownPath = newValue
+            isAwaitingValidation = false
+
+            library.noteEntryChanged(self)
+        }
+    }
 
-            library.noteEntryChanged()
+    // The path the file had the last time it was found. Saved with the entry,
+    // so the entry can be shown before its alias is resolved again.
+    private(set) var lastKnownPath: String?
+
+    // Until the library's validator resolves the alias in the background, the entry's file is assumed to be present,
+    // so showing the entry doesn't wait for the filesystem. Getting `path` resolves the alias immediately, as always.
+    private(set) var isAwaitingValidation = false
+
+    func beginAwaitingValidation() {
+        if !hasLookedForFile {
+            isAwaitingValidation = true
         }
     }
 
+    // The alias to resolve in the background. It's a copy, so resolving it doesn't touch the entry.
+    var aliasForValidation: Alias? {
+        alias
+    }
+
+    func applyValidationResult(_ result: LibraryValidator.Result) {
+        // If the file was looked for since validation started, that result is newer than this one
+        guard isAwaitingValidation else { return }
+        isAwaitingValidation = false
+        hasLookedForFile = true
+
+        if let refreshedAlias = result.refreshedAlias {
+            alias = refreshedAlias
+            library.noteEntryChanged(self)
+        }
+
+        // The entry was shown as if its file was present
+        updateFileStatus(path: result.path, isFilePresent: result.isFilePresent, displayName: result.displayName, wasFilePresent: true)
+    }
+
     private(set) var name: String? {
         didSet {
             if name != oldValue {
                 NotificationCenter.default.post(name: .libraryEntryNameDidChange, object: self)
-                library.noteEntryChanged()
+                library.noteEntryChanged(self)
             }
         }
     }
@@ -210,26 +257,62 @@ class LibraryEntry: NSObject {
     }
 
     var messages: [SystemExclusiveMessage] {
-        var messages: [SystemExclusiveMessage] = []
-
-        if let path,
-           let data = NSData(contentsOfFile: path) as Data? {
-            switch library.typeOfFile(atPath: path) {
-            case .raw:
-                messages = SystemExclusiveMessage.messages(fromData: data)
-                updateDerivedInformation(messages)
-            case .standardMIDI:
-                messages = SystemExclusiveMessage.messages(fromStandardMIDIFileData: data)
-                updateDerivedInformation(messages)
-            default:
-                break
-            }
+        guard let path else { return [] }
+
+        // Use the messages from the last time this file was read, if it hasn't changed since
+        let cacheKey = LibraryMessageCache.Key(fileAtPath: path, owner: self)
+        if let cacheKey,
+           let cachedMessages = library.messageCache.messages(forKey: cacheKey) {
+            return cachedMessages
+        }
+
+        // The file has changed since its messages were cached, so they're no use now, even if they're pinned
+        forgetCachedMessages()
+
+        // Before reading, so if the file changes while it's being read, the hash won't be trusted
+        let fileStamp = ContentHashFileStamp(fileAtPath: path)
+        let messages = Self.readMessages(fromFileAtPath: path, fileType: library.typeOfFile(atPath: path))
+        if !messages.isEmpty {
+            updateDerivedInformation(messages, fileStamp: fileStamp)
+        }
+
+        if let cacheKey, !messages.isEmpty {
+            // Entries with a program number may be played at any moment, so keep them around
+            library.messageCache.store(messages, forKey: cacheKey, pinned: programNumber != nil)
+            messageCacheKey = cacheKey
         }
 
         return messages
     }
 
+    static func readMessages(fromFileAtPath path: String, fileType: Library.FileType) -> [SystemExclusiveMessage] {
+        // Map the file instead of reading it. The parsed messages refer to slices of the file's data.
+        guard let data = try? Data(contentsOf: URL(fileURLWithPath: path), options: .mappedIfSafe) else { return [] }
+
+        switch fileType {
+        case .raw:
+            return SystemExclusiveMessage.messages(fromData: data)
+        case .standardMIDI:
+            return SystemExclusiveMessage.messages(fromStandardMIDIFileData: data)
+        case .unknown:
+            return []
+        }
+    }
+
+    // Called when the entry is removed from the library, or its file changes
+    func forgetCachedMessages() {
+        if let messageCacheKey {
+            library.messageCache.removeMessages(forKey: messageCacheKey)
+            self.messageCacheKey = nil
+        }
+    }
+
     var isFilePresent: Bool {
+        // An entry awaiting validation is shown as if its file is present
+        if isAwaitingValidation {
+            return true
+        }
+
         if !hasLookedForFile {
             _ = self.path
         }
@@ -239,6 +322,7 @@ class LibraryEntry: NSObject {
 
     var isFilePresentIgnoringCachedValue: Bool {
         hasLookedForFile = false
+        isAwaitingValidation = false
         return isFilePresent
     }
 
@@ -250,7 +334,8 @@ class LibraryEntry: NSObject {
     var fileReadError: Error? {
         guard let path else { return nil }
         do {
-            _ = try NSData(contentsOfFile: path, options: [])
+            // Mapping is enough to find out whether the file can be read, without reading all of it
+            _ = try Data(contentsOf: URL(fileURLWithPath: path), options: .mappedIfSafe)
             return nil
         }
         catch {
@@ -261,7 +346,12 @@ class LibraryEntry: NSObject {
     var programNumber: UInt8? /* 0 ..< 127 */ {
         didSet {
             if oldValue != programNumber {
-                library.noteEntryChanged()
+                if (oldValue == nil) != (programNumber == nil),
+                   let messageCacheKey {
+                    library.messageCache.setPinned(programNumber != nil, forKey: messageCacheKey)
+                }
+
+                library.noteEntryChanged(self)
             }
         }
     }
@@ -271,7 +361,7 @@ class LibraryEntry: NSObject {
     private(set) var manufacturer: String? {
         didSet {
             if oldValue != manufacturer {
-                library.noteEntryChanged()
+                library.noteEntryChanged(self)
             }
         }
     }
@@ -279,7 +369,7 @@ class LibraryEntry: NSObject {
     private(set) var size: Int? {
         didSet {
             if oldValue != size {
-                library.noteEntryChanged()
+                library.noteEntryChanged(self)
             }
         }
     }
@@ -287,17 +377,39 @@ class LibraryEntry: NSObject {
     private(set) var messageCount: Int? {
         didSet {
             if oldValue != messageCount {
-                library.noteEntryChanged()
+                library.noteEntryChanged(self)
             }
         }
     }
 
+    // Identifies the contents of the messages, as of the last time the file was read.
+    // (Kept even when the file is missing, so the file can be recognized when it's found.)
+    private(set) var contentHash: ContentHash?
+
+    func setContentHash(_ newContentHash: ContentHash, fileStamp: ContentHashFileStamp) {
+        if newContentHash != contentHash || fileStamp != contentHashFileStamp {
+            contentHash = newContentHash
+            contentHashFileStamp = fileStamp
+            library.noteEntryChanged(self)
+        }
+    }
+
+    // The content hash, only if the file is at `path` and hasn't changed since it was hashed.
+    // Use this to compare entries' files as they are now, to find duplicates.
+    func validContentHash(atPath path: String) -> ContentHash? {
+        guard let contentHash, let contentHashFileStamp,
+              ContentHashFileStamp(fileAtPath: path) == contentHashFileStamp else { return nil }
+        return contentHash
+    }
+
     // MARK: Private
 
     private var hasLookedForFile = false
     private var privateIsFilePresent = false
     private var alias: Alias?
     private var oldAliasRecordData: Data?
+    private var messageCacheKey: LibraryMessageCache.Key?
+    private var contentHashFileStamp: ContentHashFileStamp?
 
 }
 
@@ -338,10 +450,28 @@ extension LibraryEntry /* Private */ {
         messages.count
     }
 
-    private func updateDerivedInformation(_ messages: [SystemExclusiveMessage]) {
+    private func updateFileStatus(path filePath: String?, isFilePresent isPresent: Bool, displayName: String?, wasFilePresent: Bool) {
+        privateIsFilePresent = isPresent
+        if let displayName {
+            name = displayName
+        }
+
+        if isPresent, let filePath, filePath != lastKnownPath {
+            lastKnownPath = filePath
+            library.noteEntryChanged(self)
+        }
+        else if isPresent != wasFilePresent {
+            library.noteEntryChanged(self)
+        }
+    }
+
+    private func updateDerivedInformation(_ messages: [SystemExclusiveMessage], fileStamp: ContentHashFileStamp?) {
         manufacturer = Self.manufacturer(messages: messages)
         size = Self.size(messages: messages)
         messageCount = Self.messageCount(messages: messages)
+        if let fileStamp {
+            setContentHash(ContentHash(messages: messages), fileStamp: fileStamp)
+        }
     }
 
     private func setValues(fromDictionary dict: [String: Any]) {
@@ -359,10 +489,16 @@ extension LibraryEntry /* Private */ {
             oldAliasRecordData = oldAliasData
         }
 
+        lastKnownPath = dict["path"] as? String
+
         precondition(name == nil)
         if let string = dict["name"] as? String {
             name = string
         }
+        else if let lastKnownPath {
+            // Don't look for the file just to get its name; validation will update it later
+            name = (lastKnownPath as NSString).lastPathComponent
+        }
         else {
             setNameFromFile()
         }
@@ -385,6 +521,16 @@ extension LibraryEntry /* Private */ {
         if let number = dict["messageCount"] as? Int {
             messageCount = number
         }
+
+        // A hash without the file's size and modification time (from before they were saved)
+        // can't be checked against the file, so leave it out, and the file will be hashed again when needed.
+        if let data = dict["contentHash"] as? Data,
+           let hash = ContentHash(data: data),
+           let fileSize = dict["contentHashFileSize"] as? Int64,
+           let modificationNanoseconds = dict["contentHashFileModificationTime"] as? Int64 {
+            contentHash = hash
+            contentHashFileStamp = ContentHashFileStamp(size: fileSize, modificationNanoseconds: modificationNanoseconds)
+        }
     }
 
 }
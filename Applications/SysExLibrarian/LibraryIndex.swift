@@ -0,0 +1,314 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+class LibraryIndex {
+
+    // Keeps the library's entries sorted and searchable, for the main window.
+    //
+    // Each entry's sort value and search text are computed once, when the entry is indexed,
+    // instead of on every comparison. When a few entries change, they're moved to their new places
+    // with binary searches, instead of sorting everything again.
+    //
+    // Searching finds entries whose name or manufacturer contain the search string, ignoring case and diacritics.
+    // For search strings of 3 or more bytes, the candidates come from an index of the trigrams (3-byte sequences)
+    // in each entry's text; shorter search strings just scan the texts.
+
+    enum SortKey: String {
+        // Same as the identifiers of the table columns
+        case name
+        case manufacturer
+        case size
+        case messageCount
+        case programNumber
+    }
+
+    private(set) var sortKey = SortKey.name
+    private(set) var isSortAscending = true
+
+    // The entries that match the search string, in sort order
+    private(set) var visibleEntries: [LibraryEntry] = []
+
+    var searchString = "" {
+        didSet {
+            if searchString != oldValue {
+                updateVisibleEntries()
+            }
+        }
+    }
+
+    // Index all of these entries, replacing anything indexed before
+    func reload(_ entries: [LibraryEntry], sortKey: SortKey, ascending: Bool) {
+        self.sortKey = sortKey
+        self.isSortAscending = ascending
+
+        indexedEntries.removeAll(keepingCapacity: true)
+        trigramPostings.removeAll(keepingCapacity: true)
+
+        rows = entries.map { entry in
+            let indexedEntry = makeIndexedEntry(entry)
+            indexedEntries[ObjectIdentifier(entry)] = indexedEntry
+            addToTrigramPostings(indexedEntry, ObjectIdentifier(entry))
+            return Row(entry: entry, value: indexedEntry.value, identifier: indexedEntry.identifier)
+        }
+        rows.sort { $0.precedes($1) }
+
+        updateVisibleEntries()
+    }
+
+    // Update the index for a change in the library. If the change is large, it's
+    // faster to reload everything, so `allEntries` should be the library's current entries.
+    func apply(_ change: Library.Change, allEntries: [LibraryEntry]) {
+        let changeCount = change.removedEntries.count + change.changedEntries.count
+        if changeCount > max(64, rows.count / 8) {
+            reload(allEntries, sortKey: sortKey, ascending: isSortAscending)
+            return
+        }
+
+        for entry in change.removedEntries {
+            removeEntry(entry)
+        }
+
+        for entry in change.changedEntries.values {
+            // An entry that has been removed from the library has no identifier
+            guard let identifier = entry.storeIdentifier else { continue }
+
+            let newIndexedEntry = makeIndexedEntry(entry, identifier: identifier)
+            if let oldIndexedEntry = indexedEntries[ObjectIdentifier(entry)] {
+                if oldIndexedEntry == newIndexedEntry {
+                    continue
+                }
+                removeEntry(entry)
+            }
+            insertEntry(entry, newIndexedEntry)
+        }
+
+        updateVisibleEntries()
+    }
+
+    // The row of the entry in visibleEntries, if it's there
+    func row(of entry: LibraryEntry) -> Int? {
+        if visibleRowsByEntry == nil {
+            var rowsByEntry: [ObjectIdentifier: Int] = [:]
+            rowsByEntry.reserveCapacity(visibleEntries.count)
+            for (row, visibleEntry) in visibleEntries.enumerated() {
+                rowsByEntry[ObjectIdentifier(visibleEntry)] = row
+            }
+            visibleRowsByEntry = rowsByEntry
+        }
+
+        return visibleRowsByEntry?[ObjectIdentifier(entry)]
+    }
+
+    // The first entry in sort order with this program number, whether it matches the search string or not
+    func firstEntry(withProgramNumber programNumber: UInt8) -> LibraryEntry? {
+        if entriesByProgramNumber == nil {
+            var map: [UInt8: LibraryEntry] = [:]
+            for row in isSortAscending ? AnyCollection(rows) : AnyCollection(rows.reversed()) {
+                if let rowProgramNumber = row.entry.programNumber, map[rowProgramNumber] == nil {
+                    map[rowProgramNumber] = row.entry
+                }
+            }
+            entriesByProgramNumber = map
+        }
+
+        return entriesByProgramNumber?[programNumber]
+    }
+
+    // MARK: Private
+
+    private enum SortValue: Comparable {
+        case string(String)
+        case integer(Int)
+    }
+
+    private struct IndexedEntry: Equatable {
+        let value: SortValue
+        let identifier: UInt64
+        let searchText: [UInt8]     // folded UTF-8
+    }
+
+    private struct Row {
+        let entry: LibraryEntry
+        let value: SortValue
+        let identifier: UInt64      // breaks ties, so the order is always the same
+
+        func precedes(_ other: Row) -> Bool {
+            (value, identifier) < (other.value, other.identifier)
+        }
+    }
+
+    // All indexed entries, in ascending order
+    private var rows: [Row] = []
+
+    private var indexedEntries: [ObjectIdentifier: IndexedEntry] = [:]
+    private var trigramPostings: [UInt32: Set<ObjectIdentifier>] = [:]
+
+    // Built when first needed after each change
+    private var visibleRowsByEntry: [ObjectIdentifier: Int]?
+    private var entriesByProgramNumber: [UInt8: LibraryEntry]?
+
+    private func sortValue(_ entry: LibraryEntry) -> SortValue {
+        switch sortKey {
+        case .name:
+            return .string(entry.name ?? "")
+        case .manufacturer:
+            return .string(entry.manufacturer ?? "")
+        case .size:
+            return .integer(entry.size ?? -1)
+        case .messageCount:
+            return .integer(entry.messageCount ?? 0)
+        case .programNumber:
+            return .integer(entry.programNumber.map { Int($0) } ?? -1)
+        }
+    }
+
+    private func makeIndexedEntry(_ entry: LibraryEntry, identifier: UInt64? = nil) -> IndexedEntry {
+        // Separate the name and manufacturer with a byte that can't be in a search string,
+        // so a match can't span both
+        let searchText = Self.foldedBytes(entry.name ?? "") + [0] + Self.foldedBytes(entry.manufacturer ?? "")
+        return IndexedEntry(value: sortValue(entry), identifier: identifier ?? entry.storeIdentifier ?? 0, searchText: searchText)
+    }
+
+    private static func foldedBytes(_ string: String) -> [UInt8] {
+        Array(string.folding(options: [.caseInsensitive, .diacriticInsensitive, .widthInsensitive], locale: nil).utf8)
+    }
+
+    private static func forEachTrigram(_ bytes: [UInt8], _ body: (UInt32) -> Void) {
+        guard bytes.count >= 3 else { return }
+        for index in 0 ... bytes.count - 3 {
+            body(UInt32(bytes[index]) << 16 | UInt32(bytes[index + 1]) << 8 | UInt32(bytes[index + 2]))
+        }
+    }
+
+    private func addToTrigramPostings(_ indexedEntry: IndexedEntry, _ key: ObjectIdentifier) {
+        Self.forEachTrigram(indexedEntry.searchText) { trigram in
+            trigramPostings[trigram, default: []].insert(key)
+        }
+    }
+
+    private func removeFromTrigramPostings(_ indexedEntry: IndexedEntry, _ key: ObjectIdentifier) {
+        Self.forEachTrigram(indexedEntry.searchText) { trigram in
+            trigramPostings[trigram]?.remove(key)
+            if trigramPostings[trigram]?.isEmpty == true {
+                trigramPostings[trigram] = nil
+            }
+        }
+    }
+
+    // The index in `rows` where a row with this value and identifier is, or would be inserted
+    private func rowIndex(value: SortValue, identifier: UInt64) -> Int {
+        var low = 0
+        var high = rows.count
+        while low < high {
+            let middle = (low + high) / 2
+            if (rows[middle].value, rows[middle].identifier) < (value, identifier) {
+                low = middle + 1
+            }
+            else {
+                high = middle
+            }
+        }
+        return low
+    }
+
+    private func insertEntry(_ entry: LibraryEntry, _ indexedEntry: IndexedEntry) {
+        let key = ObjectIdentifier(entry)
+        indexedEntries[key] = indexedEntry
+        addToTrigramPostings(indexedEntry, key)
+
+        let index = rowIndex(value: indexedEntry.value, identifier: indexedEntry.identifier)
+        rows.insert(Row(entry: entry, value: indexedEntry.value, identifier: indexedEntry.identifier), at: index)
+    }
+
+    private func removeEntry(_ entry: LibraryEntry) {
+        let key = ObjectIdentifier(entry)
+        guard let indexedEntry = indexedEntries.removeValue(forKey: key) else { return }
+        removeFromTrigramPostings(indexedEntry, key)
+
+        let index = rowIndex(value: indexedEntry.value, identifier: indexedEntry.identifier)
+        if index < rows.count && rows[index].entry === entry {
+            rows.remove(at: index)
+        }
+    }
+
+    // The entries that contain the search string, or nil if every entry matches
+    private func matchingEntryKeys() -> Set<ObjectIdentifier>? {
+        let query = Self.foldedBytes(searchString)
+        guard !query.isEmpty else { return nil }
+
+        var candidates: [ObjectIdentifier]
+        if query.count >= 3 {
+            var postings: [Set<ObjectIdentifier>] = []
+            var isMissingTrigram = false
+            Self.forEachTrigram(query) { trigram in
+                if let posting = trigramPostings[trigram] {
+                    postings.append(posting)
+                }
+                else {
+                    isMissingTrigram = true
+                }
+            }
+            guard !isMissingTrigram else { return [] }
+
+            // Start with the smallest posting, and keep the keys that are in all the others
+            postings.sort { $0.count < $1.count }
+            candidates = Array(postings[0])
+            for posting in postings.dropFirst() {
+                candidates = candidates.filter { posting.contains($0) }
+            }
+        }
+        else {
+            candidates = Array(indexedEntries.keys)
+        }
+
+        // Having all the trigrams doesn't mean they're in the right order, so check the actual text
+        return Set(candidates.filter { key in
+            guard let searchText = indexedEntries[key]?.searchText else { return false }
+            return Self.bytes(searchText, contain: query)
+        })
+    }
+
+    private static func bytes(_ haystack: [UInt8], contain needle: [UInt8]) -> Bool {
+        haystack.withUnsafeBytes { haystackPtr in
+            needle.withUnsafeBytes { needlePtr in
+                memmem(haystackPtr.baseAddress, haystackPtr.count, needlePtr.baseAddress, needlePtr.count) != nil
+            }
+        }
+    }
+
+    private func updateVisibleEntries() {
+        var visibleRows: [Row]
+        if let matchingKeys = matchingEntryKeys() {
+            if matchingKeys.count < rows.count / 16 {
+                // Few matches: sort them, instead of looking through all the rows
+                visibleRows = matchingKeys.compactMap { key in
+                    indexedEntries[key].flatMap { indexedEntry in
+                        rows[rowIndex(value: indexedEntry.value, identifier: indexedEntry.identifier)]
+                    }
+                }
+                visibleRows.sort { $0.precedes($1) }
+            }
+            else {
+                visibleRows = rows.filter { matchingKeys.contains(ObjectIdentifier($0.entry)) }
+            }
+        }
+        else {
+            visibleRows = rows
+        }
+
+        if !isSortAscending {
+            visibleRows.reverse()
+        }
+
+        visibleEntries = visibleRows.map { $0.entry }
+        visibleRowsByEntry = nil
+        entriesByProgramNumber = nil
+    }
+
+}
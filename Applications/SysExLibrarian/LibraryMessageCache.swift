@@ -0,0 +1,221 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import SnoizeMIDI
+
+class LibraryMessageCache {
+
+    // Keeps the messages parsed from recently used files, so playing or looking at an entry
+    // again doesn't read and parse its file again. This matters most for entries that are played
+    // in response to program changes, which should start as quickly as possible.
+    //
+    // Messages are looked up by the file's identity and modification date, so a cached list
+    // is never used after its file has changed. They're also looked up by the entry that owns them,
+    // so entries that refer to the same file don't evict or pin each other's messages.
+    // When the cached messages take more than `byteBudget` bytes, the least recently used ones
+    // are dropped, except for pinned ones.
+    //
+    // This may be used from any thread.
+
+    init(byteBudget: Int) {
+        self.byteBudget = byteBudget
+    }
+
+    let byteBudget: Int
+
+    struct Key: Hashable {
+        let owner: ObjectIdentifier
+        let device: UInt64
+        let inode: UInt64
+        let size: Int64
+        let modificationSeconds: Int
+        let modificationNanoseconds: Int
+
+        // Returns nil if the file can't be found
+        init?(fileAtPath path: String, owner: AnyObject) {
+            var fileStatus = stat()
+            guard stat(path, &fileStatus) == 0 else { return nil }
+
+            self.owner = ObjectIdentifier(owner)
+            device = UInt64(fileStatus.st_dev)
+            inode = UInt64(fileStatus.st_ino)
+            size = Int64(fileStatus.st_size)
+            modificationSeconds = Int(fileStatus.st_mtimespec.tv_sec)
+            modificationNanoseconds = Int(fileStatus.st_mtimespec.tv_nsec)
+        }
+    }
+
+    struct Statistics {
+        var hits = 0
+        var misses = 0
+        var evictions = 0
+        var entryCount = 0
+        var byteCount = 0
+    }
+
+    var statistics: Statistics {
+        lock.lock()
+        defer { lock.unlock() }
+
+        var result = privateStatistics
+        result.entryCount = nodesByKey.count
+        result.byteCount = byteCount
+        return result
+    }
+
+    func messages(forKey key: Key) -> [SystemExclusiveMessage]? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard let node = nodesByKey[key] else {
+            privateStatistics.misses += 1
+            return nil
+        }
+
+        privateStatistics.hits += 1
+        moveToFront(node)
+        return node.messages
+    }
+
+    func store(_ messages: [SystemExclusiveMessage], forKey key: Key, pinned: Bool) {
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let oldNode = nodesByKey[key] {
+            remove(oldNode)
+        }
+
+        let node = Node(key: key, messages: messages, byteCount: Self.byteCount(of: messages), isPinned: pinned)
+        nodesByKey[key] = node
+        byteCount += node.byteCount
+        insertAtFront(node)
+
+        evictIfOverBudget()
+    }
+
+    // Pinned messages stay in the cache regardless of the budget, until they're unpinned
+    func setPinned(_ pinned: Bool, forKey key: Key) {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard let node = nodesByKey[key], node.isPinned != pinned else { return }
+        node.isPinned = pinned
+        if !pinned {
+            evictIfOverBudget()
+        }
+    }
+
+    func removeMessages(forKey key: Key) {
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let node = nodesByKey[key] {
+            remove(node)
+        }
+    }
+
+    func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+
+        nodesByKey.removeAll()
+        mostRecent = nil
+        leastRecent = nil
+        byteCount = 0
+    }
+
+    // MARK: Private
+
+    private let lock = NSLock()
+    private var privateStatistics = Statistics()
+
+    // A doubly linked list, most recently used first. The dictionary owns the nodes.
+    private final class Node {
+        init(key: Key, messages: [SystemExclusiveMessage], byteCount: Int, isPinned: Bool) {
+            self.key = key
+            self.messages = messages
+            self.byteCount = byteCount
+            self.isPinned = isPinned
+        }
+
+        let key: Key
+        let messages: [SystemExclusiveMessage]
+        let byteCount: Int
+        var isPinned: Bool
+        weak var moreRecent: Node?
+        weak var lessRecent: Node?
+    }
+
+    private var nodesByKey: [Key: Node] = [:]
+    private weak var mostRecent: Node?
+    private weak var leastRecent: Node?
+    private var byteCount = 0
+
+    // Roughly what each message costs beyond its data
+    private static let perMessageOverhead = 64
+
+    private static func byteCount(of messages: [SystemExclusiveMessage]) -> Int {
+        messages.reduce(0) { $0 + $1.data.count + perMessageOverhead }
+    }
+
+    private func insertAtFront(_ node: Node) {
+        node.lessRecent = nil
+        node.moreRecent = nil
+        if let mostRecent {
+            mostRecent.moreRecent = node
+            node.lessRecent = mostRecent
+        }
+        else {
+            leastRecent = node
+        }
+        mostRecent = node
+    }
+
+    private func unlink(_ node: Node) {
+        if let moreRecent = node.moreRecent {
+            moreRecent.lessRecent = node.lessRecent
+        }
+        else {
+            mostRecent = node.lessRecent
+        }
+
+        if let lessRecent = node.lessRecent {
+            lessRecent.moreRecent = node.moreRecent
+        }
+        else {
+            leastRecent = node.moreRecent
+        }
+
+        node.moreRecent = nil
+        node.lessRecent = nil
+    }
+
+    private func moveToFront(_ node: Node) {
+        guard node !== mostRecent else { return }
+        unlink(node)
+        insertAtFront(node)
+    }
+
+    private func remove(_ node: Node) {
+        unlink(node)
+        nodesByKey[node.key] = nil
+        byteCount -= node.byteCount
+    }
+
+    private func evictIfOverBudget() {
+        var candidate = leastRecent
+        while byteCount > byteBudget, let node = candidate {
+            candidate = node.moreRecent
+            if !node.isPinned {
+                remove(node)
+                privateStatistics.evictions += 1
+            }
+        }
+    }
+
+}
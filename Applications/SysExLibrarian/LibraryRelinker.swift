@@ -0,0 +1,301 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import SnoizeMIDI
+
+class LibraryRelinker {
+
+    // Finds the files for entries whose files are missing, by searching folders for files with the same contents.
+    //
+    // The folders are crawled a level at a time, listing several directories at once.
+    // Each file is checked against the missing entries by size and name first, which is cheap.
+    // Only the files that pass are read and hashed, and a file matches an entry if its content hash
+    // is the same as the one saved in the entry. (An entry without a saved hash matches a file
+    // with the same name, size, and message count.)
+
+    init(library: Library, maxConcurrentReads: Int = 4) {
+        self.library = library
+        self.maxConcurrentReads = maxConcurrentReads
+    }
+
+    struct Match {
+        let entry: LibraryEntry
+        let path: String
+    }
+
+    struct Statistics {
+        var directoryCount = 0
+        var fileCount = 0
+        var candidateFileCount = 0  // files that passed the size and name checks
+        var hashedByteCount = 0
+        var missingEntryCount = 0
+        var matchCount = 0
+        var duration: TimeInterval = 0
+
+        var filesPerSecond: Double {
+            duration > 0 ? Double(fileCount) / duration : 0
+        }
+    }
+
+    // Must be called on the main queue. `completion` is called on the main queue, unless cancelled.
+    func findFiles(forEntries entries: [LibraryEntry], searching rootPaths: [String], completion: @escaping ([Match], Statistics) -> Void) {
+        guard let library else { return }
+
+        let targets = entries.map { Target($0) }
+
+        // Files that other entries already use can't be matches. Use the entries' last known paths,
+        // instead of resolving every entry's alias here.
+        let missingEntryKeys = Set(entries.map { ObjectIdentifier($0) })
+        let pathsInUse = Set(library.entries.compactMap { entry in
+            missingEntryKeys.contains(ObjectIdentifier(entry)) ? nil : entry.lastKnownPath
+        })
+
+        isCancelled = false
+
+        DispatchQueue.global(qos: .userInitiated).async {
+            let startTime = DispatchTime.now()
+            var statistics = Statistics()
+            statistics.missingEntryCount = targets.count
+
+            let (files, directoryCount) = self.crawl(rootPaths)
+            statistics.directoryCount = directoryCount
+            statistics.fileCount = files.count
+
+            let candidateFiles = self.prefilter(files, targets, pathsInUse)
+            statistics.candidateFileCount = candidateFiles.count
+
+            let contents = self.readContents(candidateFiles)
+            statistics.hashedByteCount = contents.reduce(0) { $0 + ($1?.size ?? 0) }
+
+            let matchedTargetIndexes = Self.match(candidateFiles, contents, targets)
+            statistics.matchCount = matchedTargetIndexes.count
+            statistics.duration = Double(DispatchTime.now().uptimeNanoseconds - startTime.uptimeNanoseconds) / 1_000_000_000
+
+            DispatchQueue.main.async {
+                guard !self.isCancelled else { return }
+
+                let matches = matchedTargetIndexes.map { targetIndex, fileIndex in
+                    Match(entry: entries[targetIndex], path: candidateFiles[fileIndex].path)
+                }
+                completion(matches, statistics)
+            }
+        }
+    }
+
+    // Stops searching. The completion won't be called.
+    func cancel() {
+        isCancelled = true
+    }
+
+    // MARK: Private
+
+    private weak var library: Library?
+    private let maxConcurrentReads: Int
+
+    private let cancelLock = NSLock()
+    private var privateIsCancelled = false
+
+    private var isCancelled: Bool {
+        get {
+            cancelLock.lock()
+            defer { cancelLock.unlock() }
+            return privateIsCancelled
+        }
+        set {
+            cancelLock.lock()
+            defer { cancelLock.unlock() }
+            privateIsCancelled = newValue
+        }
+    }
+
+    // What's known about a missing entry, copied on the main queue
+    private struct Target {
+        let size: Int?
+        let messageCount: Int?
+        let contentHash: ContentHash?
+        let fileName: String?
+
+        init(_ entry: LibraryEntry) {
+            size = entry.size
+            messageCount = entry.messageCount
+            contentHash = entry.contentHash
+            fileName = entry.lastKnownPath.map { Self.normalizedFileName($0) }
+        }
+
+        static func normalizedFileName(_ path: String) -> String {
+            (path as NSString).lastPathComponent.lowercased()
+        }
+    }
+
+    private struct FileInfo {
+        let path: String
+        let size: Int
+    }
+
+    private struct CandidateFile {
+        let path: String
+        let fileType: Library.FileType
+        let targetIndexes: [Int]    // entries this file might be, most likely first
+    }
+
+    private struct FileContents {
+        let contentHash: ContentHash
+        let size: Int
+        let messageCount: Int
+    }
+
+    // Calls `body` with each index in 0 ..< iterations, running up to maxConcurrentReads at once.
+    // This is like DispatchQueue.concurrentPerform, but the iterations spend most of their time waiting
+    // for the disk, so running one per CPU would just make them compete for it.
+    private func concurrentlyPerform(iterations: Int, _ body: (Int) -> Void) {
+        let lock = NSLock()
+        var nextIndex = 0
+
+        DispatchQueue.concurrentPerform(iterations: min(iterations, maxConcurrentReads)) { _ in
+            while !isCancelled {
+                lock.lock()
+                let index = nextIndex
+                nextIndex += 1
+                lock.unlock()
+
+                guard index < iterations else { break }
+                autoreleasepool {
+                    body(index)
+                }
+            }
+        }
+    }
+
+    private func crawl(_ rootPaths: [String]) -> (files: [FileInfo], directoryCount: Int) {
+        var files: [FileInfo] = []
+        var directoryCount = 0
+
+        var directoryURLs = rootPaths.map { URL(fileURLWithPath: $0, isDirectory: true) }
+        while !directoryURLs.isEmpty && !isCancelled {
+            var listings = [(files: [FileInfo], subdirectoryURLs: [URL])](repeating: ([], []), count: directoryURLs.count)
+            listings.withUnsafeMutableBufferPointer { bufferPtr in
+                let listingsBufferPtr = bufferPtr
+                let urls = directoryURLs
+                concurrentlyPerform(iterations: urls.count) { index in
+                    listingsBufferPtr[index] = Self.list(urls[index])
+                }
+            }
+
+            directoryCount += directoryURLs.count
+            files += listings.flatMap(\.files)
+            directoryURLs = listings.flatMap(\.subdirectoryURLs)
+        }
+
+        return (files, directoryCount)
+    }
+
+    private static let listingKeys: [URLResourceKey] = [.isRegularFileKey, .isDirectoryKey, .isSymbolicLinkKey, .isPackageKey, .fileSizeKey]
+
+    private static func list(_ directoryURL: URL) -> (files: [FileInfo], subdirectoryURLs: [URL]) {
+        guard let urls = try? FileManager.default.contentsOfDirectory(at: directoryURL, includingPropertiesForKeys: listingKeys, options: [.skipsHiddenFiles]) else { return ([], []) }
+
+        var files: [FileInfo] = []
+        var subdirectoryURLs: [URL] = []
+        for url in urls {
+            guard let values = try? url.resourceValues(forKeys: Set(listingKeys)) else { continue }
+
+            // Don't follow symbolic links, which could lead in circles, or look inside packages
+            if values.isSymbolicLink == true {
+                continue
+            }
+            else if values.isRegularFile == true {
+                files.append(FileInfo(path: url.path, size: values.fileSize ?? 0))
+            }
+            else if values.isDirectory == true && values.isPackage != true {
+                subdirectoryURLs.append(url)
+            }
+        }
+
+        return (files, subdirectoryURLs)
+    }
+
+    private func prefilter(_ files: [FileInfo], _ targets: [Target], _ pathsInUse: Set<String>) -> [CandidateFile] {
+        guard let library else { return [] }
+
+        var targetIndexesBySize: [Int: [Int]] = [:]
+        var targetIndexesByFileName: [String: [Int]] = [:]
+        for (index, target) in targets.enumerated() {
+            if let size = target.size {
+                targetIndexesBySize[size, default: []].append(index)
+            }
+            if let fileName = target.fileName {
+                targetIndexesByFileName[fileName, default: []].append(index)
+            }
+        }
+
+        return files.compactMap { file in
+            guard !pathsInUse.contains(file.path) else { return nil }
+
+            // A raw sysex file is the same size as its messages, so the sizes must match.
+            // A standard MIDI file is bigger, so only its name can say whether it's worth reading.
+            let nameMatches = targetIndexesByFileName[Target.normalizedFileName(file.path)] ?? []
+            let sizeMatches = targetIndexesBySize[file.size] ?? []
+            guard !nameMatches.isEmpty || !sizeMatches.isEmpty else { return nil }
+
+            let fileType = library.typeOfFile(atPath: file.path)
+            guard fileType != .unknown else { return nil }
+
+            var targetIndexes = nameMatches
+            targetIndexes += sizeMatches.filter { !nameMatches.contains($0) }
+            return CandidateFile(path: file.path, fileType: fileType, targetIndexes: targetIndexes)
+        }
+    }
+
+    private func readContents(_ candidateFiles: [CandidateFile]) -> [FileContents?] {
+        var contents = [FileContents?](repeating: nil, count: candidateFiles.count)
+        contents.withUnsafeMutableBufferPointer { bufferPtr in
+            let contentsBufferPtr = bufferPtr
+            concurrentlyPerform(iterations: candidateFiles.count) { index in
+                let messages = LibraryEntry.readMessages(fromFileAtPath: candidateFiles[index].path, fileType: candidateFiles[index].fileType)
+                if !messages.isEmpty {
+                    let size = messages.map(\.fullMessageDataLength).reduce(0, (+))
+                    contentsBufferPtr[index] = FileContents(contentHash: ContentHash(messages: messages), size: size, messageCount: messages.count)
+                }
+            }
+        }
+        return contents
+    }
+
+    // Returns pairs of (target index, candidate file index). Each target and each file is matched at most once,
+    // so entries with the same contents get different files, if there are enough of them.
+    private static func match(_ candidateFiles: [CandidateFile], _ contents: [FileContents?], _ targets: [Target]) -> [(Int, Int)] {
+        var matches: [(Int, Int)] = []
+        var isTargetMatched = [Bool](repeating: false, count: targets.count)
+
+        for (fileIndex, candidateFile) in candidateFiles.enumerated() {
+            guard let fileContents = contents[fileIndex] else { continue }
+
+            let targetIndex = candidateFile.targetIndexes.first { targetIndex in
+                guard !isTargetMatched[targetIndex] else { return false }
+
+                let target = targets[targetIndex]
+                if let contentHash = target.contentHash {
+                    return contentHash == fileContents.contentHash
+                }
+                else {
+                    return target.fileName == Target.normalizedFileName(candidateFile.path)
+                        && target.size == fileContents.size
+                        && target.messageCount == fileContents.messageCount
+                }
+            }
+
+            if let targetIndex {
+                isTargetMatched[targetIndex] = true
+                matches.append((targetIndex, fileIndex))
+            }
+        }
+
+        return matches
+    }
+
+}
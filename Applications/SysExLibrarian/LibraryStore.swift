@@ -0,0 +1,384 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+class LibraryStore {
+
+    // Saves the library's entries in two files, so that saving a change doesn't mean rewriting everything:
+    //
+    // - The snapshot holds every entry, as of the last time it was written.
+    // - The journal holds changes made since then: an entry's new values, or the removal of an entry.
+    //   Saving a change just appends to the journal.
+    //
+    // When the journal gets large compared to the snapshot, the library writes a new snapshot
+    // and the journal starts over.
+    //
+    // Both files are a signature, then a sequence of records, in the same format.
+    // All integers are little-endian.
+    //
+    //     UInt32   length of the rest of the record, in bytes
+    //     UInt8    operation (see Operation)
+    //     UInt64   entry identifier
+    //     UInt16   number of fields (only for .update)
+    //     fields   (only for .update)
+    //
+    // Each field is an entry's dictionary key and value:
+    //
+    //     UInt8    length of the key, then the key, UTF-8
+    //     UInt8    type of value (see ValueType)
+    //     UInt32   length of the value, then the value
+    //
+    // If the app quits in the middle of appending a record, the partial record is cut off the end of
+    // the journal when it's loaded, so the next records are appended after the last complete one.
+    //
+    // If the snapshot is damaged, it and the journal are moved aside, with " (Damaged)" added to their names,
+    // so writing a new snapshot can't destroy whatever is left in them. If they can't be moved,
+    // the store refuses to write.
+
+    init(snapshotPath: String, journalPath: String) {
+        self.snapshotPath = snapshotPath
+        self.journalPath = journalPath
+    }
+
+    let snapshotPath: String
+    let journalPath: String
+
+    struct StoredEntry {
+        let identifier: UInt64
+        let dictionary: [String: Any]
+    }
+
+    // Returns the entries in the snapshot with the journal applied, in the order they were added,
+    // or nil if there is no snapshot yet. Throws if the snapshot is damaged. If it couldn't be moved aside,
+    // the store won't write anything, so the damaged file stays as it is.
+    func load() throws -> [StoredEntry]? {
+        let (entries, journalValidByteCount) = try loadEntries()
+
+        if let journalValidByteCount, journalValidByteCount != journalByteCount {
+            // The journal ends with a partial record, or something after the last good record.
+            // Cut it off, so new records don't get appended after it, where they would never be read.
+            // (This happens after loadEntries() returns, so the journal is no longer mapped.)
+            if truncate(journalPath, off_t(journalValidByteCount)) == 0 {
+                journalByteCount = journalValidByteCount
+            }
+            else {
+                // Write a new snapshot next time instead, which replaces the journal
+                journalNeedsReplacing = true
+            }
+        }
+
+        return entries
+    }
+
+    // Replace the snapshot with these entries, and empty the journal.
+    func writeSnapshot(_ entries: [StoredEntry]) throws {
+        guard !isReadOnly else { throw Self.corruptFileError(path: snapshotPath) }
+
+        var data = Self.snapshotSignature
+        for entry in entries {
+            Self.appendRecord(.update, identifier: entry.identifier, dictionary: entry.dictionary, to: &data)
+        }
+
+        try data.write(to: URL(fileURLWithPath: snapshotPath), options: .atomic)
+        snapshotByteCount = data.count
+
+        // If we stop before this point, the old journal's changes are already in the snapshot,
+        // and applying them again does no harm.
+        try Self.journalSignature.write(to: URL(fileURLWithPath: journalPath), options: .atomic)
+        journalByteCount = Self.journalSignature.count
+        journalNeedsReplacing = false
+    }
+
+    // Append changes to the journal
+    func appendChanges(updates: [StoredEntry], removals: [UInt64]) throws {
+        guard !isReadOnly else { throw Self.corruptFileError(path: snapshotPath) }
+
+        var data = Data()
+        if journalByteCount == 0 {
+            data.append(Self.journalSignature)
+        }
+        for entry in updates {
+            Self.appendRecord(.update, identifier: entry.identifier, dictionary: entry.dictionary, to: &data)
+        }
+        for identifier in removals {
+            Self.appendRecord(.remove, identifier: identifier, dictionary: [:], to: &data)
+        }
+
+        let fileDescriptor = open(journalPath, O_WRONLY | O_APPEND | O_CREAT, 0o644)
+        guard fileDescriptor >= 0 else { throw Self.posixError() }
+        defer { close(fileDescriptor) }
+
+        try data.withUnsafeBytes { (rawBufferPtr: UnsafeRawBufferPointer) in
+            guard let baseAddress = rawBufferPtr.baseAddress else { return }
+            var offset = 0
+            while offset < rawBufferPtr.count {
+                let result = write(fileDescriptor, baseAddress + offset, rawBufferPtr.count - offset)
+                if result < 0 {
+                    if errno == EINTR {
+                        continue
+                    }
+                    throw Self.posixError()
+                }
+                offset += result
+            }
+        }
+        // The changes are only safe once they're on disk
+        guard fsync(fileDescriptor) == 0 else { throw Self.posixError() }
+
+        journalByteCount += data.count
+    }
+
+    // True when it's time to write a new snapshot instead of appending to the journal
+    var shouldCompact: Bool {
+        journalNeedsReplacing || journalByteCount > max(snapshotByteCount / 2, Self.minimumCompactionByteCount)
+    }
+
+    // MARK: Private
+
+    private var snapshotByteCount = 0
+    private var journalByteCount = 0
+    private var journalNeedsReplacing = false
+    private(set) var isReadOnly = false     // the damaged snapshot couldn't be moved aside, so don't replace it
+
+    private static let snapshotSignature = Data("SXLBSNP1".utf8)
+    private static let journalSignature = Data("SXLBJRN1".utf8)
+    private static let minimumCompactionByteCount = 64 * 1024
+
+    private enum Operation: UInt8 {
+        case update = 1
+        case remove = 2
+    }
+
+    private enum ValueType: UInt8 {
+        case data = 0
+        case string = 1
+        case integer = 2    // Int64
+        case propertyList = 3   // anything else a property list can hold, in binary property list format
+    }
+
+    private struct Record {
+        let operation: Operation
+        let identifier: UInt64
+        let dictionary: [String: Any]
+    }
+
+    private func loadEntries() throws -> ([StoredEntry]?, Int?) {
+        guard let snapshotData = try mappedData(atPath: snapshotPath) else { return (nil, nil) }
+
+        var order: [UInt64] = []
+        var dictionaries: [UInt64: [String: Any]] = [:]
+
+        func apply(_ record: Record) {
+            switch record.operation {
+            case .update:
+                if dictionaries.updateValue(record.dictionary, forKey: record.identifier) == nil {
+                    order.append(record.identifier)
+                }
+            case .remove:
+                dictionaries[record.identifier] = nil
+            }
+        }
+
+        // The snapshot is written atomically, so anything but complete records means it's damaged
+        guard Self.scanRecords(in: snapshotData, signature: Self.snapshotSignature, apply) == snapshotData.count else {
+            moveDamagedFilesAside()
+            throw Self.corruptFileError(path: snapshotPath)
+        }
+
+        journalByteCount = 0
+        var journalValidByteCount: Int?
+        if let journalData = try mappedData(atPath: journalPath) {
+            // A damaged journal only loses the changes in it, so don't treat it as an error.
+            // If it doesn't even start with the signature, empty it.
+            journalValidByteCount = Self.scanRecords(in: journalData, signature: Self.journalSignature, apply) ?? 0
+            journalByteCount = journalData.count
+        }
+        snapshotByteCount = snapshotData.count
+
+        let entries = order.compactMap { identifier in
+            dictionaries[identifier].map { StoredEntry(identifier: identifier, dictionary: $0) }
+        }
+        return (entries, journalValidByteCount)
+    }
+
+    private func moveDamagedFilesAside() {
+        // Keep what's left of the damaged files, for the user or for recovery, instead of letting
+        // the next snapshot replace them. If that isn't possible, never write over them.
+        for path in [snapshotPath, journalPath] where FileManager.default.fileExists(atPath: path) {
+            let damagedPath = Self.damagedFilePath(path)
+            do {
+                try FileManager.default.moveItem(atPath: path, toPath: damagedPath)
+            }
+            catch {
+                isReadOnly = true
+            }
+        }
+    }
+
+    private static func damagedFilePath(_ path: String) -> String {
+        // Don't replace files that were moved aside before
+        var damagedPath = path + " (Damaged)"
+        var number = 2
+        while FileManager.default.fileExists(atPath: damagedPath) {
+            damagedPath = path + " (Damaged \(number))"
+            number += 1
+        }
+        return damagedPath
+    }
+
+    private func mappedData(atPath path: String) throws -> Data? {
+        do {
+            return try Data(contentsOf: URL(fileURLWithPath: path), options: .mappedIfSafe)
+        }
+        catch CocoaError.fileReadNoSuchFile {
+            return nil
+        }
+    }
+
+    private static func appendRecord(_ operation: Operation, identifier: UInt64, dictionary: [String: Any], to data: inout Data) {
+        var body = Data()
+        body.append(operation.rawValue)
+        appendLittleEndian(identifier, to: &body)
+
+        if operation == .update {
+            var fields: [(key: Data, type: ValueType, value: Data)] = []
+            for (key, value) in dictionary.sorted(by: { $0.key < $1.key }) {
+                let keyData = Data(key.utf8)
+                guard keyData.count <= UInt8.max else { continue }
+
+                switch value {
+                case let dataValue as Data:
+                    fields.append((keyData, .data, dataValue))
+                case let stringValue as String:
+                    fields.append((keyData, .string, Data(stringValue.utf8)))
+                case let numberValue as NSNumber where !isFloatingPoint(numberValue):
+                    var integerData = Data()
+                    appendLittleEndian(numberValue.int64Value, to: &integerData)
+                    fields.append((keyData, .integer, integerData))
+                default:
+                    // Floating point numbers, dates, arrays, and dictionaries
+                    guard let plistData = try? PropertyListSerialization.data(fromPropertyList: value, format: .binary, options: 0) else {
+                        NSLog("Can't save library entry property \"%@\" of type %@", key, String(describing: type(of: value)))
+                        assertionFailure("unsupported library entry property type")
+                        continue
+                    }
+                    fields.append((keyData, .propertyList, plistData))
+                }
+            }
+
+            appendLittleEndian(UInt16(fields.count), to: &body)
+            for field in fields {
+                body.append(UInt8(field.key.count))
+                body.append(field.key)
+                body.append(field.type.rawValue)
+                appendLittleEndian(UInt32(field.value.count), to: &body)
+                body.append(field.value)
+            }
+        }
+
+        appendLittleEndian(UInt32(body.count), to: &data)
+        data.append(body)
+    }
+
+    // Calls `apply` for each complete record, stopping at a partial record or one that doesn't make sense.
+    // Returns the number of bytes up to the end of the last good record, or nil if the data doesn't start
+    // with the signature.
+    private static func scanRecords(in data: Data, signature: Data, _ apply: (Record) -> Void) -> Int? {
+        data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> Int? in
+            guard bytes.count >= signature.count, bytes.prefix(signature.count).elementsEqual(signature) else { return nil }
+
+            var offset = signature.count
+            while offset + 4 <= bytes.count {
+                let recordLength = Int(bytes.loadUnaligned(fromByteOffset: offset, as: UInt32.self).littleEndian)
+                let recordStart = offset + 4
+                guard recordLength <= bytes.count - recordStart else {
+                    // A partial record at the end
+                    break
+                }
+
+                guard let record = parseRecord(UnsafeRawBufferPointer(rebasing: bytes[recordStart ..< recordStart + recordLength])) else { break }
+                apply(record)
+                offset = recordStart + recordLength
+            }
+
+            return offset
+        }
+    }
+
+    private static func parseRecord(_ bytes: UnsafeRawBufferPointer) -> Record? {
+        var offset = 0
+
+        func read<T: FixedWidthInteger>(_ type: T.Type) -> T? {
+            guard MemoryLayout<T>.size <= bytes.count - offset else { return nil }
+            let value = T(littleEndian: bytes.loadUnaligned(fromByteOffset: offset, as: T.self))
+            offset += MemoryLayout<T>.size
+            return value
+        }
+
+        func readBytes(_ count: Int) -> UnsafeRawBufferPointer? {
+            guard count <= bytes.count - offset else { return nil }
+            let slice = UnsafeRawBufferPointer(rebasing: bytes[offset ..< offset + count])
+            offset += count
+            return slice
+        }
+
+        guard let operationValue = read(UInt8.self),
+              let operation = Operation(rawValue: operationValue),
+              let identifier = read(UInt64.self) else { return nil }
+
+        var dictionary: [String: Any] = [:]
+        if operation == .update {
+            guard let fieldCount = read(UInt16.self) else { return nil }
+            for _ in 0 ..< fieldCount {
+                guard let keyLength = read(UInt8.self),
+                      let keyBytes = readBytes(Int(keyLength)),
+                      let typeValue = read(UInt8.self),
+                      let valueLength = read(UInt32.self),
+                      let valueBytes = readBytes(Int(valueLength)) else { return nil }
+
+                let key = String(decoding: keyBytes, as: UTF8.self)
+                switch ValueType(rawValue: typeValue) {
+                case .data:
+                    dictionary[key] = Data(valueBytes)
+                case .string:
+                    dictionary[key] = String(decoding: valueBytes, as: UTF8.self)
+                case .integer:
+                    guard valueBytes.count == 8 else { return nil }
+                    // As an NSNumber, like a property list would have, so it can be cast to any integer type
+                    dictionary[key] = NSNumber(value: Int64(littleEndian: valueBytes.loadUnaligned(as: Int64.self)))
+                case .propertyList:
+                    guard let value = try? PropertyListSerialization.propertyList(from: Data(valueBytes), format: nil) else { return nil }
+                    dictionary[key] = value
+                case nil:
+                    // From a newer version; skip it
+                    continue
+                }
+            }
+        }
+
+        return Record(operation: operation, identifier: identifier, dictionary: dictionary)
+    }
+
+    private static func isFloatingPoint(_ number: NSNumber) -> Bool {
+        let objCType = number.objCType.pointee
+        return objCType == CChar(UInt8(ascii: "f")) || objCType == CChar(UInt8(ascii: "d"))
+    }
+
+    private static func appendLittleEndian<T: FixedWidthInteger>(_ value: T, to data: inout Data) {
+        withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+    }
+
+    private static func corruptFileError(path: String) -> Error {
+        NSError(domain: NSCocoaErrorDomain, code: NSFileReadCorruptFileError, userInfo: [NSFilePathErrorKey: path])
+    }
+
+    private static func posixError() -> Error {
+        NSError(domain: NSPOSIXErrorDomain, code: Int(errno), userInfo: nil)
+    }
+
+}
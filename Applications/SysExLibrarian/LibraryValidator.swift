@@ -0,0 +1,117 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+class LibraryValidator {
+
+    // Resolves library entries' aliases and checks whether their files are present, in the background.
+    // Resolving an alias can take a long time, especially for files on network volumes,
+    // so only a few are resolved at once, and results are delivered to the main queue in batches as they arrive.
+
+    init(maxConcurrentResolutions: Int = 4) {
+        operationQueue.name = "com.snoize.SysExLibrarian.LibraryValidator"
+        operationQueue.qualityOfService = .utility
+        operationQueue.maxConcurrentOperationCount = maxConcurrentResolutions
+    }
+
+    deinit {
+        cancel()
+    }
+
+    struct Result {
+        let path: String?
+        let isFilePresent: Bool
+        let displayName: String?
+        let refreshedAlias: Alias?      // if the alias was stale and has been replaced
+    }
+
+    // Must be called on the main queue. `resultHandler` and `completion` are called on the main queue.
+    func validate(_ entries: [LibraryEntry], resultHandler: @escaping ([(LibraryEntry, Result)]) -> Void, completion: @escaping () -> Void) {
+        // Copy the aliases here; only the copies are touched in the background
+        let requests = entries.map { ($0, $0.aliasForValidation) }
+
+        var remainingCount = requests.count
+        let generation = self.generation
+        guard remainingCount > 0 else {
+            completion()
+            return
+        }
+
+        for (entry, alias) in requests {
+            operationQueue.addOperation { [weak self] in
+                let result = Self.resolve(alias)
+
+                DispatchQueue.main.async {
+                    guard let self, self.generation == generation else { return }
+                    self.pendingResults.append((entry, result))
+                    self.scheduleDelivery(resultHandler)
+
+                    remainingCount -= 1
+                    if remainingCount == 0 {
+                        self.deliverPendingResults(resultHandler)
+                        completion()
+                    }
+                }
+            }
+        }
+    }
+
+    // Stops validating. Results that haven't been delivered yet are dropped, and completions won't be called.
+    func cancel() {
+        operationQueue.cancelAllOperations()
+        generation += 1
+        pendingResults = []
+    }
+
+    // MARK: Private
+
+    private let operationQueue = OperationQueue()
+
+    private var generation = 0      // changes when validation is cancelled, so results still on their way are ignored
+    private var pendingResults: [(LibraryEntry, Result)] = []
+    private var isDeliveryScheduled = false
+
+    // How long to collect results before delivering them
+    private static let deliveryInterval: TimeInterval = 0.1
+
+    private static func resolve(_ alias: Alias?) -> Result {
+        guard var alias else {
+            return Result(path: nil, isFilePresent: false, displayName: nil, refreshedAlias: nil)
+        }
+        let originalData = alias.data
+
+        guard let path = alias.path(allowingMountingUI: false) else {
+            return Result(path: nil, isFilePresent: false, displayName: nil, refreshedAlias: nil)
+        }
+
+        let fileManager = FileManager.default
+        let isFilePresent = fileManager.fileExists(atPath: path)
+        let displayName = isFilePresent ? fileManager.displayName(atPath: path) : nil
+        let refreshedAlias = alias.data != originalData ? alias : nil
+        return Result(path: path, isFilePresent: isFilePresent, displayName: displayName, refreshedAlias: refreshedAlias)
+    }
+
+    private func scheduleDelivery(_ resultHandler: @escaping ([(LibraryEntry, Result)]) -> Void) {
+        guard !isDeliveryScheduled else { return }
+        isDeliveryScheduled = true
+
+        DispatchQueue.main.asyncAfter(deadline: .now() + Self.deliveryInterval) { [weak self] in
+            self?.deliverPendingResults(resultHandler)
+        }
+    }
+
+    private func deliverPendingResults(_ resultHandler: ([(LibraryEntry, Result)]) -> Void) {
+        isDeliveryScheduled = false
+        guard !pendingResults.isEmpty else { return }
+
+        let results = pendingResults
+        pendingResults = []
+        resultHandler(results)
+    }
+
+}
@@ -29,6 +29,7 @@ class MIDIController: NSObject {
         outputStream.ignoresTimeStamps = true
         outputStream.sendsSysExAsynchronously = true
         outputStream.customSysExBufferSize = UserDefaults.standard.integer(forKey: Self.customSysexBufferSizePreferenceKey)
+        outputStream.destinationCustomSysExBufferSizes = Self.destinationCustomSysExBufferSizes
         outputStream.setVirtualDisplayName(String(localized: "Act as a source for other programs", comment: "display name of virtual source"))
 
         sendPreferenceDidChange(nil)
@@ -74,7 +75,17 @@ class MIDIController: NSObject {
             outputStream.selectedDestination
         }
         set {
-            outputStream.selectedDestination = newValue
+            selectedDestinations = newValue.map { [$0] } ?? []
+        }
+    }
+
+    // When several destinations are selected, messages are sent to all of them at once
+    var selectedDestinations: [OutputStreamDestination] {
+        get {
+            outputStream.selectedDestinations
+        }
+        set {
+            outputStream.selectedDestinations = newValue
 
             mainWindowController?.synchronizeDestinations()
             UserDefaults.standard.set(outputStream.persistentSettings, forKey: Self.selectedDestinationPreferenceKey)
@@ -85,7 +96,9 @@ class MIDIController: NSObject {
         didSet {
             sendingMessageCount = messages.count
             sendingMessageIndex = 0
-            bytesToSend = messages.reduce(0, { $0 + $1.fullMessageDataLength })
+            sendingDestinationCount = max(outputStream.selectedDestinations.count, 1)
+            // Every message goes to every destination
+            bytesToSend = messages.reduce(0, { $0 + $1.fullMessageDataLength }) * sendingDestinationCount
             bytesSent = 0
         }
     }
@@ -143,7 +156,7 @@ class MIDIController: NSObject {
             messages = []
         }
         else {
-            currentSendRequest = nil
+            currentSendRequests = []
             sendingMessageIndex = 0
             bytesSent = 0
             sendStatus = .idle
@@ -167,7 +180,8 @@ class MIDIController: NSObject {
         case .delayingBeforeNext:
             // sendNextSysExMessageAfterDelay() has scheduled the next sendNextSysExMessage(),
             // but it hasn't happened yet.
-            NSObject.cancelPreviousPerformRequests(withTarget: self, selector: #selector(sendNextSysExMessage), object: nil)
+            delayedSendWorkItem?.cancel()
+            delayedSendWorkItem = nil
             sendStatus = .finishing
             finishedSendingMessages(success: false)
         default:
@@ -178,7 +192,8 @@ class MIDIController: NSObject {
     struct MessageSendStatus {
         let messageCount: Int
         let messageIndex: Int
-        let bytesToSend: Int
+        let destinationCount: Int
+        let bytesToSend: Int    // for all destinations together
         let bytesSent: Int
     }
 
@@ -186,8 +201,9 @@ class MIDIController: NSObject {
         return MessageSendStatus(
             messageCount: sendingMessageCount,
             messageIndex: sendingMessageIndex,
+            destinationCount: sendingDestinationCount,
             bytesToSend: bytesToSend,
-            bytesSent: bytesSent + (currentSendRequest?.bytesSent ?? 0)
+            bytesSent: bytesSent + currentSendRequests.reduce(0) { $0 + $1.bytesSent }
         )
     }
 
@@ -219,7 +235,12 @@ class MIDIController: NSObject {
     }
 
     private var pauseTimeBetweenMessages = TimeInterval(0)
-    private weak var currentSendRequest: SysExSendRequest?
+    // The current message's requests, one per destination, that haven't finished yet
+    private var currentSendRequests: [SysExSendRequest] = []
+    private var wasCurrentMessageFullySent = true
+    private var previousMessageFinishHostTime: MIDITimeStamp = 0
+    private var sendingDestinationCount = 1
+    private var delayedSendWorkItem: DispatchWorkItem?
     private var sendingMessageCount = 0
     private var sendingMessageIndex = 0
     private var bytesToSend = 0
@@ -271,6 +292,8 @@ extension MIDIController /* Preferences Keys*/ {
     static let interruptOnProgramChangePreferenceKey = "SSEInterruptOnProgramChange"
     static let programChangeBaseIndexPreferenceKey = "SSEProgramChangeBaseIndex"
     static let customSysexBufferSizePreferenceKey = "SSECustomSysexBufferSize"
+    static let logSysExSendTimingPreferenceKey = "SSELogSysExSendTiming"    // not shown in the preferences window
+    static let destinationCustomSysexBufferSizesPreferenceKey = "SSEDestinationCustomSysexBufferSizes"   // unique ID strings to sizes
 
 }
 
@@ -363,16 +386,39 @@ extension MIDIController /* Private */ {
 
     // MARK: Sending sysex messages
 
-    @objc private func sendNextSysExMessage() {
+    private func sendNextSysExMessage() {
+        delayedSendWorkItem = nil
+        wasCurrentMessageFullySent = true
+        previousMessageFinishHostTime = 0
         sendStatus = .sending
         outputStream.takeMIDIMessages([messages[sendingMessageIndex]])
+
+        // Requests that fail to start have already ended, so only ones that are actually sending are left
+        guard sendStatus == .sending else { return }
+        if currentSendRequests.isEmpty {
+            // Nothing could be sent, so there's nothing to wait for
+            sendStatus = .finishing
+            finishedSendingMessages(success: false)
+        }
+        else if currentSendRequests.count != sendingDestinationCount {
+            // The destinations changed since sending started, so the remaining messages go to a different number of them
+            sendingDestinationCount = currentSendRequests.count
+            bytesToSend = bytesSent + messages[sendingMessageIndex...].reduce(0, { $0 + $1.fullMessageDataLength }) * sendingDestinationCount
+        }
     }
 
     private func sendNextSysExMessageAfterDelay() {
         if sendStatus == .willDelayBeforeNext {
-            // wait for pauseTimeBetweenMessages, then sendNextSysExMessage
+            // Wait until pauseTimeBetweenMessages after the previous message finished transmitting, then sendNextSysExMessage.
+            // That time is absolute, so it doesn't matter how late we were told that the previous message finished.
             sendStatus = .delayingBeforeNext
-            self.perform(#selector(sendNextSysExMessage), with: nil, afterDelay: pauseTimeBetweenMessages)
+            let pauseNanos = UInt64(pauseTimeBetweenMessages * 1_000_000_000)
+            let deadline = DispatchTime(uptimeNanoseconds: SMConvertHostTimeToNanos(previousMessageFinishHostTime) + pauseNanos)
+            let workItem = DispatchWorkItem { [weak self] in
+                self?.sendNextSysExMessage()
+            }
+            delayedSendWorkItem = workItem
+            DispatchQueue.main.asyncAfter(deadline: deadline, execute: workItem)
         }
         else if sendStatus == .cancelled {
             // The user cancelled before we got here, so finish the cancellation now
@@ -392,6 +438,19 @@ extension MIDIController /* Private */ {
 
     @objc private func customSysexBufferSizeChanged(_ notification: Notification) {
         outputStream.customSysExBufferSize = UserDefaults.standard.integer(forKey: Self.customSysexBufferSizePreferenceKey)
+        outputStream.destinationCustomSysExBufferSizes = Self.destinationCustomSysExBufferSizes
+    }
+
+    private static var destinationCustomSysExBufferSizes: [MIDIUniqueID: Int] {
+        // Property lists need string keys, so the unique IDs are saved as strings
+        let sizes = UserDefaults.standard.dictionary(forKey: destinationCustomSysexBufferSizesPreferenceKey) as? [String: Int] ?? [:]
+        // Different strings, like "1" and "01", can be the same ID. Don't crash; use the smaller size,
+        // which is the safer one for the destination.
+        // Sizes outside what the sysex scheduler accepts would make every send fail, so keep them in range.
+        // 0 still means to let CoreMIDI send the sysex.
+        return Dictionary(sizes.compactMap { key, size in
+            MIDIUniqueID(key).map { ($0, size > 0 ? min(max(size, 3), 32767) : 0) }
+        }, uniquingKeysWith: { min($0, $1) })
     }
 
 }
@@ -422,33 +481,52 @@ extension MIDIController: CombinationOutputStreamDelegate {
             cancelSendingMessages()
         }
 
-        selectFirstAvailableDestination()
+        if outputStream.selectedDestinations.isEmpty {
+            selectFirstAvailableDestination()
+        }
+        else {
+            // Other destinations are still selected
+            selectedDestinations = outputStream.selectedDestinations
+        }
     }
 
     // Sent when sysex begins sending and ends sending.
     func combinationOutputStream(_ stream: CombinationOutputStream, willBeginSendingSysEx request: SysExSendRequest) {
-        currentSendRequest = request
+        currentSendRequests.append(request)
     }
 
     func combinationOutputStream(_ stream: CombinationOutputStream, didEndSendingSysEx request: SysExSendRequest) {
         // NOTE: The request may or may not have finished successfully.
-        guard request == currentSendRequest else { return }
+        guard let requestIndex = currentSendRequests.firstIndex(of: request) else { return }
 
+        currentSendRequests.remove(at: requestIndex)
         bytesSent += request.bytesSent
+        wasCurrentMessageFullySent = wasCurrentMessageFullySent && request.wereAllBytesSent
+        previousMessageFinishHostTime = max(previousMessageFinishHostTime, request.finishHostTime)
+
+        if let statistics = request.timingStatistics,
+           UserDefaults.standard.bool(forKey: Self.logSysExSendTimingPreferenceKey) {
+            NSLog("Sent %d bytes in %d buffers at %.1f bytes/sec (intended %.0f), %d late; wake lateness mean %.3f ms, std dev %.3f ms, max %.3f ms",
+                  statistics.byteCount, statistics.bufferCount, statistics.actualBytesPerSecond, statistics.intendedBytesPerSecond, statistics.lateBufferCount,
+                  statistics.meanWakeLatenessNanos / 1.0e6, statistics.wakeLatenessStandardDeviationNanos / 1.0e6, Double(statistics.maxWakeLatenessNanos) / 1.0e6)
+        }
+
+        // Go on only when the message has been sent to every destination, so the pause between messages
+        // is measured from the slowest one
+        guard currentSendRequests.isEmpty else { return }
         sendingMessageIndex += 1
-        currentSendRequest = nil
 
         if sendStatus == .cancelled {
             sendStatus = .finishing
             finishedSendingMessages(success: false)
         }
-        else if sendingMessageIndex < sendingMessageCount && request.wereAllBytesSent {
+        else if sendingMessageIndex < sendingMessageCount && wasCurrentMessageFullySent {
             sendStatus = .willDelayBeforeNext
             sendNextSysExMessageAfterDelay()
         }
         else {
             sendStatus = .finishing
-            finishedSendingMessages(success: request.wereAllBytesSent)
+            finishedSendingMessages(success: wasCurrentMessageFullySent)
         }
 
     }
@@ -88,6 +88,20 @@ class MainWindowController: GeneralWindowController {
         }
     }
 
+    @IBAction func toggleAdditionalDestination(_ sender: Any?) {
+        if let menuItem = sender as? NSMenuItem,
+           let destination = menuItem.representedObject as? Destination {
+            var destinations = midiController.selectedDestinations
+            if let index = destinations.firstIndex(where: { $0 === destination }) {
+                destinations.remove(at: index)
+            }
+            else {
+                destinations.append(destination)
+            }
+            midiController.selectedDestinations = destinations
+        }
+    }
+
     @IBAction override func selectAll(_ sender: Any?) {
         // Forward to the library table view, even if it isn't the first responder
         libraryTableView.selectAll(sender)
@@ -188,6 +202,37 @@ class MainWindowController: GeneralWindowController {
         }
     }
 
+    @IBAction func selectDuplicates(_ sender: Any?) {
+        guard finishEditingWithoutError() else { return }
+
+        library.findDuplicateEntries { duplicateGroups in
+            // Leave the first entry in each group alone, and select the others, so they're easy to delete.
+            // Groups only have entries whose files are present, so the entry that's kept always has its file.
+            let duplicateEntries = Array(duplicateGroups.map { $0.dropFirst() }.joined())
+            if duplicateEntries.isEmpty {
+                guard let window = self.window else { return }
+
+                let alert = NSAlert()
+                alert.alertStyle = .informational
+                alert.messageText = String(localized: "No Duplicates Found", comment: "title of alert when no duplicate entries are found")
+                alert.informativeText = String(localized: "The SysEx in each entry in the library is different from all the others.", comment: "message when no duplicate entries are found")
+                alert.beginSheetModal(for: window, completionHandler: nil)
+            }
+            else {
+                self.selectedEntries = duplicateEntries
+                self.scrollToEntries(duplicateEntries)
+            }
+        }
+    }
+
+    @IBAction func search(_ sender: Any?) {
+        guard let searchField = sender as? NSSearchField else { return }
+
+        let selectedEntries = self.selectedEntries
+        libraryIndex.searchString = searchField.stringValue
+        reloadLibraryTableView(selecting: selectedEntries)
+    }
+
     @IBAction func saveAsStandardMIDI(_ sender: Any?) {
         guard finishEditingWithoutError() else { return }
 
@@ -222,10 +267,10 @@ class MainWindowController: GeneralWindowController {
             group.count > 0
         }
 
-        let currentDestination = midiController.selectedDestination
+        let currentDestinations = midiController.selectedDestinations
 
-        synchronizeDestinationPopUp(destinationGroups: groupedDestinations, currentDestination: currentDestination)
-        synchronizeDestinationToolbarMenu(destinationGroups: groupedDestinations, currentDestination: currentDestination)
+        synchronizeDestinationPopUp(destinationGroups: groupedDestinations, currentDestinations: currentDestinations)
+        synchronizeDestinationToolbarMenu(destinationGroups: groupedDestinations, currentDestinations: currentDestinations)
     }
 
     func synchronizeLibrarySortIndicator() {
@@ -239,7 +284,17 @@ class MainWindowController: GeneralWindowController {
         let selectedEntries = self.selectedEntries
 
         sortLibraryEntries()
+        reloadLibraryTableView(selecting: selectedEntries)
+    }
+
+    private func synchronizeLibrary(applying change: Library.Change) {
+        let selectedEntries = self.selectedEntries
 
+        libraryIndex.apply(change, allEntries: library.entries)
+        reloadLibraryTableView(selecting: selectedEntries)
+    }
+
+    private func reloadLibraryTableView(selecting selectedEntries: [LibraryEntry]) {
         // NOTE Some entries in selectedEntries may no longer be present in sortedLibraryEntries.
         // We don't need to manually take them out of selectedEntries because selectEntries can deal with
         // entries that are missing.
@@ -262,10 +317,11 @@ class MainWindowController: GeneralWindowController {
     }
 
     func addReadMessagesToLibrary() {
-        guard let allSysexData = SystemExclusiveMessage.data(forMessages: midiController.messages) else { return }
+        let messages = midiController.messages
+        guard !messages.isEmpty else { return }
 
         do {
-            if let entry = try library.addNewEntry(sysexData: allSysexData) {
+            if let entry = try library.addNewEntry(sysexMessages: messages) {
                 showNewEntries([entry])
             }
         }
@@ -284,7 +340,7 @@ class MainWindowController: GeneralWindowController {
     }
 
     func playEntry(withProgramNumber desiredProgramNumber: UInt8) {
-        if let entry = sortedLibraryEntries.first(where: { $0.programNumber == desiredProgramNumber }) {
+        if let entry = libraryIndex.firstEntry(withProgramNumber: desiredProgramNumber) {
             playController.playMessages(inEntryForProgramChange: entry)
         }
     }
@@ -299,12 +355,13 @@ class MainWindowController: GeneralWindowController {
             return selectedEntries
         }
         set {
-            libraryTableView.deselectAll(nil)
+            var rows = IndexSet()
             for entry in newValue {
-                if let row = sortedLibraryEntries.firstIndex(of: entry) {
-                    libraryTableView.selectRowIndexes(IndexSet(integer: row), byExtendingSelection: true)
+                if let row = libraryIndex.row(of: entry) {
+                    rows.insert(row)
                 }
             }
+            libraryTableView.selectRowIndexes(rows, byExtendingSelection: false)
         }
     }
 
@@ -315,7 +372,9 @@ class MainWindowController: GeneralWindowController {
 
     // Library
     private let library: Library
-    private var sortedLibraryEntries: [LibraryEntry] = []
+    private let libraryIndex = LibraryIndex()
+    private var sortedLibraryEntries: [LibraryEntry] { libraryIndex.visibleEntries }
+    private var libraryIndexNeedsReload = false
 
     // Subcontrollers
     private var midiController: MIDIController!
@@ -357,6 +416,8 @@ extension MainWindowController /* NSUserInterfaceValidations */ {
             return libraryTableView.numberOfSelectedRows == 1 && selectedEntries.first!.isFilePresent
         case #selector(changeProgramNumber(_:)):
             return libraryTableView.numberOfSelectedRows == 1 && programChangeTableColumn.tableView != nil
+        case #selector(selectDuplicates(_:)):
+            return library.entries.count > 1
         default:
             return super.validateUserInterfaceItem(item)
         }
@@ -618,7 +679,9 @@ extension MainWindowController /* Private */ {
 
     // MARK: Destination selections (popup and toolbar menu)
 
-    private func synchronizeDestinationPopUp(destinationGroups: [[OutputStreamDestination]], currentDestination: OutputStreamDestination?) {
+    private func synchronizeDestinationPopUp(destinationGroups: [[OutputStreamDestination]], currentDestinations: [OutputStreamDestination]) {
+        let currentDestination = currentDestinations.first
+
         // The pop up button redraws whenever it's changed, so use an animation group to stop the blinkiness
         NSAnimationContext.runAnimationGroup { _ in
             destinationPopUpButton.removeAllItems()
@@ -630,29 +693,37 @@ extension MainWindowController /* Private */ {
                 }
 
                 for destination in destinations {
-                    destinationPopUpButton.addItem(title: titleForDestination(destination) ?? "", representedObject: destination)
-
                     if !found && destination === currentDestination {
+                        destinationPopUpButton.addItem(title: titleForDestinations(currentDestinations) ?? "", representedObject: destination)
                         destinationPopUpButton.selectItem(at: destinationPopUpButton.numberOfItems - 1)
                         found = true
                     }
+                    else {
+                        destinationPopUpButton.addItem(title: titleForDestination(destination) ?? "", representedObject: destination)
+                    }
                 }
             }
 
+            if let menuItem = additionalDestinationsMenuItem(currentDestinations: currentDestinations) {
+                destinationPopUpButton.menu?.addItem(NSMenuItem.separator())
+                destinationPopUpButton.menu?.addItem(menuItem)
+            }
+
             if !found {
                 destinationPopUpButton.select(nil)
             }
         }
     }
 
-    private func synchronizeDestinationToolbarMenu(destinationGroups: [[OutputStreamDestination]], currentDestination: OutputStreamDestination?) {
+    private func synchronizeDestinationToolbarMenu(destinationGroups: [[OutputStreamDestination]], currentDestinations: [OutputStreamDestination]) {
         guard let toolbarItem = destinationToolbarItem else { return }
         // Set the title to "Destination: <Whatever>"
         // Then set up the submenu items
 
+        let currentDestination = currentDestinations.first
         let topMenuItem = toolbarItem.menuFormRepresentation
 
-        let selectedDestinationTitle = titleForDestination(currentDestination) ?? String(localized: "None", comment: "none")
+        let selectedDestinationTitle = titleForDestinations(currentDestinations) ?? String(localized: "None", comment: "none")
 
         let topTitle = String(localized: "Destination", comment: "title of destination toolbar item") + ": " + selectedDestinationTitle
         topMenuItem?.title = topTitle
@@ -678,6 +749,11 @@ extension MainWindowController /* Private */ {
                     }
                 }
             }
+
+            if let menuItem = additionalDestinationsMenuItem(currentDestinations: currentDestinations) {
+                submenu.addItem(NSMenuItem.separator())
+                submenu.addItem(menuItem)
+            }
         }
 
         // Workaround to get the toolbar item to refresh after we change the title of the menu item
@@ -697,55 +773,65 @@ extension MainWindowController /* Private */ {
         return title
     }
 
+    private func titleForDestinations(_ destinations: [OutputStreamDestination]) -> String? {
+        let title = titleForDestination(destinations.first)
+        guard let title, destinations.count > 1 else { return title }
+
+        let format = String(localized: "%@ and %ld more", comment: "format of title for several selected destinations: first destination name, count of others")
+        return String.localizedStringWithFormat(format, title, destinations.count - 1)
+    }
+
+    private func additionalDestinationsMenuItem(currentDestinations: [OutputStreamDestination]) -> NSMenuItem? {
+        // A submenu to add or remove other port destinations, so messages are sent to several at once.
+        // That's only possible when a port destination is selected.
+        guard let currentDestination = currentDestinations.first as? Destination else { return nil }
+        let otherDestinations = midiController.destinations.compactMap { $0 as? Destination }.filter { $0 !== currentDestination }
+        guard !otherDestinations.isEmpty else { return nil }
+
+        let submenu = NSMenu()
+        for destination in otherDestinations {
+            let menuItem = submenu.addItem(withTitle: titleForDestination(destination) ?? "", action: #selector(toggleAdditionalDestination(_:)), keyEquivalent: "")
+            menuItem.representedObject = destination
+            menuItem.target = self
+            menuItem.state = currentDestinations.contains { $0 === destination } ? .on : .off
+        }
+
+        let menuItem = NSMenuItem(title: String(localized: "Also Send To", comment: "title of submenu of additional destinations"), action: nil, keyEquivalent: "")
+        menuItem.submenu = submenu
+        return menuItem
+    }
+
     // MARK: Library interaction
 
     @objc private func libraryDidChange(_ notification: Notification) {
-        // Reloading the table view will wipe out the edit session, so don't do that if we're editing
+        // Reloading the table view will wipe out the edit session, so don't do that if we're editing.
+        // We'll miss this change, though, so reindex everything next time.
         if libraryTableView.editedRow == -1 {
-            synchronizeLibrary()
+            if !libraryIndexNeedsReload,
+               let change = notification.userInfo?[Library.changeUserInfoKey] as? Library.Change {
+                synchronizeLibrary(applying: change)
+            }
+            else {
+                synchronizeLibrary()
+            }
+        }
+        else {
+            libraryIndexNeedsReload = true
         }
     }
 
     private func sortLibraryEntries() {
-        let sortedEntries = library.entries.sorted(by: { (entry1, entry2) -> Bool in
-            switch sortColumnIdentifier {
-            case "name":
-                return (entry1.name ?? "") < (entry2.name ?? "")
-            case "manufacturer":
-                return (entry1.manufacturer ?? "") < (entry2.manufacturer ?? "")
-            case "size":
-                return (entry1.size ?? -1) < (entry2.size ?? -1)
-            case "messageCount":
-                return (entry1.messageCount ?? 0) < (entry2.messageCount ?? 0)
-            case "programNumber":
-                func massagedProgramNumber(entry: LibraryEntry) -> Int {
-                    if let value = entry.programNumber {
-                        return Int(value)
-                    }
-                    else {
-                        return -1
-                    }
-                }
-                return massagedProgramNumber(entry: entry1) < massagedProgramNumber(entry: entry2)
-            default:
-                fatalError()
-            }
-        })
-
-        self.sortedLibraryEntries = isSortAscending ? sortedEntries : sortedEntries.reversed()
+        libraryIndex.reload(library.entries, sortKey: LibraryIndex.SortKey(rawValue: sortColumnIdentifier)!, ascending: isSortAscending)
+        libraryIndexNeedsReload = false
     }
 
     private func scrollToEntries(_ entries: [LibraryEntry]) {
         guard entries.count > 0 else { return }
 
-        var lowestRow = Int.max
-        for entry in entries {
-            if let row = sortedLibraryEntries.firstIndex(of: entry) {
-                lowestRow = min(lowestRow, row)
-            }
+        let lowestRow = entries.compactMap { libraryIndex.row(of: $0) }.min()
+        if let lowestRow {
+            libraryTableView.scrollRowToVisible(lowestRow)
         }
-
-        libraryTableView.scrollRowToVisible(lowestRow)
     }
 
     // MARK: Doing things with selected entries
@@ -862,7 +948,9 @@ extension MainWindowController: NSToolbarDelegate {
             NSToolbarItem.Identifier("DestinationPopup"),
             .flexibleSpace,
             NSToolbarItem.Identifier("RecordOne"),
-            NSToolbarItem.Identifier("RecordMany")
+            NSToolbarItem.Identifier("RecordMany"),
+            .space,
+            NSToolbarItem.Identifier("Search")
         ]
     }
 
@@ -871,6 +959,16 @@ extension MainWindowController: NSToolbarDelegate {
     }
 
     func toolbar(_ toolbar: NSToolbar, itemForItemIdentifier itemIdentifier: NSToolbarItem.Identifier, willBeInsertedIntoToolbar flag: Bool) -> NSToolbarItem? {
+        if itemIdentifier.rawValue == "Search" {
+            let searchToolbarItem = NSSearchToolbarItem(itemIdentifier: itemIdentifier)
+            searchToolbarItem.label = "Search"
+            searchToolbarItem.toolTip = "Show only the files whose name or manufacturer contain this text"
+            searchToolbarItem.searchField.sendsSearchStringImmediately = true
+            searchToolbarItem.searchField.target = self
+            searchToolbarItem.searchField.action = #selector(search(_:))
+            return searchToolbarItem
+        }
+
         let toolbarItem = NSToolbarItem(itemIdentifier: itemIdentifier)
         toolbarItem.isEnabled = true
 
@@ -188,6 +188,8 @@ extension PlayController /* Private */ {
     static private var sendingFormatString = String(localized: "Sending message %u of %u…", comment: "format for progress message when sending multiple sysex messages")
     static private var sendingString = String(localized: "Sending message…", comment: "format for progress message when sending multiple sysex messages")
     static private var doneString = String(localized: "Done.", comment: "Done.")
+    static private var sendingToDestinationsFormatString = String(localized: "Sending message %u of %u to %ld destinations…", comment: "format for progress message when sending multiple sysex messages to multiple destinations")
+    static private var sendingOneToDestinationsFormatString = String(localized: "Sending message to %ld destinations…", comment: "format for progress message when sending one sysex message to multiple destinations")
 
     private func updateProgress() {
         guard let sendStatus = midiController?.messageSendStatus else { return }
@@ -197,7 +199,16 @@ extension PlayController /* Private */ {
 
         let message: String
         if sendStatus.bytesSent < sendStatus.bytesToSend {
-            if sendStatus.messageCount > 1 {
+            // The progress is for all destinations together, so it's as far along as the slowest one
+            if sendStatus.destinationCount > 1 {
+                if sendStatus.messageCount > 1 {
+                    message = String(format: Self.sendingToDestinationsFormatString, sendStatus.messageIndex + 1, sendStatus.messageCount, sendStatus.destinationCount)
+                }
+                else {
+                    message = String(format: Self.sendingOneToDestinationsFormatString, sendStatus.destinationCount)
+                }
+            }
+            else if sendStatus.messageCount > 1 {
                 message = String(format: Self.sendingFormatString, sendStatus.messageIndex + 1, sendStatus.messageCount)
             }
             else {
@@ -30,6 +30,10 @@ class SysExSpeedController: NSObject {
             dataCell.target = self
             dataCell.action = #selector(self.takeSpeedFromSelectedCellInTableView)
         }
+
+        let menu = NSMenu()
+        menu.addItem(withTitle: String(localized: "Calibrate Speed…", comment: "menu item to calibrate the sysex speed of a destination"), action: #selector(self.calibrateSpeed(_:)), keyEquivalent: "").target = self
+        outlineView.menu = menu
     }
 
     func willShow() {
@@ -93,6 +97,37 @@ class SysExSpeedController: NSObject {
         NotificationCenter.default.post(name: .customSysexBufferSizePreferenceChanged, object: nil)
     }
 
+    @IBAction func calibrateSpeed(_ sender: Any?) {
+        guard let destination = outlineView.item(atRow: outlineView.clickedRow) as? Destination,
+              let window = outlineView.window else { return }
+
+        let sources = midiContext.sources
+        guard !sources.isEmpty else { return }
+
+        // Ask which source the destination's output comes back in through
+        let alert = NSAlert()
+        let messageFormat = String(localized: "Calibrate the speed of “%@”?", comment: "title of alert before calibrating sysex speed")
+        alert.messageText = String.localizedStringWithFormat(messageFormat, destination.displayName ?? "")
+        alert.informativeText = String(localized: "Test messages will be sent faster and faster, to find the fastest speed and the buffer size that work reliably. Connect the device's output to one of this computer's inputs, or set the device to echo what it receives, and choose that input.", comment: "message of alert before calibrating sysex speed")
+        alert.addButton(withTitle: String(localized: "Calibrate", comment: "Calibrate button in alert before calibrating sysex speed"))
+        alert.addButton(withTitle: String(localized: "Cancel", comment: "Cancel button in alert"))
+        let sourcePopUpButton = NSPopUpButton(frame: NSRect(x: 0, y: 0, width: 240, height: 26), pullsDown: false)
+        for source in sources {
+            sourcePopUpButton.addItem(withTitle: source.displayName ?? "")
+            sourcePopUpButton.lastItem?.representedObject = source
+        }
+        alert.accessoryView = sourcePopUpButton
+
+        alert.beginSheetModal(for: window) { response in
+            guard response == .alertFirstButtonReturn,
+                  let source = sourcePopUpButton.selectedItem?.representedObject as? Source else { return }
+            // Let this sheet go away before showing the next one
+            DispatchQueue.main.async {
+                self.calibrateSpeed(destination: destination, source: source)
+            }
+        }
+    }
+
     // MARK: Private
 
     @IBOutlet var outlineView: NSOutlineView!
@@ -103,6 +138,8 @@ class SysExSpeedController: NSObject {
     var trackingMIDIObject: MIDIObject?
     var speedOfTrackingMIDIObject: Int = 0
 
+    var calibrator: SysExSpeedCalibrator?
+
     var midiContext: MIDIContext {
         ((NSApp.delegate as? AppController)?.midiContext)!
     }
@@ -155,6 +192,87 @@ class SysExSpeedController: NSObject {
          }
      }
 
+    func calibrateSpeed(destination: Destination, source: Source) {
+        guard let window = outlineView.window else { return }
+
+        let calibrator = SysExSpeedCalibrator(destination: destination, source: source)
+        self.calibrator = calibrator
+
+        // Show each try as it finishes, with a button to stop
+        let alert = NSAlert()
+        alert.messageText = String(localized: "Calibrating Speed", comment: "title of alert while calibrating sysex speed")
+        alert.informativeText = String(localized: "Sending test messages…", comment: "message of alert while calibrating sysex speed")
+        alert.addButton(withTitle: String(localized: "Stop", comment: "Stop button in alert while calibrating sysex speed"))
+        let statusField = NSTextField(labelWithString: "")
+        statusField.frame = NSRect(x: 0, y: 0, width: 300, height: 17)
+        alert.accessoryView = statusField
+
+        alert.beginSheetModal(for: window) { response in
+            if response == .alertFirstButtonReturn /* Stop */ {
+                calibrator.cancel()
+                self.calibrator = nil
+            }
+        }
+
+        let trialFormat = String(localized: "%1$ld bytes/sec, buffer size %2$@: %3$@", comment: "format for each try while calibrating sysex speed")
+        calibrator.trialHandler = { trial in
+            let result = trial.succeeded ? String(localized: "OK", comment: "result of a successful try while calibrating sysex speed") : String(localized: "Failed", comment: "result of a failed try while calibrating sysex speed")
+            statusField.stringValue = String.localizedStringWithFormat(trialFormat, trial.bytesPerSecond, Self.titleForBufferSize(trial.bufferSize), result)
+        }
+
+        calibrator.start { result in
+            self.calibrator = nil
+            window.endSheet(alert.window, returnCode: .stop)
+
+            if let bytesPerSecond = result.bytesPerSecond {
+                self.useCalibratedSpeed(bytesPerSecond, bufferSize: result.bufferSize, destination: destination)
+            }
+
+            // Let this sheet go away before showing the next one
+            DispatchQueue.main.async {
+                self.showCalibrationResult(result, destination: destination)
+            }
+        }
+    }
+
+    func useCalibratedSpeed(_ bytesPerSecond: Int, bufferSize: Int, destination: Destination) {
+        // The speed was measured through the destination and its external devices together
+        for midiObject in [destination] + destination.connectedExternalDevices {
+            midiObject.maxSysExSpeed = Int32(bytesPerSecond)
+        }
+        midiContext.forceCoreMIDIToUseNewSysExSpeed()
+
+        // Remember the buffer size for this destination even if it's the default (0), since it
+        // overrides the buffer size chosen for all destinations
+        let defaults = UserDefaults.standard
+        var bufferSizes = defaults.dictionary(forKey: MIDIController.destinationCustomSysexBufferSizesPreferenceKey) ?? [:]
+        bufferSizes[String(destination.uniqueID)] = bufferSize
+        defaults.set(bufferSizes, forKey: MIDIController.destinationCustomSysexBufferSizesPreferenceKey)
+        NotificationCenter.default.post(name: .customSysexBufferSizePreferenceChanged, object: nil)
+    }
+
+    func showCalibrationResult(_ result: SysExSpeedCalibrator.Result, destination: Destination) {
+        guard let window = outlineView.window else { return }
+
+        // With no buttons added, the alert has an OK button
+        let alert = NSAlert()
+        if let bytesPerSecond = result.bytesPerSecond {
+            alert.messageText = String(localized: "Calibration Finished", comment: "title of alert after calibrating sysex speed")
+            let informativeFormat = String(localized: "“%1$@” will be sent sysex at %2$ld bytes/sec, with buffer size %3$@.", comment: "format of message after calibrating sysex speed")
+            alert.informativeText = String.localizedStringWithFormat(informativeFormat, destination.displayName ?? "", bytesPerSecond, Self.titleForBufferSize(result.bufferSize))
+        }
+        else {
+            alert.messageText = String(localized: "Calibration Failed", comment: "title of alert when no sysex speed worked")
+            alert.informativeText = String(localized: "None of the test messages came back correctly. Check that the device's output is connected to the input you chose. The speed has not been changed.", comment: "message of alert when no sysex speed worked")
+            alert.alertStyle = .warning
+        }
+        alert.beginSheetModal(for: window, completionHandler: nil)
+    }
+
+    static func titleForBufferSize(_ bufferSize: Int) -> String {
+        bufferSize == 0 ? String(localized: "Default", comment: "title of default sysex buffer size") : String(bufferSize)
+    }
+
     func effectiveSpeedForItem(_ item: MIDIObject) -> Int {
         var effectiveSpeed = (item == trackingMIDIObject) ? speedOfTrackingMIDIObject : Int(item.maxSysExSpeed)
 
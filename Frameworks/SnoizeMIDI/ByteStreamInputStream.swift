@@ -0,0 +1,159 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public class ByteStreamInputStream: InputStream {
+
+    // Reads MIDI from a stream of raw bytes, like a file of MIDI data or a pipe, instead of from CoreMIDI.
+    //
+    // Give it bytes with takeBytes(), in chunks of any size. The parser only puts a message together from
+    // the bytes of one packet (except for sysex), so if a chunk ends partway through a message, the start of
+    // the message is held until the rest of it arrives. Call finish() at the end of the stream.
+    //
+    // The bytes are parsed right away, and the messages get the time they were parsed as their time stamps.
+    // Like other input streams, only use it on the main queue.
+
+    public init(midiContext: MIDIContext, name: String) {
+        singleSource = SingleInputStreamSource(name: name)
+        packetListPtr = UnsafeMutableRawPointer.allocate(byteCount: Self.packetListSize, alignment: MemoryLayout<MIDIPacketList>.alignment).bindMemory(to: MIDIPacketList.self, capacity: 1)
+
+        super.init(midiContext: midiContext)
+
+        parser = createParser(originatingEndpoint: nil)
+    }
+
+    deinit {
+        packetListPtr.deallocate()
+    }
+
+    public func takeBytes(_ data: Data) {
+        heldBytes.append(contentsOf: data)
+        let completeCount = Self.completeEndIndex(heldBytes[...], lastStatus: lastStatus)
+        parse(heldBytes[..<completeCount])
+        heldBytes.removeFirst(completeCount)
+    }
+
+    // Parses any bytes that are being held, and finishes any sysex message that wasn't terminated
+    public func finish() {
+        parse(heldBytes[...])
+        heldBytes = []
+        lastStatus = 0
+        parser.finishReceivingSysExMessage()
+    }
+
+    // MARK: InputStream subclass
+
+    public override var parsers: [MessageParser] {
+        [parser]
+    }
+
+    public override func parser(sourceConnectionRefCon refCon: UnsafeMutableRawPointer?) -> MessageParser? {
+        parser
+    }
+
+    public override func streamSource(parser: MessageParser) -> InputStreamSource? {
+        singleSource.asInputStreamSource
+    }
+
+    public override var inputSources: [InputStreamSource] {
+        [singleSource.asInputStreamSource]
+    }
+
+    public override var selectedInputSources: Set<InputStreamSource> {
+        get {
+            [singleSource.asInputStreamSource]
+        }
+        set {
+            // The one source is always selected
+        }
+    }
+
+    // MARK: Private
+
+    private let singleSource: SingleInputStreamSource
+    private var parser: MessageParser!
+
+    private var heldBytes: [UInt8] = []
+    private var lastStatus: UInt8 = 0     // the last status byte that was parsed, not counting real time
+
+    private static let packetListSize = 65536
+    private static let maxPacketDataLength = packetListSize - MemoryLayout.offset(of: \MIDIPacketList.packet.data)!
+    private let packetListPtr: UnsafeMutablePointer<MIDIPacketList>
+
+    private static func isStatus(_ byte: UInt8) -> Bool {
+        // Real time messages can be anywhere, even in the middle of another message, so they don't count
+        (0x80 ..< 0xF8).contains(byte)
+    }
+
+    private static func dataCount(_ status: UInt8) -> Int {
+        switch status {
+        case 0x80 ..< 0xC0, 0xE0 ..< 0xF0, 0xF2:
+            return 2
+        case 0xC0 ..< 0xE0, 0xF1, 0xF3:
+            return 1
+        default:
+            // Sysex can be continued in the next packet, and the rest of the messages have no data
+            return 0
+        }
+    }
+
+    private static func completeEndIndex(_ bytes: ArraySlice<UInt8>, lastStatus: UInt8) -> Int {
+        // Where the complete messages in `bytes` end. Everything can be parsed, unless the bytes end
+        // partway through a message. `lastStatus` is the status in effect before `bytes`.
+        let statusIndex = bytes.lastIndex(where: isStatus)
+        let status = statusIndex.map { bytes[$0] } ?? lastStatus
+        let dataCount = Self.dataCount(status)
+        guard dataCount > 0 else { return bytes.endIndex }
+
+        let dataStart = statusIndex.map { $0 + 1 } ?? bytes.startIndex
+        let dataIndexes = bytes.indices[dataStart...].filter { bytes[$0] < 0x80 }
+        if status < 0xF0 {
+            // Voice messages may use running status, so there may be several messages after the status byte.
+            // Hold the last one if it's incomplete. If the status byte is held too, the parser will see it again.
+            if dataIndexes.isEmpty {
+                return statusIndex ?? bytes.endIndex
+            }
+            let incompleteCount = dataIndexes.count % dataCount
+            guard incompleteCount > 0 else { return bytes.endIndex }
+            return dataIndexes.count > incompleteCount ? dataIndexes[dataIndexes.count - incompleteCount] : (statusIndex ?? bytes.startIndex)
+        }
+        else {
+            // System common messages don't use running status. Anything after a complete one is invalid anyway.
+            guard let statusIndex, dataIndexes.count < dataCount else { return bytes.endIndex }
+            return statusIndex
+        }
+    }
+
+    private func parse(_ bytes: ArraySlice<UInt8>) {
+        var start = bytes.startIndex
+        while start < bytes.endIndex {
+            // Split into packets between messages, if possible. The parser doesn't put a message together
+            // across packets, and a flood of running status messages may have no status byte to split at.
+            var end = min(start + Self.maxPacketDataLength, bytes.endIndex)
+            if end < bytes.endIndex {
+                let messageEnd = Self.completeEndIndex(bytes[start ..< end], lastStatus: lastStatus)
+                if messageEnd > start {
+                    end = messageEnd
+                }
+            }
+
+            bytes[start ..< end].withUnsafeBufferPointer { buffer in
+                // A time stamp of 0 means the parser uses the current time
+                let packetPtr = MIDIPacketListInit(packetListPtr)
+                _ = SMWorkaroundMIDIPacketListAdd(packetListPtr, Self.packetListSize, packetPtr, 0, buffer.count, buffer.baseAddress!)
+            }
+            parser.takePacketList(packetListPtr)
+
+            if let status = bytes[start ..< end].last(where: Self.isStatus) {
+                lastStatus = status
+            }
+            start = end
+        }
+    }
+
+}
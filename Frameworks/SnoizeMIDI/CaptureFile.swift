@@ -0,0 +1,170 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+// A compact binary format for streaming captured messages to disk.
+//
+// A capture file starts with an 8-byte signature, followed by a sequence of records,
+// one per message. All integers are little-endian. Each record is:
+//
+//     UInt32   length of the rest of the record, in bytes
+//     UInt64   timestamp, in nanoseconds of host time
+//     Float64  clock timestamp (like Date.timeIntervalSinceReferenceDate), or 0 if unknown
+//     UInt8    flags (see RecordFlags)
+//     UInt8    length of the originating endpoint name, in bytes
+//     ...      originating endpoint name, UTF-8
+//     ...      message data, starting with the status byte
+//
+// Unlike a MIDI Monitor document, records can be appended without rewriting anything
+// that came before them. If a file is cut off in the middle of a record (say, because
+// the app crashed), everything up to the last complete record is still readable.
+
+public enum CaptureFile {
+
+    public static let signature = Data("SMCAPT01".utf8)
+    public static let fileExtension = "midicapture"
+
+    struct RecordFlags: OptionSet {
+        let rawValue: UInt8
+
+        static let timeStampWasZero = Self(rawValue: 1 << 0)
+        static let receivedWithEOX  = Self(rawValue: 1 << 1)
+    }
+
+    // Size of the fixed part of a record, after the length field
+    static let recordHeaderLength = 8 + 8 + 1 + 1
+
+    // `hostTimeInNanos` is the message's hostTimeStamp, already converted, so callers can convert
+    // a whole batch of timestamps at once (see SMConvertHostTimesToNanos).
+    static func appendRecord(for message: Message, hostTimeInNanos: UInt64, to data: inout Data) {
+        var flags: RecordFlags = []
+        if message.timeStampWasZeroWhenReceived {
+            flags.insert(.timeStampWasZero)
+        }
+
+        // For sysex, keep the data as it was received, which may or may not end in 0xF7.
+        let otherData: Data?
+        if let sysExMessage = message as? SystemExclusiveMessage {
+            otherData = sysExMessage.receivedData
+            if sysExMessage.wasReceivedWithEOX {
+                flags.insert(.receivedWithEOX)
+            }
+        }
+        else {
+            otherData = message.otherData
+        }
+
+        // Endpoint names are limited to 255 bytes. Cut them off at a character boundary.
+        var endpointNameString = message.originatingEndpointForDisplay
+        while endpointNameString.utf8.count > 255 {
+            endpointNameString.removeLast()
+        }
+        let endpointName = Array(endpointNameString.utf8)
+
+        let recordLength = recordHeaderLength + endpointName.count + 1 + (otherData?.count ?? 0)
+
+        data.appendLittleEndian(UInt32(recordLength))
+        data.appendLittleEndian(hostTimeInNanos)
+        data.appendLittleEndian((message.clockTimeStamp ?? 0).bitPattern)
+        data.append(flags.rawValue)
+        data.append(UInt8(endpointName.count))
+        data.append(contentsOf: endpointName)
+        data.append(message.statusByte)
+        if let otherData {
+            data.append(otherData)
+        }
+    }
+
+    // Reads the messages from a capture file. If the file ends with an incomplete record, that record is ignored.
+    public static func readMessages(at url: URL) throws -> [Message] {
+        let data = try Data(contentsOf: url, options: .mappedIfSafe)
+        guard let messages = messages(from: data) else {
+            throw CocoaError(.fileReadCorruptFile, userInfo: [NSURLErrorKey: url])
+        }
+        return messages
+    }
+
+    // Returns nil if the data doesn't start with the signature.
+    // Messages don't remember their originating endpoints, or whether their time stamps were originally 0.
+    public static func messages(from data: Data) -> [Message]? {
+        guard data.starts(with: signature) else { return nil }
+
+        var messages: [Message] = []
+        var offset = data.startIndex + signature.count
+        while offset + 4 <= data.endIndex {
+            let recordLength = Int(data.littleEndianValue(at: offset) as UInt32)
+            let recordStart = offset + 4
+            let recordEnd = recordStart + recordLength
+            guard recordLength > recordHeaderLength, recordEnd <= data.endIndex else { break }
+
+            let hostTimeInNanos: UInt64 = data.littleEndianValue(at: recordStart)
+            let flags = RecordFlags(rawValue: data[recordStart + 16])
+            let endpointNameLength = Int(data[recordStart + 17])
+            let statusByteIndex = recordStart + recordHeaderLength + endpointNameLength
+            guard statusByteIndex < recordEnd else { break }
+
+            let message = makeMessage(timeStamp: SMConvertNanosToHostTime(hostTimeInNanos), statusByte: data[statusByteIndex], otherData: Data(data[(statusByteIndex + 1) ..< recordEnd]), flags: flags)
+            messages.append(message)
+
+            offset = recordEnd
+        }
+
+        return messages
+    }
+
+    private static func makeMessage(timeStamp: MIDITimeStamp, statusByte: UInt8, otherData: Data, flags: RecordFlags) -> Message {
+        // Only make the kind of message that the bytes are valid for, since messages can't hold invalid data
+        let dataBytes = Array(otherData)
+        let areDataBytesValid = dataBytes.allSatisfy { $0 < 0x80 }
+
+        switch statusByte {
+        case 0x80 ..< 0xF0:
+            let dataLength = (0xC0 ..< 0xE0).contains(statusByte & 0xF0) ? 1 : 2
+            if dataBytes.count == dataLength && areDataBytesValid {
+                return VoiceMessage(timeStamp: timeStamp, statusByte: statusByte, data: dataBytes)
+            }
+
+        case 0xF0:
+            // Sysex was recorded as it was received, so it only ends in 0xF7 if it was received that way
+            let receivedWithEOX = flags.contains(.receivedWithEOX)
+            let message = SystemExclusiveMessage(timeStamp: timeStamp, data: receivedWithEOX ? otherData.dropLast() : otherData)
+            message.wasReceivedWithEOX = receivedWithEOX
+            return message
+
+        default:
+            if let status = SystemCommonMessage.Status(rawValue: statusByte) {
+                if dataBytes.count == status.otherDataLength && areDataBytesValid {
+                    return SystemCommonMessage(timeStamp: timeStamp, status: status, data: dataBytes)
+                }
+            }
+            else if let type = SystemRealTimeMessage.MessageType(rawValue: statusByte) {
+                if dataBytes.isEmpty {
+                    return SystemRealTimeMessage(timeStamp: timeStamp, type: type)
+                }
+            }
+        }
+
+        // Invalid messages were recorded with a status byte of 0, followed by their data
+        return InvalidMessage(timeStamp: timeStamp, data: statusByte == 0 ? otherData : Data([statusByte]) + otherData)
+    }
+
+}
+
+extension Data {
+
+    mutating func appendLittleEndian<T: FixedWidthInteger>(_ value: T) {
+        Swift.withUnsafeBytes(of: value.littleEndian) { append(contentsOf: $0) }
+    }
+
+    func littleEndianValue<T: FixedWidthInteger>(at index: Index) -> T {
+        var value: T = 0
+        Swift.withUnsafeMutableBytes(of: &value) { _ = copyBytes(to: $0, from: index ..< index + MemoryLayout<T>.size) }
+        return T(littleEndian: value)
+    }
+
+}
@@ -18,6 +18,8 @@ protocol CoreMIDIContext: AnyObject {
     var interface: CoreMIDIInterface { get }
     var client: MIDIClientRef { get }
 
+    var sysExScheduler: SysExScheduler { get }
+
     func forcePropertyChanged(_ type: MIDIObjectType, _ objectRef: MIDIObjectRef, _ property: CFString)
 
     func generateNewUniqueID() -> MIDIUniqueID
@@ -68,8 +68,14 @@ protocol CoreMIDIInterface {
 
     func sendSysex(_ request: UnsafeMutablePointer<MIDISysexSendRequest>) -> OSStatus
 
+    func received(_ src: MIDIEndpointRef, _ pktlist: UnsafePointer<MIDIPacketList>) -> OSStatus
+
+    func flushOutput(_ dest: MIDIEndpointRef) -> OSStatus
+
     func inputPortCreateWithBlock(_ client: MIDIClientRef, _ portName: CFString, _ outPort: UnsafeMutablePointer<MIDIPortRef>, _ readBlock: @escaping MIDIReadBlock) -> OSStatus
 
+    func inputPortCreateWithProtocol(_ client: MIDIClientRef, _ portName: CFString, _ protocol: MIDIProtocolID, _ outPort: UnsafeMutablePointer<MIDIPortRef>, _ receiveBlock: @escaping MIDIReceiveBlock) -> OSStatus
+
     func outputPortCreate(_ client: MIDIClientRef, _ portName: CFString, _ outPort: UnsafeMutablePointer<MIDIPortRef>) -> OSStatus
 
     func portConnectSource(_ port: MIDIPortRef, _ source: MIDIEndpointRef, _ connRefCon: UnsafeMutableRawPointer?) -> OSStatus
@@ -206,10 +212,22 @@ struct RealCoreMIDIInterface: CoreMIDIInterface {
         MIDISendSysex(request)
     }
 
+    func received(_ src: MIDIEndpointRef, _ pktlist: UnsafePointer<MIDIPacketList>) -> OSStatus {
+        MIDIReceived(src, pktlist)
+    }
+
+    func flushOutput(_ dest: MIDIEndpointRef) -> OSStatus {
+        MIDIFlushOutput(dest)
+    }
+
     public func inputPortCreateWithBlock(_ client: MIDIClientRef, _ portName: CFString, _ outPort: UnsafeMutablePointer<MIDIPortRef>, _ readBlock: @escaping MIDIReadBlock) -> OSStatus {
         MIDIInputPortCreateWithBlock(client, portName, outPort, readBlock)
     }
 
+    func inputPortCreateWithProtocol(_ client: MIDIClientRef, _ portName: CFString, _ protocol: MIDIProtocolID, _ outPort: UnsafeMutablePointer<MIDIPortRef>, _ receiveBlock: @escaping MIDIReceiveBlock) -> OSStatus {
+        MIDIInputPortCreateWithProtocol(client, portName, `protocol`, outPort, receiveBlock)
+    }
+
     func outputPortCreate(_ client: MIDIClientRef, _ portName: CFString, _ outPort: UnsafeMutablePointer<MIDIPortRef>) -> OSStatus {
         MIDIOutputPortCreate(client, portName, outPort)
     }
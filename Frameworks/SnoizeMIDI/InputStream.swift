@@ -15,12 +15,21 @@ open class InputStream {
 
     public let midiContext: MIDIContext
     public weak var delegate: InputStreamDelegate?
-    public weak var messageDestination: MessageDestination?
+    public weak var messageDestination: MessageDestination? {
+        didSet {
+            // Converting Universal MIDI Packets to messages is only worth doing if someone will take the messages
+            parsers.forEach { $0.convertsUniversalMIDIPackets = messageDestination != nil }
+        }
+    }
+    // Gets Universal MIDI Packets, from subclasses that receive them
+    public weak var universalMIDIPacketDestination: UniversalMIDIPacketDestination?
     public var sysExTimeOut: TimeInterval = 1.0 {
         didSet {
             parsers.forEach { $0.sysExTimeOut = sysExTimeOut }
         }
     }
+    // Measures how long messages take to get from CoreMIDI to the message destination
+    public var latencyMonitor: LatencyMonitor?
 
     public func cancelReceivingSysExMessage() {
         parsers.forEach { $0.cancelReceivingSysExMessage() }
@@ -82,10 +91,19 @@ open class InputStream {
         self?.midiRead(packetListPtr, srcConnRefCon)
     }
 
+    // MIDIReceiveBlock to be passed to functions like MIDIInputPortCreateWithProtocol()
+    public lazy var midiReceiveBlock: MIDIReceiveBlock = { [weak self] (eventListPtr, srcConnRefCon) in
+        // NOTE: This function is called in a high-priority, time-constraint thread,
+        // created for us by CoreMIDI.
+
+        self?.midiReceive(eventListPtr, srcConnRefCon)
+    }
+
     public func createParser(originatingEndpoint: Endpoint?) -> MessageParser {
         let parser = MessageParser()
         parser.delegate = self
         parser.sysExTimeOut = sysExTimeOut
+        parser.convertsUniversalMIDIPackets = messageDestination != nil
         parser.originatingEndpoint = originatingEndpoint
         return parser
     }
@@ -126,12 +144,29 @@ open class InputStream {
         }
     }
 
+    // MARK: Private
+
+    // When the packets that CoreMIDI gave us are being parsed, the host time when they arrived. Otherwise 0.
+    private var arrivalHostTime: MIDITimeStamp = 0
+
 }
 
 extension InputStream: MessageParserDelegate {
 
     public func parserDidReadMessages(_ parser: MessageParser, messages: [Message]) {
+        // Messages that the parser finished on its own, like sysex that timed out, didn't just arrive, so don't measure them
+        guard let latencyMonitor, arrivalHostTime != 0 else {
+            messageDestination?.takeMIDIMessages(messages)
+            return
+        }
+
+        let parsedHostTime = SMGetCurrentHostTime()
         messageDestination?.takeMIDIMessages(messages)
+        latencyMonitor.record(arrivalHostTime: arrivalHostTime, parsedHostTime: parsedHostTime, processedHostTime: SMGetCurrentHostTime(), messages: messages, endpoint: parser.originatingEndpoint)
+    }
+
+    public func parserDidReadUniversalMIDIPackets(_ parser: MessageParser, packets: [UniversalMIDIPacket]) {
+        universalMIDIPacketDestination?.takeUniversalMIDIPackets(packets)
     }
 
     public func parserIsReadingSysEx(_ parser: MessageParser, length: Int) {
@@ -180,6 +215,8 @@ extension InputStream /* Private */ {
         let numPackets = packetListPtr.pointee.numPackets
         guard numPackets > 0 else { return }
 
+        let arrivalHostTime = SMGetCurrentHostTime()
+
         let packetListSize: Int
         if #available(macOS 10.15, iOS 13.0, *) {
             packetListSize = MIDIPacketList.sizeInBytes(pktList: packetListPtr)
@@ -200,7 +237,34 @@ extension InputStream /* Private */ {
                     // Find the parser that is associated with this particular connection
                     // (which may be nil, if the input stream was disconnected from this source)
                     // and give it the packet list.
+                    self.arrivalHostTime = arrivalHostTime
                     self.parser(sourceConnectionRefCon: srcConnRefCon)?.takePacketList(packetListPtr)
+                    self.arrivalHostTime = 0
+                }
+            }
+        }
+    }
+
+    fileprivate func midiReceive(_ eventListPtr: UnsafePointer<MIDIEventList>, _ srcConnRefCon: UnsafeMutableRawPointer?) {
+        // NOTE: This function is called in a high-priority, time-constraint thread,
+        // created for us by CoreMIDI. See the notes in midiRead().
+
+        let numPackets = eventListPtr.pointee.numPackets
+        guard numPackets > 0 else { return }
+
+        let arrivalHostTime = SMGetCurrentHostTime()
+
+        // Copy the event list for later
+        let data = Data(bytes: eventListPtr, count: MIDIEventList.sizeInBytes(pktList: eventListPtr))
+
+        // And process it on the queue
+        DispatchQueue.main.async {
+            autoreleasepool {
+                data.withUnsafeBytes { (rawPtr: UnsafeRawBufferPointer) in
+                    let eventListPtr = rawPtr.bindMemory(to: MIDIEventList.self).baseAddress!
+                    self.arrivalHostTime = arrivalHostTime
+                    self.parser(sourceConnectionRefCon: srcConnRefCon)?.takeEventList(eventListPtr)
+                    self.arrivalHostTime = 0
                 }
             }
         }
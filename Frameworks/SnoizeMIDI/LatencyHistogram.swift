@@ -0,0 +1,120 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public struct LatencyHistogram {
+
+    // Counts latencies, in nanoseconds, in the style of HdrHistogram: every value is put in a bin
+    // whose width is less than 1% of the value, from 1 ns to over a minute, using a fixed amount of memory.
+    // Recording a value is a few integer operations, and never allocates memory.
+    //
+    // Values below `subBucketCount` get a bin each. Above that, each power of two is divided into
+    // `subBucketCount / 2` bins. Values too large to fit are counted in the last bin, but `maxValue` is exact.
+
+    public init() {
+        counts = [UInt64](repeating: 0, count: Self.binCount)
+    }
+
+    public private(set) var totalCount: UInt64 = 0
+    public private(set) var minValue: UInt64 = 0
+    public private(set) var maxValue: UInt64 = 0
+
+    public var isEmpty: Bool {
+        totalCount == 0
+    }
+
+    public var meanValue: Double {
+        totalCount > 0 ? sum / Double(totalCount) : 0
+    }
+
+    public mutating func record(_ value: UInt64, count: UInt64 = 1) {
+        guard count > 0 else { return }
+
+        counts[Self.binIndex(value)] += count
+        if totalCount == 0 || value < minValue {
+            minValue = value
+        }
+        maxValue = max(maxValue, value)
+        totalCount += count
+        sum += Double(value) * Double(count)
+    }
+
+    public mutating func add(_ other: LatencyHistogram) {
+        guard !other.isEmpty else { return }
+
+        for index in counts.indices {
+            counts[index] += other.counts[index]
+        }
+        minValue = isEmpty ? other.minValue : min(minValue, other.minValue)
+        maxValue = max(maxValue, other.maxValue)
+        totalCount += other.totalCount
+        sum += other.sum
+    }
+
+    public mutating func reset() {
+        self = LatencyHistogram()
+    }
+
+    // The value that `percentile` percent of the recorded values are less than or equal to,
+    // to within the precision of the bins. Like HdrHistogram, returns the highest value in the bin.
+    public func value(atPercentile percentile: Double) -> UInt64 {
+        guard totalCount > 0 else { return 0 }
+
+        let countAtPercentile = max(UInt64((min(max(percentile, 0), 100) / 100 * Double(totalCount)).rounded(.up)), 1)
+        var runningCount: UInt64 = 0
+        for (index, count) in counts.enumerated() where count > 0 {
+            runningCount += count
+            if runningCount >= countAtPercentile {
+                return min(Self.binRange(index).upperBound, maxValue)
+            }
+        }
+        return maxValue
+    }
+
+    public struct Bin {
+        public let values: ClosedRange<UInt64>
+        public let count: UInt64
+    }
+
+    // The bins that have anything in them, smallest values first
+    public var bins: [Bin] {
+        counts.indices.compactMap { index in
+            counts[index] > 0 ? Bin(values: Self.binRange(index), count: counts[index]) : nil
+        }
+    }
+
+    // MARK: Private
+
+    private var counts: [UInt64]
+    private var sum: Double = 0
+
+    private static let subBucketBits = 8
+    private static let subBucketCount = UInt64(1) << subBucketBits
+    private static let subBucketHalfCount = subBucketCount / 2
+    private static let maxValueBits = 36   // 2^36 ns is about 68 seconds
+    private static let binCount = (maxValueBits - subBucketBits + 2) * Int(subBucketHalfCount)
+
+    private static func binIndex(_ value: UInt64) -> Int {
+        guard value >= subBucketCount else { return Int(value) }
+
+        // Shift the value down until it's in the upper half of the sub-buckets
+        let highestBit = UInt64.bitWidth - 1 - value.leadingZeroBitCount
+        let shift = highestBit - (subBucketBits - 1)
+        let index = shift * Int(subBucketHalfCount) + Int(value >> shift)
+        return min(index, binCount - 1)
+    }
+
+    private static func binRange(_ index: Int) -> ClosedRange<UInt64> {
+        guard index >= subBucketCount else { return UInt64(index) ... UInt64(index) }
+
+        let shift = index / Int(subBucketHalfCount) - 1
+        let subBucket = UInt64(index - shift * Int(subBucketHalfCount))
+        return (subBucket << shift) ... (((subBucket + 1) << shift) - 1)
+    }
+
+}
@@ -0,0 +1,115 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public class LatencyMonitor: NSObject {
+
+    // Measures how long incoming messages take to get through each stage of an InputStream,
+    // keeping a LatencyHistogram for each source and stage.
+    //
+    // Give it to one or more input streams, as their `latencyMonitor`. Only use it on the main queue.
+
+    public enum Stage: Int, CaseIterable {
+        case delivery       // from the message's time stamp until CoreMIDI gave it to the app
+        case parsing        // from then until the message was parsed on the main queue
+        case processing     // from then until the stream's message destination finished with it
+
+        public var name: String {
+            switch self {
+            case .delivery:
+                return String(localized: "Delivery", comment: "latency stage: from time stamp until the app receives the message")
+            case .parsing:
+                return String(localized: "Queue and parse", comment: "latency stage: from receiving the message until it has been parsed")
+            case .processing:
+                return String(localized: "Processing", comment: "latency stage: from parsing the message until it has been processed and displayed")
+            }
+        }
+    }
+
+    public struct SourceHistograms {
+        public let endpoint: Endpoint?      // nil for messages that didn't come from an endpoint
+        public let histograms: [Stage: LatencyHistogram]
+    }
+
+    // For each source that has sent anything, in the order they were first seen
+    public var sourceHistograms: [SourceHistograms] {
+        keys.compactMap { key in
+            guard let source = sources[key] else { return nil }
+            // Copy the histograms into storage of their own. If they shared storage with the live ones,
+            // the next record() would have to copy them instead, and recording shouldn't allocate.
+            let snapshots = source.histograms.map { histogram in
+                var snapshot = LatencyHistogram()
+                snapshot.add(histogram)
+                return snapshot
+            }
+            return SourceHistograms(endpoint: source.endpoint, histograms: Dictionary(uniqueKeysWithValues: zip(Stage.allCases, snapshots)))
+        }
+    }
+
+    public func reset() {
+        keys = []
+        sources = [:]
+    }
+
+    // Each recorded value, as comma-separated values: one line per non-empty bin of each histogram, in microseconds.
+    public var csvData: Data {
+        var lines = ["source,stage,min_us,max_us,count,cumulative_percent"]
+        for sourceHistograms in sourceHistograms {
+            let sourceName = Self.csvField(sourceHistograms.endpoint?.displayName ?? "")
+            for stage in Stage.allCases {
+                guard let histogram = sourceHistograms.histograms[stage], !histogram.isEmpty else { continue }
+
+                var runningCount: UInt64 = 0
+                for bin in histogram.bins {
+                    runningCount += bin.count
+                    let percent = Double(runningCount) / Double(histogram.totalCount) * 100
+                    lines.append(String(format: "%@,%@,%.3f,%.3f,%llu,%.4f", sourceName, Self.csvField(stage.name), Double(bin.values.lowerBound) / 1000, Double(bin.values.upperBound) / 1000, bin.count, percent))
+                }
+            }
+        }
+        return Data((lines.joined(separator: "\n") + "\n").utf8)
+    }
+
+    // MARK: Internal
+
+    func record(arrivalHostTime: MIDITimeStamp, parsedHostTime: MIDITimeStamp, processedHostTime: MIDITimeStamp, messages: [Message], endpoint: Endpoint?) {
+        guard !messages.isEmpty else { return }
+
+        let key = endpoint.map { ObjectIdentifier($0) }
+        if sources[key] == nil {
+            sources[key] = Source(endpoint: endpoint)
+            keys.append(key)
+        }
+
+        // Messages that arrived with no time stamp were stamped when they were parsed,
+        // so there's no way to know how long their delivery took
+        for message in messages where !message.timeStampWasZeroWhenReceived && message.hostTimeStamp <= arrivalHostTime {
+            sources[key]!.histograms[Stage.delivery.rawValue].record(SMConvertHostTimeToNanos(arrivalHostTime - message.hostTimeStamp))
+        }
+
+        let count = UInt64(messages.count)
+        sources[key]!.histograms[Stage.parsing.rawValue].record(SMConvertHostTimeToNanos(parsedHostTime - min(arrivalHostTime, parsedHostTime)), count: count)
+        sources[key]!.histograms[Stage.processing.rawValue].record(SMConvertHostTimeToNanos(processedHostTime - min(parsedHostTime, processedHostTime)), count: count)
+    }
+
+    // MARK: Private
+
+    private struct Source {
+        let endpoint: Endpoint?
+        var histograms = [LatencyHistogram](repeating: LatencyHistogram(), count: Stage.allCases.count)
+    }
+
+    private var keys: [ObjectIdentifier?] = []
+    private var sources: [ObjectIdentifier?: Source] = [:]
+
+    private static func csvField(_ string: String) -> String {
+        guard string.contains(where: { $0 == "," || $0 == "\"" || $0 == "\n" }) else { return string }
+        return "\"" + string.replacingOccurrences(of: "\"", with: "\"\"") + "\""
+    }
+
+}
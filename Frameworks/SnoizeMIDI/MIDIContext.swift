@@ -14,6 +14,11 @@ public class MIDIContext: CoreMIDIContext {
         self.init(interface: RealCoreMIDIInterface())
     }
 
+    // Uses a SyntheticMIDIInterface instead of CoreMIDI, so there are no real MIDI devices, only synthetic ones
+    public convenience init(syntheticInterface: SyntheticMIDIInterface) {
+        self.init(interface: syntheticInterface)
+    }
+
     init(interface: CoreMIDIInterface) {
         checkMainQueue()
 
@@ -117,6 +122,8 @@ public class MIDIContext: CoreMIDIContext {
 
     var client: MIDIClientRef = 0
 
+    lazy var sysExScheduler = SysExScheduler(midiContext: self)
+
     func updateEndpointsForDevice(_ device: Device) {
         // This is a very blunt approach, but reliable. Don't assume
         // anything about the source and destination lists. Just
@@ -117,6 +117,7 @@ public class Message: NSObject, NSCoding {
 
     public let hostTimeStamp: MIDITimeStamp     // in host time units
     public let clockTimeStamp: TimeInterval?    // like Date.timeIntervalSinceReferenceDate
+    public let timeStampWasZeroWhenReceived: Bool   // if so, hostTimeStamp is the time the message arrived
     public internal(set) var statusByte: UInt8
 
     // Type of this message (mask containing at most one value)
@@ -150,6 +151,21 @@ public class Message: NSObject, NSCoding {
         }
     }
 
+    // Length of fullData, at most
+    public var fullDataLength: Int {
+        1 + otherDataLength
+    }
+
+    // Copies the bytes of fullData to `buffer`, which must have room for fullDataLength bytes,
+    // and returns how many were copied. Unlike fullData, this doesn't create any Data objects.
+    public func copyFullData(to buffer: UnsafeMutablePointer<UInt8>) -> Int {
+        // Subclasses should override if getting otherData is expensive
+        buffer[0] = statusByte
+        guard let otherData else { return 1 }
+        otherData.copyBytes(to: buffer + 1, count: otherData.count)
+        return 1 + otherData.count
+    }
+
     public var originatingEndpoint: Endpoint? {
         didSet {
             if oldValue != originatingEndpoint {
@@ -262,8 +278,6 @@ public class Message: NSObject, NSCoding {
     // FUTURE: Get rid of this. Only present for backwards compatibility in MIDI Monitor documents, to display timestamp as clock time.
     private var timeBase: MessageTimeBase?
 
-    private var timeStampWasZeroWhenReceived: Bool
-
     private static let fromString = String(localized: "From", comment: "Prefix for endpoint name when it's a source")
     private static let toString = String(localized: "To", comment: "Prefix for endpoint name when it's a destination")
 
@@ -12,3 +12,9 @@ public protocol MessageDestination: NSObjectProtocol {
     func takeMIDIMessages(_ messages: [Message])
 
 }
+
+public protocol UniversalMIDIPacketDestination: AnyObject {
+
+    func takeUniversalMIDIPackets(_ packets: [UniversalMIDIPacket])
+
+}
@@ -13,15 +13,23 @@ public class MessageHistory: NSObject, MessageDestination {
 
     public weak var delegate: MessageHistoryDelegate?
 
-    public var savedMessages: [Message] = [] {
-        didSet {
+    public var savedMessages: [Message] {
+        get {
+            index.messages
+        }
+        set {
+            index.removeAll()
+            index.append(contentsOf: newValue)
             limitSavedMessages()
         }
     }
 
+    // The saved messages, indexed so they can be searched quickly (see MessageIndex).
+    public private(set) var index = MessageIndex()
+
     public func clearSavedMessages() {
-        if savedMessages.count > 0 {
-            savedMessages = []
+        if index.messages.count > 0 {
+            index.removeAll()
             historyChanged(messagesWereAdded: false)
         }
     }
@@ -41,15 +49,16 @@ public class MessageHistory: NSObject, MessageDestination {
     // MARK: MessageDestination
 
     public func takeMIDIMessages(_ messages: [Message]) {
-        savedMessages += messages
+        index.append(contentsOf: messages)
+        limitSavedMessages()
         historyChanged(messagesWereAdded: true)
     }
 
     // MARK: Private
 
     @discardableResult private func limitSavedMessages() -> Bool {
-        if savedMessages.count > historySize {
-            savedMessages = savedMessages.suffix(historySize)
+        if index.messages.count > historySize {
+            index.removeFirst(index.messages.count - historySize)
             return true
         }
         else {
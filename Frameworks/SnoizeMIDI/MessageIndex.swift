@@ -0,0 +1,251 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public struct MessageIndex {
+
+    // Holds a sequence of messages, and answers queries like "all program changes on channel 10
+    // between these two times" without looking at every message.
+    //
+    // The messages are divided into fixed-size blocks. Each block keeps a summary of what is in it:
+    // the earliest and latest timestamps, which message types, and which channels. A query first checks
+    // each block's summary, and only looks at the messages in blocks which could possibly match.
+    //
+    // Every message has a position, which counts up from 0 as messages are added and never changes.
+    // Messages may be removed from the front, as MessageHistory does when it is full, so the first
+    // message is at `startPosition`, not necessarily 0.
+    //
+    // This is a value type, so it's cheap to take a snapshot and query it on another thread.
+
+    public init(blockSize: Int = 256) {
+        precondition(blockSize > 0)
+        self.blockSize = blockSize
+    }
+
+    public init(messages: [Message], blockSize: Int = 256) {
+        self.init(blockSize: blockSize)
+        append(contentsOf: messages)
+    }
+
+    public let blockSize: Int
+
+    public private(set) var messages: [Message] = []
+
+    public private(set) var startPosition = 0
+
+    public var endPosition: Int {
+        startPosition + messages.count
+    }
+
+    public func message(atPosition position: Int) -> Message? {
+        guard position >= startPosition && position < endPosition else { return nil }
+        return messages[position - startPosition]
+    }
+
+    public mutating func append(contentsOf newMessages: [Message]) {
+        for message in newMessages {
+            let blockIndex = (endPosition - blockStartPosition) / blockSize
+            if blockIndex == blocks.count {
+                blocks.append(BlockSummary())
+            }
+            blocks[blockIndex].add(message)
+            messages.append(message)
+        }
+    }
+
+    public mutating func removeFirst(_ count: Int) {
+        let count = min(count, messages.count)
+        guard count > 0 else { return }
+
+        messages.removeFirst(count)
+        startPosition += count
+
+        // Drop the summaries of blocks that are now completely empty.
+        // The summary of a partially emptied block still describes a superset of what's in it,
+        // which is all that queries need.
+        let emptyBlockCount = (startPosition - blockStartPosition) / blockSize
+        if emptyBlockCount > 0 {
+            blocks.removeFirst(emptyBlockCount)
+            blockStartPosition += emptyBlockCount * blockSize
+        }
+    }
+
+    public mutating func removeAll() {
+        // Positions keep counting up, so positions from before this can never be confused with new ones.
+        startPosition = endPosition
+        blockStartPosition = startPosition
+        messages.removeAll()
+        blocks.removeAll()
+    }
+
+    public struct Query: Equatable {
+
+        public init(typeMask: Message.TypeMask = .all, channelMask: VoiceMessage.ChannelMask = .all, timeRange: ClosedRange<MIDITimeStamp>? = nil) {
+            self.typeMask = typeMask
+            self.channelMask = channelMask
+            self.timeRange = timeRange
+        }
+
+        public var typeMask: Message.TypeMask
+        public var channelMask: VoiceMessage.ChannelMask    // only applies to voice messages
+        public var timeRange: ClosedRange<MIDITimeStamp>?   // in host time
+
+        // True if every message matches this query
+        public var isUnrestricted: Bool {
+            typeMask == .all && channelMask == .all && timeRange == nil
+        }
+
+        public func matches(_ message: Message) -> Bool {
+            guard message.matchesMessageTypeMask(typeMask) else { return false }
+
+            if let timeRange, !timeRange.contains(message.hostTimeStamp) {
+                return false
+            }
+
+            if let voiceMessage = message as? VoiceMessage {
+                return voiceMessage.matchesChannelMask(channelMask)
+            }
+            else {
+                return true
+            }
+        }
+
+    }
+
+    // Find the positions of messages that match the query, in order, and pass them to `handler`
+    // in batches of up to `batchSize`. Return false from the handler to stop early.
+    // Optionally, only look at messages with positions in the given range.
+    public func enumerateMatches(_ query: Query, positions positionRange: Range<Int>? = nil, batchSize: Int = 1024, using handler: ([Int]) -> Bool) {
+        let searchRange = (positionRange ?? startPosition ..< endPosition).clamped(to: startPosition ..< endPosition)
+        guard !searchRange.isEmpty else { return }
+
+        var batch: [Int] = []
+        batch.reserveCapacity(batchSize)
+
+        let firstBlockIndex = (searchRange.lowerBound - blockStartPosition) / blockSize
+        let lastBlockIndex = (searchRange.upperBound - 1 - blockStartPosition) / blockSize
+        for blockIndex in firstBlockIndex ... lastBlockIndex {
+            guard blocks[blockIndex].mightMatch(query) else { continue }
+
+            let blockPosition = blockStartPosition + blockIndex * blockSize
+            let blockRange = (blockPosition ..< blockPosition + blockSize).clamped(to: searchRange)
+            for position in blockRange where query.matches(messages[position - startPosition]) {
+                batch.append(position)
+                if batch.count == batchSize {
+                    guard handler(batch) else { return }
+                    batch.removeAll(keepingCapacity: true)
+                }
+            }
+        }
+
+        if !batch.isEmpty {
+            _ = handler(batch)
+        }
+    }
+
+    public func matchingMessages(_ query: Query) -> [Message] {
+        var result: [Message] = []
+        enumerateMatches(query) { positions in
+            result.append(contentsOf: positions.map { messages[$0 - startPosition] })
+            return true
+        }
+        return result
+    }
+
+    // Search a snapshot of the index on a background queue. Batches of matching positions
+    // are delivered to `resultHandler` on the main queue, as they are found, followed by a final
+    // call with `isFinished` true. Nothing more is delivered after the search is cancelled.
+    public func search(_ query: Query, batchSize: Int = 4096, resultHandler: @escaping (_ positions: [Int], _ isFinished: Bool) -> Void) -> Search {
+        let search = Search()
+        let snapshot = self
+
+        DispatchQueue.global(qos: .userInitiated).async {
+            snapshot.enumerateMatches(query, batchSize: batchSize) { positions in
+                guard !search.isCancelled else { return false }
+                DispatchQueue.main.async {
+                    if !search.isCancelled {
+                        resultHandler(positions, false)
+                    }
+                }
+                return true
+            }
+
+            DispatchQueue.main.async {
+                if !search.isCancelled {
+                    resultHandler([], true)
+                }
+            }
+        }
+
+        return search
+    }
+
+    public final class Search {
+
+        public func cancel() {
+            lock.lock()
+            cancelled = true
+            lock.unlock()
+        }
+
+        public var isCancelled: Bool {
+            lock.lock()
+            defer { lock.unlock() }
+            return cancelled
+        }
+
+        private let lock = NSLock()
+        private var cancelled = false
+
+    }
+
+    // MARK: Private
+
+    private struct BlockSummary {
+        var minTimeStamp = MIDITimeStamp.max
+        var maxTimeStamp = MIDITimeStamp.min
+        var typeMask: Message.TypeMask = []
+        var channelMask: VoiceMessage.ChannelMask = []
+
+        mutating func add(_ message: Message) {
+            minTimeStamp = min(minTimeStamp, message.hostTimeStamp)
+            maxTimeStamp = max(maxTimeStamp, message.hostTimeStamp)
+            typeMask.formUnion(message.messageType)
+            if let voiceMessage = message as? VoiceMessage {
+                channelMask.formUnion(VoiceMessage.ChannelMask(channel: voiceMessage.channel))
+            }
+        }
+
+        func mightMatch(_ query: Query) -> Bool {
+            if let timeRange = query.timeRange,
+               maxTimeStamp < timeRange.lowerBound || minTimeStamp > timeRange.upperBound {
+                return false
+            }
+
+            let matchingTypes = typeMask.intersection(query.typeMask)
+            if matchingTypes.isEmpty {
+                return false
+            }
+            else if matchingTypes.isSubset(of: Self.voiceMessageTypes) {
+                // Only voice messages could match, so the channel matters
+                return !channelMask.intersection(query.channelMask).isEmpty
+            }
+            else {
+                return true
+            }
+        }
+
+        static let voiceMessageTypes: Message.TypeMask = [.noteOn, .noteOff, .aftertouch, .control, .program, .channelPressure, .pitchWheel]
+    }
+
+    // The first block starts at this position. It may be earlier than `startPosition`,
+    // if some of the block's messages have been removed.
+    private var blockStartPosition = 0
+    private var blocks: [BlockSummary] = []
+
+}
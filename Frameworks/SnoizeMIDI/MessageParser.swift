@@ -10,6 +10,7 @@ import Foundation
 protocol MessageParserDelegate: AnyObject {
 
     func parserDidReadMessages(_ parser: MessageParser, messages: [Message])
+    func parserDidReadUniversalMIDIPackets(_ parser: MessageParser, packets: [UniversalMIDIPacket])
     func parserIsReadingSysEx(_ parser: MessageParser, length: Int)
     func parserFinishedReadingSysEx(_ parser: MessageParser, message: SystemExclusiveMessage)
 
@@ -26,6 +27,10 @@ public class MessageParser {
     public var sysExTimeOut: TimeInterval = 1.0   // seconds
     public var ignoresInvalidData = false
 
+    // Whether takeEventList() converts the packets it reads to MIDI 1.0 messages.
+    // Turn this off when only the packets themselves are wanted, to save the work.
+    public var convertsUniversalMIDIPackets = true
+
     public func takePacketList(_ packetListPtr: UnsafePointer<MIDIPacketList>) {
         var messages: [Message] = []
 
@@ -62,8 +67,41 @@ public class MessageParser {
         }
     }
 
+    public func takeEventList(_ eventListPtr: UnsafePointer<MIDIEventList>) {
+        var packets: [UniversalMIDIPacket] = []
+
+        for eventPacketPtr in eventListPtr.unsafeSequence() {
+            // As in messagesForPacket(), don't use `pointee` to get to the words, since there may be more
+            // of them than the struct declares, or fewer.
+            let wordCount = Int(eventPacketPtr.pointee.wordCount)
+            let wordsPtr = (UnsafeRawPointer(eventPacketPtr) + MemoryLayout.offset(of: \MIDIEventPacket.words)!).assumingMemoryBound(to: UInt32.self)
+            UniversalMIDIPacket.forEachPacket(in: UnsafeBufferPointer(start: wordsPtr, count: wordCount), timeStamp: eventPacketPtr.pointee.timeStamp) {
+                packets.append($0)
+            }
+        }
+
+        guard !packets.isEmpty else { return }
+
+        delegate?.parserDidReadUniversalMIDIPackets(self, packets: packets)
+
+        if convertsUniversalMIDIPackets {
+            let messages = universalMIDIPacketConverter.messages(for: packets)
+            messages.forEach { $0.originatingEndpoint = originatingEndpoint }
+            for case let sysExMessage as SystemExclusiveMessage in messages {
+                delegate?.parserFinishedReadingSysEx(self, message: sysExMessage)
+            }
+
+            if !messages.isEmpty {
+                delegate?.parserDidReadMessages(self, messages: messages)
+            }
+        }
+    }
+
     @discardableResult public func cancelReceivingSysExMessage() -> Bool {
         // Returns YES if it successfully cancels a sysex message which is being received, and NO otherwise.
+        universalMIDIPacketConverter.reset()
+        runningStatus = 0
+
         if readingSysExData != nil {
             readingSysExData = nil
             return true
@@ -73,10 +111,22 @@ public class MessageParser {
         }
     }
 
+    // Finishes a sysex message which is being received, without waiting for it to time out,
+    // and passes it on like any other message. Use when no more data is coming, like at the end of a file.
+    public func finishReceivingSysExMessage() {
+        sysExTimeOutTimer?.invalidate()
+        sysExTimeOutTimer = nil
+        if let message = finishSysExMessage(validEnd: false) {
+            delegate?.parserDidReadMessages(self, messages: [message])
+        }
+    }
+
     // MARK: Private
 
     private var readingSysExData: Data?
     private var startSysExTimeStamp: MIDITimeStamp = 0
+    private var runningStatus: UInt8 = 0    // status of the last voice message, or 0 if none
+    private lazy var universalMIDIPacketConverter = UniversalMIDIPacketConverter()
     private var sysExTimeOutTimer: Timer?
 
     private struct PendingMessage {
@@ -103,7 +153,7 @@ public class MessageParser {
         // in the tuple in the struct. There may be more.
         // Do it the hard way instead.
         let rawPacketDataPtr = UnsafeRawBufferPointer(start: UnsafeRawPointer(packetPtr) + MemoryLayout.offset(of: \MIDIPacket.data)!, count: packetDataCount)
-        return rawPacketDataPtr.enumerated().flatMap { (byteIndex, byte) -> [Message] in
+        let messages = rawPacketDataPtr.enumerated().flatMap { (byteIndex, byte) -> [Message] in
             var messages: [Message] = []
             var byteIsInvalid = false
 
@@ -147,6 +197,15 @@ public class MessageParser {
             messages.forEach { $0.originatingEndpoint = originatingEndpoint }
             return messages
         }
+
+        if pendingMessage.data.count < pendingMessage.expectedCount {
+            // The packet ended partway through a message. The pending message only lasts for one packet,
+            // so don't let running status turn the rest of it, in the next packet, into a message made of
+            // the wrong bytes. Those bytes are invalid instead.
+            runningStatus = 0
+        }
+
+        return messages
     }
 
     private func parseRealTimeMessage(_ byte: UInt8, _ timeStamp: MIDITimeStamp) -> (Message?, Bool) {
@@ -197,6 +256,17 @@ public class MessageParser {
                 }
             }
         }
+        else if runningStatus != 0 {
+            // Running status: the data byte starts another message with the same status as the last voice message,
+            // even if it was in an earlier packet
+            pendingMessage.status = runningStatus
+            pendingMessage.data = [byte]
+            pendingMessage.expectedCount = Self.voiceMessageDataCount(runningStatus)
+
+            if pendingMessage.data.count == pendingMessage.expectedCount {
+                return (VoiceMessage(timeStamp: timeStamp, statusByte: pendingMessage.status, data: pendingMessage.data), false)
+            }
+        }
         else {
             // Skip this byte -- it is invalid
             return (nil, true)
@@ -215,19 +285,14 @@ public class MessageParser {
         pendingMessage.expectedCount = 0
 
         switch byte & 0xF0 {
-        case 0x80,    // Note off
-             0x90,    // Note on
-             0xA0,    // Aftertouch
-             0xB0,    // Controller
-             0xE0:    // Pitch wheel
-            pendingMessage.expectedCount = 2
-
-        case 0xC0,    // Program change
-             0xD0:    // Channel pressure
-            pendingMessage.expectedCount = 1
+        case 0x80 ..< 0xF0:
+            // Voice message. Its status stays in effect for following data bytes, until the next status byte.
+            pendingMessage.expectedCount = Self.voiceMessageDataCount(byte)
+            runningStatus = byte
 
         case 0xF0:
-            // System common message
+            // System common message. This cancels running status.
+            runningStatus = 0
             if byte == 0xF0 {
                 // System exclusive start
                 readingSysExData = Data()
@@ -256,6 +321,16 @@ public class MessageParser {
         return (message, byteIsInvalid)
     }
 
+    private static func voiceMessageDataCount(_ status: UInt8) -> Int {
+        switch status & 0xF0 {
+        case 0xC0,    // Program change
+             0xD0:    // Channel pressure
+            return 1
+        default:      // Note off, note on, aftertouch, controller, pitch wheel
+            return 2
+        }
+    }
+
     private func finishSysExMessage(validEnd: Bool) -> SystemExclusiveMessage? {
         // NOTE: If we want, we could refuse sysex messages that don't end in 0xF7.
         // The MIDI spec says that messages should end with this byte, but apparently that is not always the case in practice.
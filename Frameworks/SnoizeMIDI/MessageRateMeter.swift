@@ -0,0 +1,198 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public class MessageRateMeter: NSObject, MessageDestination {
+
+    // Measures how many messages, and how many bytes, each source is sending per second,
+    // in total and for each type of message. Passes all messages on, unchanged.
+    //
+    // Rates are averaged over a sliding window, which is divided into short buckets. As time goes on,
+    // the oldest bucket is emptied and reused, so counting a message is just a few array increments,
+    // and the meter is cheap enough to leave in place all the time.
+    //
+    // Messages are counted when they arrive, not by their time stamps. Like the other processors,
+    // the meter is only used on the main queue, so it doesn't need any locks.
+
+    public init(windowDuration: TimeInterval = 1.0, bucketCount: Int = 10) {
+        self.windowDuration = windowDuration
+        self.bucketCount = bucketCount
+        self.bucketNanos = UInt64(windowDuration * 1_000_000_000) / UInt64(bucketCount)
+        super.init()
+    }
+
+    public weak var messageDestination: MessageDestination?
+
+    public let windowDuration: TimeInterval
+
+    public struct Rate {
+        public var messagesPerSecond: Double = 0
+        public var bytesPerSecond: Double = 0
+    }
+
+    public struct SourceRates {
+        public let endpoint: Endpoint?          // nil for messages that didn't come from an endpoint
+        public let rate: Rate
+        public let peakRate: Rate               // the highest rate since the meter or its peaks were reset
+        public let ratesByType: [(typeName: String, rate: Rate)]   // types that are being sent, most messages first
+    }
+
+    // For each source that has sent anything, most messages first
+    public var sourceRates: [SourceRates] {
+        let bucket = currentBucket
+        return counters.values
+            .map { counter in
+                counter.advance(to: bucket)
+                return counter.rates
+            }
+            .sorted { $0.rate.messagesPerSecond > $1.rate.messagesPerSecond }
+    }
+
+    public func resetPeaks() {
+        counters.values.forEach { $0.peakRate = Rate() }
+    }
+
+    public func reset() {
+        counters = [:]
+    }
+
+    // MARK: MessageDestination
+
+    public func takeMIDIMessages(_ messages: [Message]) {
+        let bucket = currentBucket
+        for message in messages {
+            let key = message.originatingEndpoint.map { ObjectIdentifier($0) }
+            let counter: Counter
+            if let existingCounter = counters[key] {
+                counter = existingCounter
+            }
+            else {
+                counter = Counter(endpoint: message.originatingEndpoint, windowDuration: windowDuration, bucketCount: bucketCount, bucket: bucket)
+                counters[key] = counter
+            }
+
+            counter.advance(to: bucket)
+            counter.count(message)
+        }
+
+        messageDestination?.takeMIDIMessages(messages)
+    }
+
+    // MARK: Private
+
+    private let bucketCount: Int
+    private let bucketNanos: UInt64
+    private var counters: [ObjectIdentifier?: Counter] = [:]
+
+    private var currentBucket: Int {
+        Int(DispatchTime.now().uptimeNanoseconds / bucketNanos)
+    }
+
+    // One more than the number of message types, for the totals
+    private static let countsPerBucket = Message.TypeMask.all.rawValue.nonzeroBitCount + 1
+
+    private final class Counter {
+
+        init(endpoint: Endpoint?, windowDuration: TimeInterval, bucketCount: Int, bucket: Int) {
+            self.endpoint = endpoint
+            self.windowDuration = windowDuration
+            self.bucketCount = bucketCount
+            self.newestBucket = bucket
+            messageCounts = [Int](repeating: 0, count: bucketCount * MessageRateMeter.countsPerBucket)
+            byteCounts = messageCounts
+            typeNames = [String?](repeating: nil, count: MessageRateMeter.countsPerBucket - 1)
+        }
+
+        let endpoint: Endpoint?
+        var peakRate = Rate()
+
+        // Forgets counts from buckets that are now outside the window
+        func advance(to bucket: Int) {
+            guard bucket > newestBucket else { return }
+
+            // The window is about to move, so this is the last chance to see its rate
+            updatePeakRate()
+
+            let countsPerBucket = MessageRateMeter.countsPerBucket
+            for emptyBucket in (newestBucket + 1) ... (newestBucket + min(bucket - newestBucket, bucketCount)) {
+                let start = (emptyBucket % bucketCount) * countsPerBucket
+                for index in start ..< start + countsPerBucket {
+                    messageCounts[index] = 0
+                    byteCounts[index] = 0
+                }
+            }
+            newestBucket = bucket
+        }
+
+        func count(_ message: Message) {
+            let typeIndex = message.messageType.rawValue.trailingZeroBitCount
+            let totalIndex = MessageRateMeter.countsPerBucket - 1
+            guard typeIndex < totalIndex else { return }
+
+            if typeNames[typeIndex] == nil {
+                typeNames[typeIndex] = message.typeForDisplay
+            }
+
+            let start = (newestBucket % bucketCount) * MessageRateMeter.countsPerBucket
+            let byteCount = message.fullDataLength
+            messageCounts[start + typeIndex] += 1
+            byteCounts[start + typeIndex] += byteCount
+            messageCounts[start + totalIndex] += 1
+            byteCounts[start + totalIndex] += byteCount
+        }
+
+        var rates: SourceRates {
+            updatePeakRate()
+
+            var ratesByType: [(typeName: String, rate: Rate)] = []
+            for (typeIndex, typeName) in typeNames.enumerated() {
+                guard let typeName else { continue }
+                let rate = windowRate(countIndex: typeIndex)
+                if rate.messagesPerSecond > 0 {
+                    ratesByType.append((typeName, rate))
+                }
+            }
+            ratesByType.sort { $0.rate.messagesPerSecond > $1.rate.messagesPerSecond }
+
+            return SourceRates(endpoint: endpoint, rate: totalRate, peakRate: peakRate, ratesByType: ratesByType)
+        }
+
+        // MARK: Private
+
+        private let windowDuration: TimeInterval
+        private let bucketCount: Int
+        private var newestBucket: Int
+
+        // For each bucket, a count for each message type, then the total
+        private var messageCounts: [Int]
+        private var byteCounts: [Int]
+        private var typeNames: [String?]
+
+        private func windowRate(countIndex: Int) -> Rate {
+            var messageCount = 0
+            var byteCount = 0
+            for index in stride(from: countIndex, to: messageCounts.count, by: MessageRateMeter.countsPerBucket) {
+                messageCount += messageCounts[index]
+                byteCount += byteCounts[index]
+            }
+            return Rate(messagesPerSecond: Double(messageCount) / windowDuration, bytesPerSecond: Double(byteCount) / windowDuration)
+        }
+
+        private var totalRate: Rate {
+            windowRate(countIndex: MessageRateMeter.countsPerBucket - 1)
+        }
+
+        private func updatePeakRate() {
+            let rate = totalRate
+            peakRate.messagesPerSecond = max(peakRate.messagesPerSecond, rate.messagesPerSecond)
+            peakRate.bytesPerSecond = max(peakRate.bytesPerSecond, rate.bytesPerSecond)
+        }
+
+    }
+
+}
@@ -0,0 +1,281 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public class MessageRecorder: NSObject, MessageDestination {
+
+    // Streams every message it receives to capture files on disk (see CaptureFile).
+    //
+    // Messages are encoded on the caller's thread, and the encoded data is handed to a
+    // background queue, which writes it out in batches. Each batch is followed by a single
+    // fsync(), so the cost of making the data durable is shared by every message in the batch.
+    //
+    // Memory use is bounded: if the disk can't keep up and too much data is waiting to be written,
+    // new messages are dropped and counted in `statistics`, instead of being queued forever.
+    //
+    // When the current file gets too large, or has been open for too long, a new file is started.
+
+    public init(directoryURL: URL, baseName: String) {
+        self.directoryURL = directoryURL
+        self.baseName = baseName
+        super.init()
+    }
+
+    deinit {
+        if fileDescriptor >= 0 {
+            close(fileDescriptor)
+        }
+    }
+
+    public weak var delegate: MessageRecorderDelegate?
+
+    public let directoryURL: URL
+    public let baseName: String
+
+    // Start a new file when the current file would grow past this size, in bytes.
+    // A single batch of messages bigger than this still goes in one file.
+    public var maxFileSize: Int = 256 * 1024 * 1024
+
+    // Start a new file when the current file has been open this long, in seconds.
+    public var maxFileDuration: TimeInterval = 60 * 60
+
+    // Drop messages when this many bytes are already waiting to be written.
+    public var maxPendingByteCount: Int = 16 * 1024 * 1024
+
+    // How long to collect messages before writing them out, in seconds.
+    public var commitInterval: TimeInterval = 0.25
+
+    public private(set) var isRecording = false
+
+    public func start() throws {
+        guard !isRecording else { return }
+
+        try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true, attributes: nil)
+        try writerQueue.sync {
+            try openNextFile()
+        }
+
+        isRecording = true
+    }
+
+    public func stop() {
+        guard isRecording else { return }
+        isRecording = false
+
+        writerQueue.sync {
+            commitPendingBatches()
+            closeFile()
+        }
+    }
+
+    public struct Statistics {
+        public var recordedMessageCount = 0
+        public var recordedByteCount = 0
+        public var droppedMessageCount = 0
+        public var droppedByteCount = 0
+        public var fileCount = 0
+        public var currentFileURL: URL?
+    }
+
+    // May be called from any thread
+    public var statistics: Statistics {
+        lock.lock()
+        defer { lock.unlock() }
+        return privateStatistics
+    }
+
+    // MARK: MessageDestination
+
+    public func takeMIDIMessages(_ messages: [Message]) {
+        guard isRecording, !messages.isEmpty else { return }
+
+        var timeStamps = messages.map(\.hostTimeStamp)
+        timeStamps.withUnsafeMutableBufferPointer {
+            SMConvertHostTimesToNanos($0.baseAddress, $0.baseAddress, $0.count)
+        }
+
+        var data = Data()
+        data.reserveCapacity(messages.count * 32)
+        for (message, hostTimeInNanos) in zip(messages, timeStamps) {
+            CaptureFile.appendRecord(for: message, hostTimeInNanos: hostTimeInNanos, to: &data)
+        }
+
+        lock.lock()
+        guard pendingByteCount + data.count <= maxPendingByteCount else {
+            privateStatistics.droppedMessageCount += messages.count
+            privateStatistics.droppedByteCount += data.count
+            lock.unlock()
+            return
+        }
+
+        pendingBatches.append(PendingBatch(data: data, messageCount: messages.count))
+        pendingByteCount += data.count
+        let shouldScheduleCommit = !isCommitScheduled
+        isCommitScheduled = true
+        lock.unlock()
+
+        if shouldScheduleCommit {
+            writerQueue.asyncAfter(deadline: .now() + commitInterval) { [weak self] in
+                self?.commitPendingBatches()
+            }
+        }
+    }
+
+    // MARK: Private
+
+    private struct PendingBatch {
+        let data: Data
+        let messageCount: Int
+    }
+
+    // Protected by `lock`
+    private let lock = NSLock()
+    private var pendingBatches: [PendingBatch] = []
+    private var pendingByteCount = 0
+    private var isCommitScheduled = false
+    private var privateStatistics = Statistics()
+
+    // Only used on `writerQueue`
+    private let writerQueue = DispatchQueue(label: "com.snoize.SnoizeMIDI.MessageRecorder", qos: .utility)
+    private var fileDescriptor: Int32 = -1
+    private var fileSize = 0
+    private var fileStartDate = Date.distantPast
+
+    private lazy var fileNameDateFormatter: DateFormatter = {
+        let formatter = DateFormatter()
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        formatter.dateFormat = "yyyy-MM-dd HH.mm.ss"
+        return formatter
+    }()
+
+    private func commitPendingBatches() {
+        dispatchPrecondition(condition: .onQueue(writerQueue))
+
+        lock.lock()
+        let batches = pendingBatches
+        pendingBatches = []
+        pendingByteCount = 0
+        isCommitScheduled = false
+        lock.unlock()
+
+        guard !batches.isEmpty else { return }
+
+        var recordedMessageCount = 0
+        var recordedByteCount = 0
+        var failure: Error?
+
+        for batch in batches {
+            guard fileDescriptor >= 0 else { break }
+
+            do {
+                // Only move on from a file that has records in it. A batch bigger than maxFileSize goes over
+                // the limit, instead of leaving behind files that have nothing but the signature.
+                let fileHasRecords = fileSize > CaptureFile.signature.count
+                if fileHasRecords && (fileSize + batch.data.count > maxFileSize || -fileStartDate.timeIntervalSinceNow > maxFileDuration) {
+                    closeFile()
+                    try openNextFile()
+                }
+
+                try writeToFile(batch.data)
+                recordedMessageCount += batch.messageCount
+                recordedByteCount += batch.data.count
+            }
+            catch {
+                failure = error
+                closeFile()
+            }
+        }
+
+        if fileDescriptor >= 0 {
+            fsync(fileDescriptor)
+        }
+
+        lock.lock()
+        privateStatistics.recordedMessageCount += recordedMessageCount
+        privateStatistics.recordedByteCount += recordedByteCount
+        privateStatistics.droppedMessageCount += batches.reduce(0) { $0 + $1.messageCount } - recordedMessageCount
+        privateStatistics.droppedByteCount += batches.reduce(0) { $0 + $1.data.count } - recordedByteCount
+        lock.unlock()
+
+        if let failure {
+            DispatchQueue.main.async {
+                guard self.isRecording else { return }
+                self.isRecording = false
+                self.delegate?.messageRecorder(self, didFailWithError: failure)
+            }
+        }
+    }
+
+    private func openNextFile() throws {
+        let baseFileName = baseName + " " + fileNameDateFormatter.string(from: Date())
+        var fileURL = directoryURL.appendingPathComponent(baseFileName).appendingPathExtension(CaptureFile.fileExtension)
+        var suffix = 2
+        while FileManager.default.fileExists(atPath: fileURL.path) {
+            fileURL = directoryURL.appendingPathComponent("\(baseFileName) \(suffix)").appendingPathExtension(CaptureFile.fileExtension)
+            suffix += 1
+        }
+
+        let newFileDescriptor = open(fileURL.path, O_WRONLY | O_CREAT | O_EXCL, 0o644)
+        guard newFileDescriptor >= 0 else { throw posixError() }
+
+        fileDescriptor = newFileDescriptor
+        fileSize = 0
+        fileStartDate = Date()
+        do {
+            try writeToFile(CaptureFile.signature)
+        }
+        catch {
+            closeFile()
+            throw error
+        }
+
+        lock.lock()
+        privateStatistics.fileCount += 1
+        privateStatistics.currentFileURL = fileURL
+        lock.unlock()
+    }
+
+    private func closeFile() {
+        guard fileDescriptor >= 0 else { return }
+        fsync(fileDescriptor)
+        close(fileDescriptor)
+        fileDescriptor = -1
+    }
+
+    private func writeToFile(_ data: Data) throws {
+        try data.withUnsafeBytes { (rawBufferPtr: UnsafeRawBufferPointer) in
+            guard let baseAddress = rawBufferPtr.baseAddress else { return }
+            var offset = 0
+            while offset < rawBufferPtr.count {
+                let result = write(fileDescriptor, baseAddress + offset, rawBufferPtr.count - offset)
+                if result < 0 {
+                    if errno == EINTR {
+                        continue
+                    }
+                    throw posixError()
+                }
+                offset += result
+            }
+        }
+
+        fileSize += data.count
+    }
+
+    private func posixError() -> Error {
+        NSError(domain: NSPOSIXErrorDomain, code: Int(errno), userInfo: nil)
+    }
+
+}
+
+public protocol MessageRecorderDelegate: NSObjectProtocol {
+
+    // Sent on the main queue if the recorder can't continue writing to disk.
+    // The recorder has stopped by the time this is called.
+    func messageRecorder(_ recorder: MessageRecorder, didFailWithError error: Error)
+
+}
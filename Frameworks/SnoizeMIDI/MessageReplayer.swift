@@ -0,0 +1,185 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public class MessageReplayer: NSObject {
+
+    // Plays messages that were received earlier (say, from a document or a capture file) to an output stream,
+    // with their original timing.
+    //
+    // The messages' time stamps are moved so the first one plays just after replaying starts.
+    // Instead of waking up for every message, the replayer wakes up a few times per `lookAhead`, and sends
+    // every message that is due before the next `lookAhead` seconds are up, with time stamps in the future.
+    // CoreMIDI then sends each message at its time, much more precisely than a timer could.
+    //
+    // Only use on the main queue. Since messages are sent ahead of time, the main queue being busy
+    // doesn't affect the timing, unless it's busy for longer than `lookAhead`.
+
+    public init(messages: [Message], outputStream: OutputStream) {
+        // Invalid messages aren't worth sending to a device. Keep messages with the same time stamp in order.
+        self.messages = messages.enumerated()
+            .filter { $0.element.messageType != .invalid }
+            .sorted { ($0.element.hostTimeStamp, $0.offset) < ($1.element.hostTimeStamp, $1.offset) }
+            .map(\.element)
+        self.outputStream = outputStream
+        super.init()
+    }
+
+    public let outputStream: OutputStream
+
+    // These take effect when the replayer starts.
+
+    // 2 plays twice as fast, 0.5 half as fast
+    public var speed: Double = 1.0
+
+    // Whether to start over after the last message. Each time through takes as long as `timeRange`,
+    // if it's set, or the time from the first message to the last one.
+    public var loops = false
+
+    // If set, only the messages with time stamps in this range are played,
+    // starting at the beginning of the range instead of at the first message
+    public var timeRange: ClosedRange<MIDITimeStamp>?
+
+    // How far ahead of time messages are sent, in seconds
+    public var lookAhead: TimeInterval = 0.25
+
+    public private(set) var isPlaying = false
+
+    // Messages sent since starting, and how many of them were sent after the time they should have been played,
+    // because the main queue was too busy
+    public private(set) var sentMessageCount = 0
+    public private(set) var lateMessageCount = 0
+
+    // `completion` is called on the main queue after the last message has been played,
+    // unless the replayer loops or is stopped first
+    public func start(completion: (() -> Void)? = nil) {
+        stop()
+
+        if let timeRange {
+            playlist = messages.filter { timeRange.contains($0.hostTimeStamp) }
+        }
+        else {
+            playlist = messages
+        }
+
+        guard let firstMessage = playlist.first, let lastMessage = playlist.last else {
+            completion?()
+            return
+        }
+
+        playlistStartTimeStamp = timeRange?.lowerBound ?? firstMessage.hostTimeStamp
+        playbackSpeed = speed > 0 ? speed : 1.0
+        // A loop needs to take some time, or looping would send messages as fast as possible
+        let playlistEndTimeStamp = timeRange?.upperBound ?? lastMessage.hostTimeStamp
+        passDuration = max(scaledDuration(playlistEndTimeStamp - playlistStartTimeStamp), SMConvertNanosToHostTime(Self.minimumPassDurationNanos))
+        let lookAhead = max(self.lookAhead, 0.01)
+        lookAheadDuration = SMConvertNanosToHostTime(UInt64(lookAhead * 1_000_000_000))
+
+        passStartHostTime = SMGetCurrentHostTime() + SMConvertNanosToHostTime(Self.startDelayNanos)
+        nextIndex = 0
+        sentMessageCount = 0
+        lateMessageCount = 0
+        self.completion = completion
+        isPlaying = true
+
+        // Use the common run loop modes, so replaying continues while menus are being tracked
+        let timer = Timer(timeInterval: lookAhead / 4, repeats: true) { [weak self] _ in
+            self?.sendDueMessages()
+        }
+        RunLoop.main.add(timer, forMode: .common)
+        self.timer = timer
+
+        sendDueMessages()
+    }
+
+    // Stops playing. Messages that were already sent ahead of time are unscheduled, if the stream can do that.
+    // The completion isn't called.
+    public func stop() {
+        guard isPlaying else { return }
+
+        finish()
+        (outputStream as? PortOutputStream)?.flushScheduledMessages()
+    }
+
+    // MARK: Private
+
+    private let messages: [Message]
+
+    private var playlist: [Message] = []
+    private var playlistStartTimeStamp: MIDITimeStamp = 0
+    private var playbackSpeed = 1.0
+    private var passDuration: MIDITimeStamp = 0     // host time, already scaled by the speed
+    private var lookAheadDuration: MIDITimeStamp = 0
+    private var passStartHostTime: MIDITimeStamp = 0
+    private var nextIndex = 0
+    private var completion: (() -> Void)?
+    private var timer: Timer?
+
+    private static let startDelayNanos: UInt64 = 10_000_000         // 10 ms, so the first messages aren't late
+    private static let minimumPassDurationNanos: UInt64 = 100_000_000   // 100 ms
+
+    private func scaledDuration(_ duration: MIDITimeStamp) -> MIDITimeStamp {
+        guard playbackSpeed != 1.0 else { return duration }
+        return SMConvertNanosToHostTime(UInt64(Double(SMConvertHostTimeToNanos(duration)) / playbackSpeed))
+    }
+
+    private func sendDueMessages() {
+        guard isPlaying else { return }
+
+        let now = SMGetCurrentHostTime()
+        let horizon = now + lookAheadDuration
+
+        while true {
+            // Send the messages in this pass that will be due before the next wake-up, all at once
+            let passStart = passStartHostTime
+            let startIndex = nextIndex
+            while nextIndex < playlist.count {
+                let hostTime = passStart + scaledDuration(playlist[nextIndex].hostTimeStamp - playlistStartTimeStamp)
+                guard hostTime < horizon else { break }
+                if hostTime < now {
+                    lateMessageCount += 1
+                }
+                nextIndex += 1
+            }
+
+            if nextIndex > startIndex {
+                outputStream.takeMIDIMessages(Array(playlist[startIndex ..< nextIndex])) { message in
+                    passStart + scaledDuration(message.hostTimeStamp - playlistStartTimeStamp)
+                }
+                sentMessageCount += nextIndex - startIndex
+            }
+
+            // Wait for a later wake-up if there's more to send in this pass
+            guard nextIndex == playlist.count else { return }
+
+            if loops {
+                // Go on to the next pass, which may already have messages that are due
+                nextIndex = 0
+                passStartHostTime += passDuration
+            }
+            else {
+                // Everything has been sent. Finish once it has all been played.
+                if now >= passStart + passDuration {
+                    let completion = self.completion
+                    finish()
+                    completion?()
+                }
+                return
+            }
+        }
+    }
+
+    private func finish() {
+        timer?.invalidate()
+        timer = nil
+        isPlaying = false
+        completion = nil
+        playlist = []
+    }
+
+}
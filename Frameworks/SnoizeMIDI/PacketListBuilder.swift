@@ -0,0 +1,185 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import CoreMIDI
+
+final class PacketListBuilder {
+
+    // Puts messages into MIDIPacketLists, as few as possible, and sends them.
+    //
+    // The packet list, and the buffer that each message's bytes are copied into, are allocated once
+    // and reused for every batch of messages. Messages copy their bytes straight into the buffer,
+    // without making Data objects, so once the buffer is big enough for the largest message,
+    // sending doesn't allocate any memory.
+    //
+    // Not thread-safe: use a builder on one thread at a time.
+
+    init() {
+        packetListPtr = UnsafeMutableRawPointer.allocate(byteCount: Self.maxPacketListSize, alignment: MemoryLayout<MIDIPacketList>.alignment).bindMemory(to: MIDIPacketList.self, capacity: 1)
+        messageBytesCapacity = 256
+        messageBytesPtr = UnsafeMutablePointer<UInt8>.allocate(capacity: messageBytesCapacity)
+    }
+
+    deinit {
+        packetListPtr.deallocate()
+        messageBytesPtr.deallocate()
+    }
+
+    // Whether to leave out a voice message's status byte when it's the same as the previous message's
+    // in the same packet ("running status"). Every packet still starts with a status byte, as CoreMIDI requires.
+    // This saves up to a third of the bytes of dense note or controller data, which matters on slow links
+    // like 31.25 kbaud DIN cables.
+    //
+    // Off by default, since CoreMIDI's documentation says packets shouldn't use running status,
+    // so only use it with destinations whose drivers are known to handle it.
+    var usesRunningStatus = false
+
+    // For measuring how much running status saves
+    private(set) var sentByteCount = 0
+    private(set) var omittedStatusByteCount = 0
+
+    // Adds the messages to packet lists, calling `send` with each packet list when it's full, and with the last one.
+    // Each message's packet gets the time stamp that `timeStamp` returns for it.
+    func send(_ messages: [Message], timeStamp: (Message) -> MIDITimeStamp, _ send: (UnsafePointer<MIDIPacketList>) -> Void) {
+        guard messages.count > 0 else { return }
+
+        func sendPacketList() -> UnsafeMutablePointer<MIDIPacket> {
+            // Send the current packet list, empty it, and return the next packet to fill in
+            send(packetListPtr)
+            return MIDIPacketListInit(packetListPtr)
+        }
+
+        var curPacketPtr = MIDIPacketListInit(packetListPtr)
+
+        for message in messages {
+            // Get the full data for the message (including first status byte)
+            reserveMessageBytes(message.fullDataLength)
+            let messageLength = message.copyFullData(to: messageBytesPtr)
+            guard messageLength > 0 else { continue }
+            let packetTimeStamp = timeStamp(message)
+
+            // Attempt to add a packet with the full data into the current packet list
+            if let nextPacketPtr = addMessagePacket(curPacketPtr, packetTimeStamp, messageLength) {
+                // There was enough room in the packet list
+                curPacketPtr = nextPacketPtr
+                continue
+            }
+
+            if packetListPtr.pointee.numPackets > 0 {
+                // There was not enough room in the packet list.
+                // Send the outstanding packet list, clear it, and try again.
+                curPacketPtr = sendPacketList()
+
+                if let nextPacketPtr = addMessagePacket(curPacketPtr, packetTimeStamp, messageLength) {
+                    curPacketPtr = nextPacketPtr
+                    continue
+                }
+            }
+
+            // This message will never fit.
+            // This is a large message (in practice, it's sysex, but we don't assume that here).
+            // We send it by filling in the packet list with one packet with as much data as possible,
+            // sending that packet list, then repeating with the remaining data.
+            let chunkSize = Self.maxPacketListSize - MemoryLayout.offset(of: \MIDIPacketList.packet.data)!
+            for chunkStart in stride(from: 0, to: messageLength, by: chunkSize) {
+                let chunkLength = min(chunkSize, messageLength - chunkStart)
+                if addPacket(curPacketPtr, packetTimeStamp, messageBytesPtr + chunkStart, chunkLength) == nil {
+                    fatalError("Couldn't add packet for overlarge message -- logic error")
+                }
+                sentByteCount += chunkLength
+                curPacketPtr = sendPacketList()
+            }
+        }
+
+        // All messages have been processed. Send the last remaining packet list.
+        if packetListPtr.pointee.numPackets > 0 {
+            send(packetListPtr)
+        }
+    }
+
+    // MARK: Private
+
+    // CoreMIDI's MIDIPacketList struct is variable-size, consisting of a small
+    // header followed by one or more variable-size MIDIPacket structs.
+    // The types limit MIDIPacket to holding at most 2^16 - 1 = 65535 bytes,
+    // and the MIDIPacketList to holding 2^32 - 1 packets.
+    //
+    // It's plausible that a large sysex message could exceed the max packet size,
+    // but we should be able to split it across multiple packets. The packet
+    // count is (almost) unlimited, so we should be able to use a single packet list.
+    //
+    // HOWEVER. It's not clear we can rely on that, in practice.
+    // `MIDIPacketListAdd` has this comment:
+    // > The maximum size of a packet list is 65536 bytes.
+    // > Large sysex messages must be sent in smaller packet lists.
+    // That seems dumb, and maybe they just meant "packet" instead of "packet list",
+    // but why risk it? Just send as many packet lists as are necessary.
+    //
+    // (Back in Mac OS X 10.1, the MIDIServer would crash if you exceeded
+    // 1024 bytes in a packet list. So it's not inconceivable that the implementation
+    // could have similar limits even today.)
+    //
+    // Switch to newer CoreMIDI API (introduced in 10.15 or 11.0) when we can.
+
+    private static let maxPacketListSize = 65536
+
+    private let packetListPtr: UnsafeMutablePointer<MIDIPacketList>
+
+    private var messageBytesPtr: UnsafeMutablePointer<UInt8>
+    private var messageBytesCapacity: Int
+
+    private var runningStatus: UInt8 = 0    // status of the last voice message in the last packet, or 0 if none
+
+    private func reserveMessageBytes(_ count: Int) {
+        guard count > messageBytesCapacity else { return }
+
+        // Grow by at least double, so a series of bigger and bigger messages doesn't reallocate every time
+        messageBytesPtr.deallocate()
+        messageBytesCapacity = max(count, messageBytesCapacity * 2)
+        messageBytesPtr = UnsafeMutablePointer<UInt8>.allocate(capacity: messageBytesCapacity)
+    }
+
+    private func addPacket(_ packetPtr: UnsafeMutablePointer<MIDIPacket>, _ timeStamp: MIDITimeStamp, _ bytes: UnsafePointer<UInt8>, _ count: Int) -> UnsafeMutablePointer<MIDIPacket>? {
+        // Try to add a packet to the packet list, with the given bytes.
+        // If successful, returns a non-nil pointer for the next packet.
+        // If unsuccessful, returns nil.
+        SMWorkaroundMIDIPacketListAdd(packetListPtr, Self.maxPacketListSize, packetPtr, timeStamp, count, bytes)
+    }
+
+    private func addMessagePacket(_ packetPtr: UnsafeMutablePointer<MIDIPacket>, _ timeStamp: MIDITimeStamp, _ messageLength: Int) -> UnsafeMutablePointer<MIDIPacket>? {
+        // Like addPacket(), for the message in the message bytes buffer, leaving out its status byte if possible
+        let statusByte = messageBytesPtr[0]
+        var omitsStatusByte = usesRunningStatus && statusByte == runningStatus && messageLength > 1 && packetListPtr.pointee.numPackets > 0
+        var count = omitsStatusByte ? messageLength - 1 : messageLength
+
+        let packetCount = packetListPtr.pointee.numPackets
+        var maybeNextPacketPtr = addPacket(packetPtr, timeStamp, omitsStatusByte ? messageBytesPtr + 1 : messageBytesPtr, count)
+        if omitsStatusByte && maybeNextPacketPtr != nil && packetListPtr.pointee.numPackets != packetCount {
+            // CoreMIDI started a new packet (because of a different time stamp, or a full packet) instead of
+            // adding to the last one, and each packet must start with a status byte. Take the new packet off
+            // the end of the list, and add it again with the status byte.
+            packetListPtr.pointee.numPackets = packetCount
+            omitsStatusByte = false
+            count = messageLength
+            maybeNextPacketPtr = addPacket(packetPtr, timeStamp, messageBytesPtr, count)
+        }
+        guard let nextPacketPtr = maybeNextPacketPtr else { return nil }
+
+        sentByteCount += count
+        if omitsStatusByte {
+            omittedStatusByteCount += 1
+        }
+
+        // Only voice messages set the running status. Any other message cancels it.
+        // (The MIDI spec says real time messages don't, but receivers don't always get that right.)
+        runningStatus = (0x80 ..< 0xF0).contains(statusByte) ? statusByte : 0
+
+        return nextPacketPtr
+    }
+
+}
@@ -9,10 +9,22 @@ import Foundation
 
 public class PortInputStream: InputStream {
 
-    public override init(midiContext: MIDIContext) {
+    public convenience override init(midiContext: MIDIContext) {
+        self.init(midiContext: midiContext, receivesUniversalMIDIPackets: false)
+    }
+
+    // If `receivesUniversalMIDIPackets` is true, CoreMIDI gives us MIDI 2.0 Universal MIDI Packets, instead of
+    // translating them to MIDI 1.0 bytes. They go to `universalMIDIPacketDestination`, and are only
+    // converted to MIDI 1.0 messages if there is a `messageDestination`.
+    public init(midiContext: MIDIContext, receivesUniversalMIDIPackets: Bool) {
         super.init(midiContext: midiContext)
 
-        _ = midiContext.interface.inputPortCreateWithBlock(midiContext.client, "Input port" as CFString, &inputPort, midiReadBlock)
+        if receivesUniversalMIDIPackets {
+            _ = midiContext.interface.inputPortCreateWithProtocol(midiContext.client, "Input port" as CFString, ._2_0, &inputPort, midiReceiveBlock)
+        }
+        else {
+            _ = midiContext.interface.inputPortCreateWithBlock(midiContext.client, "Input port" as CFString, &inputPort, midiReadBlock)
+        }
 
         NotificationCenter.default.addObserver(self, selector: #selector(self.midiObjectListChanged(_:)), name: .midiObjectListChanged, object: midiContext)
     }
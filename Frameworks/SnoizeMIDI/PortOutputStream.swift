@@ -49,8 +49,18 @@ public class PortOutputStream: OutputStream {
         return Array(sysExSendRequests)
     }
 
+    // Unschedules messages that were sent with time stamps in the future, and haven't been sent to the destinations yet
+    public func flushScheduledMessages() {
+        for destination in destinations {
+            _ = midiContext.interface.flushOutput(destination.endpointRef)
+        }
+    }
+
     public var customSysExBufferSize: Int = 0
 
+    // Buffer sizes to use instead of customSysExBufferSize for particular destinations, by unique ID
+    public var destinationCustomSysExBufferSizes: [MIDIUniqueID: Int] = [:]
+
     // MARK: OutputStream overrides
 
     public override func takeMIDIMessages(_ messages: [Message]) {
@@ -132,14 +142,21 @@ public class PortOutputStream: OutputStream {
 
     private func sendSysExMessagesAsynchronously(_ messages: [SystemExclusiveMessage]) {
         for message in messages {
+            // Each destination gets its own request, so they're all sent at once, each at its own speed
             for destination in destinations {
-                if let request = SysExSendRequest(message: message, destination: destination, customSysExBufferSize: customSysExBufferSize) {
+                let bufferSize = destinationCustomSysExBufferSizes[destination.uniqueID] ?? customSysExBufferSize
+                if let request = SysExSendRequest(message: message, destination: destination, customSysExBufferSize: bufferSize) {
                     sysExSendRequests.insert(request)
                     request.delegate = self
 
                     delegate?.portOutputStream(self, willBeginSendingSysEx: request)
 
-                    request.send()
+                    if !request.send() {
+                        // The request won't finish by itself, so end it now, or the delegate would wait for it forever
+                        sysExSendRequests.remove(request)
+                        request.delegate = nil
+                        delegate?.portOutputStream(self, didEndSendingSysEx: request)
+                    }
                 }
             }
         }
@@ -5,70 +5,110 @@
  LICENSE file in the root directory of this source tree.
  */
 
-#import "SMHostTimeUtilities.h"
+#include "SMHostTimeUtilities.h"
 
-#if TARGET_OS_OSX
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 
-#import <CoreAudio/CoreAudio.h>
-
-#elif TARGET_OS_IPHONE
-
-#import <mach/mach_time.h>
-#import <pthread.h>
-
-static pthread_once_t sIsInited;
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#elif defined(__linux__)
+#include <time.h>
+#else
+#error Unsupported platform
+#endif
 
-static UInt32 sToNanosNumerator;
-static UInt32 sToNanosDenominator;
+// A ratio numerator / denominator, stored as a whole part and a 64-bit binary fraction,
+// so multiplying by it takes one 64x64 -> 128 bit multiply instead of a 128-bit divide.
+// Because the fraction is rounded down, the product is at most 1 less than the exact answer.
+typedef struct {
+    UInt64 whole;
+    UInt64 fraction;    // in units of 1 / 2^64
+    bool isOne;
+} Ratio;
+
+static pthread_once_t sIsInited = PTHREAD_ONCE_INIT;
+
+static Ratio sHostTimeToNanos;
+static Ratio sNanosToHostTime;
+
+static Ratio MakeRatio(uint32_t numerator, uint32_t denominator) {
+    Ratio ratio;
+    ratio.whole = numerator / denominator;
+    ratio.fraction = (UInt64)(((__uint128_t)(numerator % denominator) << 64) / denominator);
+    ratio.isOne = (numerator == denominator);
+    return ratio;
+}
 
 static void Initialize(void) {
+    uint32_t toNanosNumerator = 1;
+    uint32_t toNanosDenominator = 1;
+
+#if defined(__APPLE__)
     struct mach_timebase_info theTimeBaseInfo;
     mach_timebase_info(&theTimeBaseInfo);
 
-    sToNanosNumerator = theTimeBaseInfo.numer;
-    sToNanosDenominator = theTimeBaseInfo.denom;
+    toNanosNumerator = theTimeBaseInfo.numer;
+    toNanosDenominator = theTimeBaseInfo.denom;
+#endif
+
+    sHostTimeToNanos = MakeRatio(toNanosNumerator, toNanosDenominator);
+    sNanosToHostTime = MakeRatio(toNanosDenominator, toNanosNumerator);
 }
 
-static UInt64 MultiplyByRatio(UInt64 inMuliplicand, UInt32 inNumerator, UInt32 inDenominator) {
-    __uint128_t theAnswer = inMuliplicand;
-    if (inNumerator != inDenominator) {
-        theAnswer *= inNumerator;
-        theAnswer /= inDenominator;
+static inline UInt64 MultiplyByRatio(UInt64 value, const Ratio *ratio) {
+    if (ratio->isOne) {
+        return value;
     }
-    return (UInt64)theAnswer;
+    return value * ratio->whole + (UInt64)(((__uint128_t)value * ratio->fraction) >> 64);
 }
 
-#endif  // TARGET_OS_IPHONE
+static void MultiplyArrayByRatio(const UInt64 *values, UInt64 *results, size_t count, const Ratio *ratio) {
+    if (ratio->isOne) {
+        if (results != values) {
+            for (size_t i = 0; i < count; i++) {
+                results[i] = values[i];
+            }
+        }
+        return;
+    }
+
+    const UInt64 whole = ratio->whole;
+    const UInt64 fraction = ratio->fraction;
+    for (size_t i = 0; i < count; i++) {
+        UInt64 value = values[i];
+        results[i] = value * whole + (UInt64)(((__uint128_t)value * fraction) >> 64);
+    }
+}
 
 
 UInt64 SMGetCurrentHostTime(void) {
-#if TARGET_OS_OSX
-    return AudioGetCurrentHostTime();
-#elif TARGET_OS_IPHONE
+#if defined(__APPLE__)
     return mach_absolute_time();
-#else
-#error Unsupported platform
+#elif defined(__linux__)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (UInt64)now.tv_sec * 1000000000ULL + (UInt64)now.tv_nsec;
 #endif
 }
 
 UInt64 SMConvertHostTimeToNanos(UInt64 hostTime) {
-#if TARGET_OS_OSX
-    return AudioConvertHostTimeToNanos(hostTime);
-#elif TARGET_OS_IPHONE
     pthread_once(&sIsInited, Initialize);
-    return MultiplyByRatio(hostTime, sToNanosNumerator, sToNanosDenominator);
-#else
-#error Unsupported platform
-#endif
+    return MultiplyByRatio(hostTime, &sHostTimeToNanos);
 }
 
 UInt64 SMConvertNanosToHostTime(UInt64 nanos) {
-#if TARGET_OS_OSX
-    return AudioConvertNanosToHostTime(nanos);
-#elif TARGET_OS_IPHONE
     pthread_once(&sIsInited, Initialize);
-    return MultiplyByRatio(nanos, sToNanosDenominator, sToNanosNumerator);
-#else
-#error Unsupported platform
-#endif
+    return MultiplyByRatio(nanos, &sNanosToHostTime);
+}
+
+void SMConvertHostTimesToNanos(const UInt64 *hostTimes, UInt64 *nanos, size_t count) {
+    pthread_once(&sIsInited, Initialize);
+    MultiplyArrayByRatio(hostTimes, nanos, count, &sHostTimeToNanos);
+}
+
+void SMConvertNanosToHostTimes(const UInt64 *nanos, UInt64 *hostTimes, size_t count) {
+    pthread_once(&sIsInited, Initialize);
+    MultiplyArrayByRatio(nanos, hostTimes, count, &sNanosToHostTime);
 }
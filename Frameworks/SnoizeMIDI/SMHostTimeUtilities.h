@@ -5,22 +5,31 @@
  LICENSE file in the root directory of this source tree.
  */
 
+#if defined(__APPLE__)
 #import <CoreFoundation/CoreFoundation.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+typedef uint64_t UInt64;
+#endif
 
-// These handy CoreAudio functions are present on macOS but not other platforms,
-// for no apparent reason:
+// Our replacements for these CoreAudio functions, which are present on macOS but not other platforms:
 //     AudioGetCurrentHostTime()
 //     AudioConvertHostTimeToNanos()
 //     AudioConvertNanosToHostTime()
 //
-// They have obvious implementations, which Apple even publishes in sample code:
-//     https://developer.apple.com/library/archive/samplecode/CoreAudioUtilityClasses/Introduction/Intro.html
-// in the class CAHostTimeBase.
+// Every platform, including macOS, uses these implementations instead of CoreAudio's.
+// Host time is mach_absolute_time() on Apple platforms, and CLOCK_MONOTONIC in nanoseconds on Linux.
 //
-// So we cover the CoreAudio functions with our own, which work on non-macOS.
-// The only reason this is C code is because it's extracted from the C++ sample code,
-// and it wasn't worthwhile to take the risk of translating to Swift.
+// Unlike CoreAudio (and Apple's sample code in CAHostTimeBase), conversions don't multiply and then divide
+// by the timebase. The timebase ratio is computed once, as a whole part and a 64-bit binary fraction,
+// so each conversion is a single multiply, cheap enough to do for every message.
+// Because the fraction is rounded down, results may be 1 ns less than exact, never more.
 
 extern UInt64 SMGetCurrentHostTime(void);
 extern UInt64 SMConvertHostTimeToNanos(UInt64 hostTime);
 extern UInt64 SMConvertNanosToHostTime(UInt64 nanos);
+
+// Convert `count` values at once. The input and output may be the same array.
+extern void SMConvertHostTimesToNanos(const UInt64 *hostTimes, UInt64 *nanos, size_t count);
+extern void SMConvertNanosToHostTimes(const UInt64 *nanos, UInt64 *hostTimes, size_t count);
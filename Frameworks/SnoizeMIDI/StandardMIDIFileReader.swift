@@ -0,0 +1,154 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public struct StandardMIDIFileReader {
+
+    // Walks through the events in a Standard MIDI File's track chunks, directly,
+    // without building any intermediate representation of the whole file.
+    //
+    // Each event's data is a slice of the file's data, not a copy, so this works well
+    // on data that is memory-mapped from a file (Data(contentsOf:options: .alwaysMapped)).
+
+    public init(data: Data) {
+        self.data = data
+    }
+
+    public let data: Data
+
+    public struct Event {
+        public enum Kind {
+            case channel(status: UInt8)     // data is the bytes after the status byte
+            case sysEx                      // 0xF0 event; data is the bytes after the 0xF0, perhaps ending with 0xF7
+            case escape                     // 0xF7 event; data is the bytes after the length
+            case meta(type: UInt8)          // data is the meta event's contents
+        }
+
+        public let trackIndex: Int
+        public let tick: UInt64             // since the start of the track
+        public let kind: Kind
+        public let data: Data
+    }
+
+    // Call `body` for each event in each track, in the order they appear in the file.
+    // Returns false if the file is not a MIDI file, or is damaged; in that case,
+    // `body` has already been called for every event before the damage.
+    @discardableResult public func forEachEvent(_ body: (Event) -> Void) -> Bool {
+        data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> Bool in
+            guard bytes.count >= 14, Self.chunkType(bytes, at: 0) == Self.headerChunkType else { return false }
+
+            var chunkOffset = 0
+            var trackIndex = 0
+            while chunkOffset + 8 <= bytes.count {
+                let chunkType = Self.chunkType(bytes, at: chunkOffset)
+                let chunkLength = Int(Self.bigEndianUInt32(bytes, at: chunkOffset + 4))
+                let chunkStart = chunkOffset + 8
+                // Be lenient about a final chunk that claims to be longer than the file
+                let chunkEnd = min(chunkStart + chunkLength, bytes.count)
+
+                if chunkType == Self.trackChunkType {
+                    guard scanTrack(bytes, chunkStart ..< chunkEnd, trackIndex: trackIndex, body) else { return false }
+                    trackIndex += 1
+                }
+
+                chunkOffset = chunkEnd
+            }
+
+            return true
+        }
+    }
+
+    // MARK: Private
+
+    private static let headerChunkType = UInt32(0x4D54_6864)    // "MThd"
+    private static let trackChunkType = UInt32(0x4D54_726B)     // "MTrk"
+
+    private func scanTrack(_ bytes: UnsafeRawBufferPointer, _ range: Range<Int>, trackIndex: Int, _ body: (Event) -> Void) -> Bool {
+        var offset = range.lowerBound
+        let end = range.upperBound
+        var tick: UInt64 = 0
+        var runningStatus: UInt8 = 0
+
+        func readVariableLengthQuantity() -> UInt64? {
+            // At most 4 bytes, 7 bits each, most significant first
+            var value: UInt64 = 0
+            for _ in 0 ..< 4 {
+                guard offset < end else { return nil }
+                let byte = bytes[offset]
+                offset += 1
+                value = (value << 7) | UInt64(byte & 0x7F)
+                if byte & 0x80 == 0 {
+                    return value
+                }
+            }
+            return nil
+        }
+
+        func takeEvent(_ kind: Event.Kind, length: Int) -> Bool {
+            guard length <= end - offset else { return false }
+            let slice = data[(data.startIndex + offset) ..< (data.startIndex + offset + length)]
+            offset += length
+            body(Event(trackIndex: trackIndex, tick: tick, kind: kind, data: slice))
+            return true
+        }
+
+        while offset < end {
+            guard let delta = readVariableLengthQuantity(), offset < end else { return false }
+            tick += delta
+
+            var status = bytes[offset]
+            if status < 0x80 {
+                // Running status: this byte is data, and the status is the same as the previous channel event's
+                guard runningStatus != 0 else { return false }
+                status = runningStatus
+            }
+            else {
+                offset += 1
+            }
+
+            switch status {
+            case 0xFF:
+                guard offset < end else { return false }
+                let metaType = bytes[offset]
+                offset += 1
+                guard let length = readVariableLengthQuantity(),
+                      takeEvent(.meta(type: metaType), length: Int(length)) else { return false }
+                runningStatus = 0
+                if metaType == 0x2F {
+                    // End of track
+                    return true
+                }
+
+            case 0xF0, 0xF7:
+                guard let length = readVariableLengthQuantity(),
+                      takeEvent(status == 0xF0 ? .sysEx : .escape, length: Int(length)) else { return false }
+                runningStatus = 0
+
+            case 0x80 ... 0xEF:
+                runningStatus = status
+                let length = (status & 0xF0 == 0xC0 || status & 0xF0 == 0xD0) ? 1 : 2
+                guard takeEvent(.channel(status: status), length: length) else { return false }
+
+            default:
+                // Other system messages can't appear in a MIDI file, except inside escape events
+                return false
+            }
+        }
+
+        return true
+    }
+
+    private static func chunkType(_ bytes: UnsafeRawBufferPointer, at offset: Int) -> UInt32 {
+        bigEndianUInt32(bytes, at: offset)
+    }
+
+    private static func bigEndianUInt32(_ bytes: UnsafeRawBufferPointer, at offset: Int) -> UInt32 {
+        UInt32(bytes[offset]) << 24 | UInt32(bytes[offset + 1]) << 16 | UInt32(bytes[offset + 2]) << 8 | UInt32(bytes[offset + 3])
+    }
+
+}
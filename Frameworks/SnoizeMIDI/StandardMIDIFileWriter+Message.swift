@@ -0,0 +1,40 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+extension StandardMIDIFileWriter {
+
+    // Write a message at the given tick. Ticks must not go backwards; if they do,
+    // the message is written at the previous tick instead.
+    // Messages which can't be represented in a MIDI file (invalid messages) are skipped.
+    public func write(_ message: Message, atTick tick: UInt64) throws {
+        guard !message.matchesMessageTypeMask(.invalid) else { return }
+
+        if let sysExMessage = message as? SystemExclusiveMessage {
+            try writeEvent(status: 0xF0, data: sysExMessage.data, atTick: tick)
+        }
+        else {
+            try writeEvent(status: message.statusByte, data: message.otherData ?? Data(), atTick: tick)
+        }
+    }
+
+    // Write messages with the same relative timing they had when they were received.
+    // The earliest message is at tick 0.
+    public func writeWithOriginalTiming(_ messages: [Message]) throws {
+        var nanos = messages.map(\.hostTimeStamp)
+        nanos.withUnsafeMutableBufferPointer {
+            SMConvertHostTimesToNanos($0.baseAddress, $0.baseAddress, $0.count)
+        }
+
+        guard let startNanos = nanos.min() else { return }
+        for (message, messageNanos) in zip(messages, nanos) {
+            try write(message, atTick: tick(forNanoseconds: messageNanos - startNanos))
+        }
+    }
+
+}
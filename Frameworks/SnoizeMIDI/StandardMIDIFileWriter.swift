@@ -0,0 +1,257 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public class StandardMIDIFileWriter {
+
+    // Writes a Standard MIDI File (format 0, one track) as it goes, instead of building
+    // the whole file in memory first.
+    //
+    // Output goes to a file descriptor, in large buffered writes, or to memory.
+    // The length of the track chunk isn't known until the end, so a placeholder is written
+    // at first, and finish() goes back and fills it in.
+    //
+    // Times are in ticks. With the default settings, a tick is 100 microseconds.
+    //
+    // Messages are given as plain bytes, so this doesn't depend on CoreMIDI.
+    // StandardMIDIFileWriter+Message.swift adds ways to write SnoizeMIDI's Messages.
+
+    public static let defaultTicksPerQuarterNote: UInt16 = 5000
+    public static let defaultMicrosecondsPerQuarterNote: UInt32 = 500_000  // 120 BPM
+
+    // Write to memory. Get the result from `data` after calling finish().
+    public init(ticksPerQuarterNote: UInt16 = defaultTicksPerQuarterNote, microsecondsPerQuarterNote: UInt32 = defaultMicrosecondsPerQuarterNote) {
+        self.ticksPerQuarterNote = ticksPerQuarterNote
+        self.microsecondsPerQuarterNote = microsecondsPerQuarterNote
+        self.fileDescriptor = -1
+        self.fileStartOffset = 0
+        writeHeader()
+    }
+
+    // Write to a file descriptor, starting at its current offset. It must be seekable.
+    // The caller is responsible for closing it.
+    public init(fileDescriptor: Int32, ticksPerQuarterNote: UInt16 = defaultTicksPerQuarterNote, microsecondsPerQuarterNote: UInt32 = defaultMicrosecondsPerQuarterNote) throws {
+        let offset = lseek(fileDescriptor, 0, SEEK_CUR)
+        guard offset >= 0 else { throw Self.posixError() }
+
+        self.ticksPerQuarterNote = ticksPerQuarterNote
+        self.microsecondsPerQuarterNote = microsecondsPerQuarterNote
+        self.fileDescriptor = fileDescriptor
+        self.fileStartOffset = offset
+        writeHeader()
+    }
+
+    public let ticksPerQuarterNote: UInt16
+    public let microsecondsPerQuarterNote: UInt32
+
+    // When writing to memory, the file so far
+    public private(set) var data = Data()
+
+    public func tick(forNanoseconds nanos: UInt64) -> UInt64 {
+        // ticks = nanos * ticksPerQuarterNote / (microsecondsPerQuarterNote * 1000), without overflow or rounding error
+        let divisor = UInt64(microsecondsPerQuarterNote) * 1000
+        let product = nanos.multipliedFullWidth(by: UInt64(ticksPerQuarterNote))
+        guard product.high < divisor else { return UInt64.max }
+        return divisor.dividingFullWidth(product).quotient
+    }
+
+    // Write a MIDI message, given as its bytes, at the given tick: a status byte followed by its data,
+    // or a whole sysex message starting with 0xF0 (the 0xF7 at the end may be left off).
+    // Ticks must not go backwards; if they do, the message is written at the previous tick instead.
+    // Bytes that don't start with a status byte can't be represented in a MIDI file, so they're skipped.
+    public func write(_ bytes: Data, atTick tick: UInt64) throws {
+        guard let status = bytes.first, status >= 0x80, status != 0xF7 else { return }
+
+        var data = bytes.dropFirst()
+        if status == 0xF0 && data.last == 0xF7 {
+            data = data.dropLast()
+        }
+        try writeEvent(status: status, data: data, atTick: tick)
+    }
+
+    // Write an event given its status byte, and the data after it (for sysex, not including the 0xF7)
+    func writeEvent(status: UInt8, data: Data, atTick tick: UInt64) throws {
+        precondition(!isFinished)
+
+        if status == 0xF0 {
+            // 0xF0, length, then the rest of the message including the 0xF7
+            writeDeltaTime(toTick: tick)
+            buffer.append(0xF0)
+            appendVariableLengthQuantity(UInt64(data.count + 1))
+            buffer.append(data)
+            buffer.append(0xF7)
+            runningStatus = 0
+        }
+        else if status >= 0xF0 {
+            // System common and real time messages don't exist in MIDI files,
+            // but they can be written as "escaped" events: 0xF7, length, then the bytes.
+            writeDeltaTime(toTick: tick)
+            buffer.append(0xF7)
+            appendVariableLengthQuantity(UInt64(1 + data.count))
+            buffer.append(status)
+            buffer.append(data)
+            runningStatus = 0
+        }
+        else {
+            // Channel messages may use running status
+            writeDeltaTime(toTick: tick)
+            if status != runningStatus {
+                buffer.append(status)
+                runningStatus = status
+            }
+            buffer.append(data)
+        }
+
+        try flushIfNeeded()
+    }
+
+    // Write the end of the track, and fill in its length.
+    // After this, nothing else may be written.
+    public func finish() throws {
+        precondition(!isFinished)
+        isFinished = true
+
+        // End of track meta event
+        writeDeltaTime(toTick: currentTick)
+        buffer.append(contentsOf: [0xFF, 0x2F, 0x00])
+
+        let trackLength = writtenByteCount + buffer.count - Self.trackDataOffset
+        guard let trackLength32 = UInt32(exactly: trackLength) else {
+            throw NSError(domain: NSPOSIXErrorDomain, code: Int(EFBIG), userInfo: nil)
+        }
+        let trackLengthBytes = withUnsafeBytes(of: trackLength32.bigEndian) { Data($0) }
+
+        if fileDescriptor >= 0 {
+            try flush()
+            let result = trackLengthBytes.withUnsafeBytes {
+                pwrite(fileDescriptor, $0.baseAddress, $0.count, fileStartOffset + off_t(Self.trackLengthOffset))
+            }
+            guard result == trackLengthBytes.count else { throw Self.posixError() }
+        }
+        else {
+            let start = buffer.startIndex + Self.trackLengthOffset
+            buffer.replaceSubrange(start ..< start + trackLengthBytes.count, with: trackLengthBytes)
+            data = buffer
+        }
+    }
+
+    // MARK: Private
+
+    private let fileDescriptor: Int32
+    private let fileStartOffset: off_t
+
+    private var buffer = Data()
+    private var writtenByteCount = 0
+    private var currentTick: UInt64 = 0
+    private var runningStatus: UInt8 = 0
+    private var isFinished = false
+
+    private static let flushThreshold = 64 * 1024
+    private static let trackLengthOffset = 14 + 4   // after the header chunk, and "MTrk"
+    private static let trackDataOffset = 14 + 8
+    private static let maxDeltaTime: UInt64 = 0x0FFF_FFFF   // the largest that fits in 4 bytes
+
+    private func writeHeader() {
+        buffer.append(contentsOf: Array("MThd".utf8))
+        appendBigEndian(UInt32(6))
+        appendBigEndian(UInt16(0))      // format 0
+        appendBigEndian(UInt16(1))      // one track
+        appendBigEndian(ticksPerQuarterNote)
+
+        buffer.append(contentsOf: Array("MTrk".utf8))
+        appendBigEndian(UInt32(0))      // length, filled in by finish()
+
+        // Tempo meta event at time 0
+        appendVariableLengthQuantity(0)
+        buffer.append(contentsOf: [0xFF, 0x51, 0x03])
+        buffer.append(contentsOf: [UInt8(truncatingIfNeeded: microsecondsPerQuarterNote >> 16), UInt8(truncatingIfNeeded: microsecondsPerQuarterNote >> 8), UInt8(truncatingIfNeeded: microsecondsPerQuarterNote)])
+    }
+
+    private func writeDeltaTime(toTick tick: UInt64) {
+        var delta = tick > currentTick ? tick - currentTick : 0
+        currentTick += delta
+
+        // A delta time can only be so large. To go further, write empty text meta events.
+        while delta > Self.maxDeltaTime {
+            appendVariableLengthQuantity(Self.maxDeltaTime)
+            buffer.append(contentsOf: [0xFF, 0x01, 0x00])
+            delta -= Self.maxDeltaTime
+            runningStatus = 0
+        }
+
+        appendVariableLengthQuantity(delta)
+    }
+
+    private func appendVariableLengthQuantity(_ value: UInt64) {
+        // 7 bits per byte, most significant first, with the high bit set on all but the last byte
+        var bytes: [UInt8] = [UInt8(value & 0x7F)]
+        var remaining = value >> 7
+        while remaining > 0 {
+            bytes.append(UInt8(remaining & 0x7F) | 0x80)
+            remaining >>= 7
+        }
+        buffer.append(contentsOf: bytes.reversed())
+    }
+
+    private func appendBigEndian<T: FixedWidthInteger>(_ value: T) {
+        withUnsafeBytes(of: value.bigEndian) { buffer.append(contentsOf: $0) }
+    }
+
+    private func flushIfNeeded() throws {
+        if fileDescriptor >= 0 && buffer.count >= Self.flushThreshold {
+            try flush()
+        }
+    }
+
+    private func flush() throws {
+        try buffer.withUnsafeBytes { (rawBufferPtr: UnsafeRawBufferPointer) in
+            guard let baseAddress = rawBufferPtr.baseAddress else { return }
+            var offset = 0
+            while offset < rawBufferPtr.count {
+                let result = Foundation.write(fileDescriptor, baseAddress + offset, rawBufferPtr.count - offset)
+                if result < 0 {
+                    if errno == EINTR {
+                        continue
+                    }
+                    throw Self.posixError()
+                }
+                offset += result
+            }
+        }
+
+        writtenByteCount += buffer.count
+        buffer.removeAll(keepingCapacity: true)
+    }
+
+    private static func posixError() -> Error {
+        NSError(domain: NSPOSIXErrorDomain, code: Int(errno), userInfo: nil)
+    }
+
+}
+
+extension StandardMIDIFileWriter {
+
+    // Write a new file at `url`, replacing any existing file, by calling `body` with a writer and then finishing.
+    public static func writeFile(at url: URL, body: (StandardMIDIFileWriter) throws -> Void) throws {
+        let fileDescriptor = open(url.path, O_WRONLY | O_CREAT | O_TRUNC, 0o644)
+        guard fileDescriptor >= 0 else { throw posixError() }
+        defer { close(fileDescriptor) }
+
+        do {
+            let writer = try StandardMIDIFileWriter(fileDescriptor: fileDescriptor)
+            try body(writer)
+            try writer.finish()
+        }
+        catch {
+            // Don't leave a partial file behind
+            unlink(url.path)
+            throw error
+        }
+    }
+
+}
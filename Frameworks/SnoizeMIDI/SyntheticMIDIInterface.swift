@@ -0,0 +1,976 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import CoreMIDI
+
+public final class SyntheticMIDIInterface {
+
+    // Stands in for CoreMIDI, so input streams, output streams, sysex sending, and everything that
+    // depends on them can be measured and tested without any MIDI hardware.
+    // Use it with MIDIContext(syntheticInterface:).
+    //
+    // There is one device, with `sourceCount` sources and `destinationCount` destinations, plus any
+    // virtual endpoints that get created. start() generates traffic from the device's sources on a
+    // background thread, and passes it to the read blocks of the input ports that are connected to them,
+    // like CoreMIDI does. The traffic is deterministic: the same Traffic always makes the same bytes,
+    // in the same packet lists, with the same time stamps relative to the start.
+    //
+    // Everything given to send(), sendSysex() and received() is recorded in `sentPackets`.
+    // Packets sent to a virtual destination are given to its read block at their time stamps.
+    // If `loopsBack` is set, packets sent to the device's Nth destination come back from its Nth source,
+    // like a cable from the device's output to its input. Set `loopbackBytesPerSecond` to make the loopback
+    // lose data when it's sent too fast, like a device whose input buffer overflows.
+    //
+    // Thread-safe, like CoreMIDI. The read blocks are called without the lock held.
+
+    public init(sourceCount: Int = 1, destinationCount: Int = 1) {
+        deviceSourceCount = sourceCount
+        deviceDestinationCount = destinationCount
+
+        clientRef = addObject(kind: .client, parent: 0)
+        deviceRef = addObject(kind: .device, parent: 0, name: "Synthetic Device")
+        entityRef = addObject(kind: .entity, parent: deviceRef, name: "Synthetic Device")
+        for index in 0 ..< sourceCount {
+            sourceRefs.append(addObject(kind: .source, parent: entityRef, name: "Synthetic Source \(index + 1)"))
+        }
+        for index in 0 ..< destinationCount {
+            destinationRefs.append(addObject(kind: .destination, parent: entityRef, name: "Synthetic Destination \(index + 1)"))
+        }
+    }
+
+    deinit {
+        stop()
+    }
+
+    public var loopsBack: Bool {
+        get { locked { _loopsBack } }
+        set { locked { _loopsBack = newValue } }
+    }
+
+    // How fast sendSysex() sends, in bytes per second, unless the destination's max sysex speed property
+    // is set. 0 sends as fast as possible.
+    public var sysExBytesPerSecond: Int {
+        get { locked { _sysExBytesPerSecond } }
+        set { locked { _sysExBytesPerSecond = newValue } }
+    }
+
+    // The loopback acts like a device that can only take in this many bytes per second, and holds up to
+    // `loopbackBufferSize` bytes while it catches up. Bytes that arrive when its buffer is full are lost.
+    // 0 means it keeps up with anything.
+    public var loopbackBytesPerSecond: Int {
+        get { locked { _loopbackBytesPerSecond } }
+        set { locked { _loopbackBytesPerSecond = newValue } }
+    }
+
+    public var loopbackBufferSize: Int {
+        get { locked { _loopbackBufferSize } }
+        set { locked { _loopbackBufferSize = newValue } }
+    }
+
+    public var loopbackLostByteCount: Int {
+        locked { _loopbackLostByteCount }
+    }
+
+    // MARK: Traffic
+
+    public struct Traffic {
+
+        public enum Pattern {
+            case clock                                          // timing clock, as dense as MIDI traffic gets
+            case controlSweep(channel: UInt8, controller: UInt8)    // values up from 0 to 127 and back down, repeatedly
+            case sysEx(length: Int)                             // sysex messages of this many bytes, including F0 and F7
+            case bursts(size: Int)                              // this many note messages, all at the same time
+        }
+
+        public init(pattern: Pattern, count: Int, rate: Double, sourceIndex: Int = 0, seed: UInt64 = 0) {
+            self.pattern = pattern
+            self.count = count
+            self.rate = rate
+            self.sourceIndex = sourceIndex
+            self.seed = seed
+        }
+
+        public var pattern: Pattern
+        public var count: Int           // how many messages, or bursts
+        public var rate: Double         // messages or bursts per second. 0 sends them as fast as possible.
+        public var sourceIndex: Int     // which of the device's sources sends it
+        public var seed: UInt64         // for the random parts: sysex data and burst notes
+
+    }
+
+    // The most packets to put in each packet list. When traffic is sent as fast as possible,
+    // this sets how much work each call to a read block does.
+    public var packetsPerRead = 16
+
+    public private(set) var isRunning = false
+
+    // Starts sending the traffic, all at once. `completion` is called on the main queue after the last
+    // packet list has been given to the read blocks, so anything they dispatched to the main queue
+    // has already happened. Call start() and stop() on the main queue.
+    public func start(_ traffic: [Traffic], completion: (() -> Void)? = nil) {
+        stop()
+
+        locked {
+            isStopping = false
+            _generatedPacketCount = 0
+            _generatedByteCount = 0
+        }
+        isRunning = true
+        runGeneration += 1
+        let generation = runGeneration
+
+        let deviceSourceRefs = locked { sourceRefs.prefix(deviceSourceCount) }
+        let generators = traffic.map { TrafficGenerator($0, sourceRef: deviceSourceRefs.indices.contains($0.sourceIndex) ? deviceSourceRefs[$0.sourceIndex] : 0) }
+        let packetsPerRead = max(packetsPerRead, 1)
+        let generatorGroup = generatorGroup
+        generatorGroup.enter()
+        let thread = Thread { [weak self] in
+            self?.generate(generators, packetsPerRead: packetsPerRead)
+            generatorGroup.leave()
+            DispatchQueue.main.async {
+                guard let self, self.runGeneration == generation else { return }
+                self.isRunning = false
+                completion?()
+            }
+        }
+        thread.qualityOfService = .userInteractive
+        thread.name = "SyntheticMIDIInterface"
+        thread.start()
+    }
+
+    // Stops sending traffic, and waits for the generator thread to finish. The completion isn't called.
+    public func stop() {
+        guard isRunning else { return }
+
+        locked { isStopping = true }
+        generatorGroup.wait()
+        isRunning = false
+        runGeneration += 1      // so the completion isn't called
+    }
+
+    // What the last start() has generated so far
+    public var generatedPacketCount: Int {
+        locked { _generatedPacketCount }
+    }
+
+    public var generatedByteCount: Int {
+        locked { _generatedByteCount }
+    }
+
+    // MARK: Recording
+
+    public struct SentPacket {
+
+        public enum Kind {
+            case send           // MIDISend(), to a destination
+            case sysEx          // MIDISendSysex(), to a destination. Recorded when it starts.
+            case received       // MIDIReceived(), from a virtual source
+        }
+
+        public let kind: Kind
+        public let endpointUniqueID: MIDIUniqueID
+        public let timeStamp: MIDITimeStamp
+        public let hostTime: MIDITimeStamp      // when it was recorded
+        public let data: Data
+
+    }
+
+    // Turn this off to only count what is sent, for example when sending many megabytes
+    public var recordsSentPackets: Bool {
+        get { locked { _recordsSentPackets } }
+        set { locked { _recordsSentPackets = newValue } }
+    }
+
+    public var sentPackets: [SentPacket] {
+        locked { _sentPackets }
+    }
+
+    public var sentByteCount: Int {
+        locked { _sentByteCount }
+    }
+
+    public var flushCount: Int {
+        locked { _flushCount }
+    }
+
+    public func removeSentPackets() {
+        locked {
+            _sentPackets = []
+            _sentByteCount = 0
+            _flushCount = 0
+            _loopbackLostByteCount = 0
+        }
+    }
+
+    // MARK: Private
+
+    private let lock = NSLock()
+
+    private func locked<T>(_ body: () -> T) -> T {
+        lock.lock()
+        defer { lock.unlock() }
+        return body()
+    }
+
+    private var _loopsBack = false
+    private var _sysExBytesPerSecond = 3125
+    private var _loopbackBytesPerSecond = 0
+    private var _loopbackBufferSize = 512
+    private var _loopbackLostByteCount = 0
+    private var _recordsSentPackets = true
+    private var _sentPackets: [SentPacket] = []
+    private var _sentByteCount = 0
+    private var _flushCount = 0
+    private var _generatedPacketCount = 0
+    private var _generatedByteCount = 0
+
+    private var isStopping = false
+    private var runGeneration = 0       // only used on the main queue, like start() and stop()
+    private let generatorGroup = DispatchGroup()
+    private let deliveryQueue = DispatchQueue(label: "SyntheticMIDIInterface.delivery", qos: .userInteractive)
+    private let sysExQueue = DispatchQueue(label: "SyntheticMIDIInterface.sysex")
+
+    // MARK: Objects
+
+    private enum ObjectKind {
+        case client, device, entity, source, destination, inputPort, outputPort
+    }
+
+    private enum PropertyValue {
+        case integer(Int32)
+        case string(CFString)
+        case data(CFData)
+    }
+
+    private final class Object {
+
+        init(kind: ObjectKind, parent: MIDIObjectRef) {
+            self.kind = kind
+            self.parent = parent
+        }
+
+        let kind: ObjectKind
+        let parent: MIDIObjectRef
+        var properties: [String: PropertyValue] = [:]
+
+        var readBlock: MIDIReadBlock?           // for input ports and virtual destinations
+        var receiveBlock: MIDIReceiveBlock?     // for input ports created with a protocol
+        var receiveProtocol = MIDIProtocolID._1_0
+        var connections: [MIDIEndpointRef: UnsafeMutableRawPointer?] = [:]   // for input ports, source to refCon
+        var flushGeneration = 0                 // for destinations, to cancel scheduled packets
+        var loopbackBufferedByteCount = 0.0     // for destinations, when the loopback loses data
+        var loopbackHostTime: MIDITimeStamp = 0
+
+    }
+
+    private var objects: [MIDIObjectRef: Object] = [:]
+    private var nextObjectRef: MIDIObjectRef = 0x1000
+    private var nextUniqueID: MIDIUniqueID = 0x5E00_0001
+    private var clientRef: MIDIClientRef = 0
+    private var deviceRef: MIDIDeviceRef = 0
+    private var entityRef: MIDIEntityRef = 0
+    private var sourceRefs: [MIDIEndpointRef] = []          // the device's, then virtual ones
+    private var destinationRefs: [MIDIEndpointRef] = []
+    private let deviceSourceCount: Int
+    private let deviceDestinationCount: Int
+
+    private func addObject(kind: ObjectKind, parent: MIDIObjectRef, name: String? = nil) -> MIDIObjectRef {
+        // Call with the lock held, or from init
+        let objectRef = nextObjectRef
+        nextObjectRef += 1
+
+        let object = Object(kind: kind, parent: parent)
+        if let name {
+            object.properties[kMIDIPropertyName as String] = .string(name as CFString)
+            object.properties[kMIDIPropertyDisplayName as String] = .string(name as CFString)
+            object.properties[kMIDIPropertyUniqueID as String] = .integer(nextUniqueID)
+            nextUniqueID += 1
+        }
+        objects[objectRef] = object
+        return objectRef
+    }
+
+    private func removeEndpoint(_ endpointRef: MIDIEndpointRef) {
+        // Call with the lock held
+        objects[endpointRef] = nil
+        sourceRefs.removeAll { $0 == endpointRef }
+        destinationRefs.removeAll { $0 == endpointRef }
+        for object in objects.values where object.kind == .inputPort {
+            object.connections[endpointRef] = nil
+        }
+    }
+
+    private func setProperty(_ obj: MIDIObjectRef, _ propertyID: CFString, _ value: PropertyValue) -> OSStatus {
+        locked {
+            guard let object = objects[obj] else { return OSStatus(kMIDIObjectNotFound) }
+            object.properties[propertyID as String] = value
+            if propertyID == kMIDIPropertyName {
+                object.properties[kMIDIPropertyDisplayName as String] = value
+            }
+            return noErr
+        }
+    }
+
+    private func property(_ obj: MIDIObjectRef, _ propertyID: CFString) -> PropertyValue? {
+        locked {
+            objects[obj]?.properties[propertyID as String]
+        }
+    }
+
+    // MARK: Generating traffic
+
+    private struct Packet {
+        let timeStamp: MIDITimeStamp
+        let bytes: [UInt8]
+    }
+
+    private struct RandomNumberGenerator {
+
+        // SplitMix64, which is simple and fast, and gives the same numbers everywhere for the same seed
+
+        init(seed: UInt64) {
+            state = seed
+        }
+
+        mutating func next() -> UInt64 {
+            state &+= 0x9E37_79B9_7F4A_7C15
+            var value = state
+            value = (value ^ (value >> 30)) &* 0xBF58_476D_1CE4_E5B9
+            value = (value ^ (value >> 27)) &* 0x94D0_49BB_1331_11EB
+            return value ^ (value >> 31)
+        }
+
+        private var state: UInt64
+
+    }
+
+    private struct TrafficGenerator {
+
+        init(_ traffic: Traffic, sourceRef: MIDIEndpointRef) {
+            self.traffic = traffic
+            self.sourceRef = sourceRef
+            random = RandomNumberGenerator(seed: traffic.seed)
+        }
+
+        let traffic: Traffic
+        let sourceRef: MIDIEndpointRef
+        private(set) var index = 0
+        private var random: RandomNumberGenerator
+
+        var isFinished: Bool {
+            index >= traffic.count || sourceRef == 0
+        }
+
+        // When the next message or burst is due, in nanoseconds after the start
+        var nextNanos: UInt64 {
+            traffic.rate > 0 ? UInt64(Double(index) * 1_000_000_000 / traffic.rate) : 0
+        }
+
+        mutating func nextBytes() -> [UInt8] {
+            defer { index += 1 }
+
+            switch traffic.pattern {
+            case .clock:
+                return [0xF8]
+
+            case .controlSweep(let channel, let controller):
+                let step = index % 254
+                return [0xB0 | (channel & 0x0F), controller & 0x7F, UInt8(step <= 127 ? step : 254 - step)]
+
+            case .sysEx(let length):
+                // Use the manufacturer ID for non-commercial use, so anything that looks at it isn't fooled
+                var bytes: [UInt8] = [0xF0, 0x7D]
+                bytes.reserveCapacity(max(length, 3))
+                while bytes.count < length - 1 {
+                    var value = random.next()
+                    for _ in 0 ..< min(8, length - 1 - bytes.count) {
+                        bytes.append(UInt8(value & 0x7F))
+                        value >>= 8
+                    }
+                }
+                bytes.append(0xF7)
+                return bytes
+
+            case .bursts(let size):
+                var bytes: [UInt8] = []
+                bytes.reserveCapacity(size * 3)
+                for _ in 0 ..< size {
+                    // Note on, or note off if the velocity is 0
+                    let value = random.next()
+                    bytes.append(0x90 | UInt8(value & 0x0F))
+                    bytes.append(UInt8((value >> 8) & 0x7F))
+                    bytes.append(UInt8((value >> 16) & 0x7F))
+                }
+                return bytes
+            }
+        }
+
+    }
+
+    private static let maxPacketLength = 1024   // longer messages, like big sysex, are split into packets this long
+
+    private func generate(_ generators: [TrafficGenerator], packetsPerRead: Int) {
+        var generators = generators
+        let startHostTime = SMGetCurrentHostTime() + SMConvertNanosToHostTime(1_000_000)
+        var pendingPackets: [MIDIEndpointRef: [Packet]] = [:]
+
+        func deliverPendingPackets() {
+            for (sourceRef, packets) in pendingPackets where !packets.isEmpty {
+                deliver(packets, fromSource: sourceRef)
+            }
+            pendingPackets = [:]
+        }
+
+        while !locked({ isStopping }) {
+            // Find the generator whose next message is due first
+            var nextGeneratorIndex: Int?
+            for index in generators.indices where !generators[index].isFinished {
+                if nextGeneratorIndex == nil || generators[index].nextNanos < generators[nextGeneratorIndex!].nextNanos {
+                    nextGeneratorIndex = index
+                }
+            }
+            guard let generatorIndex = nextGeneratorIndex else { break }
+
+            let rate = generators[generatorIndex].traffic.rate
+            let timeStamp: MIDITimeStamp
+            if rate > 0 {
+                timeStamp = startHostTime + SMConvertNanosToHostTime(generators[generatorIndex].nextNanos)
+                if timeStamp > SMGetCurrentHostTime() {
+                    // Deliver what's already due, then wait until this is due, like a real device
+                    deliverPendingPackets()
+                    mach_wait_until(timeStamp)
+                }
+            }
+            else {
+                timeStamp = SMGetCurrentHostTime()
+            }
+
+            let sourceRef = generators[generatorIndex].sourceRef
+            let bytes = generators[generatorIndex].nextBytes()
+            for start in stride(from: 0, to: bytes.count, by: Self.maxPacketLength) {
+                pendingPackets[sourceRef, default: []].append(Packet(timeStamp: timeStamp, bytes: Array(bytes[start ..< min(start + Self.maxPacketLength, bytes.count)])))
+                if pendingPackets[sourceRef]!.count >= packetsPerRead {
+                    deliver(pendingPackets[sourceRef]!, fromSource: sourceRef)
+                    pendingPackets[sourceRef] = []
+                }
+            }
+
+            locked {
+                _generatedPacketCount += (bytes.count + Self.maxPacketLength - 1) / Self.maxPacketLength
+                _generatedByteCount += bytes.count
+            }
+        }
+
+        deliverPendingPackets()
+    }
+
+    // MARK: Delivering packets
+
+    private func deliver(_ packets: [Packet], fromSource sourceRef: MIDIEndpointRef) {
+        // Give the packets to every input port that's connected to the source
+        typealias Port = (readBlock: MIDIReadBlock?, receiveBlock: MIDIReceiveBlock?, receiveProtocol: MIDIProtocolID, refCon: UnsafeMutableRawPointer?)
+        var ports: [Port] = []
+        locked {
+            for object in objects.values where object.kind == .inputPort {
+                if let refCon = object.connections[sourceRef] {
+                    ports.append((object.readBlock, object.receiveBlock, object.receiveProtocol, refCon))
+                }
+            }
+        }
+        guard !ports.isEmpty else { return }
+
+        if ports.contains(where: { $0.readBlock != nil }) {
+            Self.withPacketList(packets) { packetListPtr in
+                for port in ports {
+                    port.readBlock?(packetListPtr, port.refCon)
+                }
+            }
+        }
+
+        for port in ports {
+            if let receiveBlock = port.receiveBlock {
+                Self.withEventList(packets, port.receiveProtocol) { eventListPtr in
+                    receiveBlock(eventListPtr, port.refCon)
+                }
+            }
+        }
+    }
+
+    private func deliver(_ packets: [Packet], toDestination destinationRef: MIDIEndpointRef) {
+        // A virtual destination's read block gets the packets. With loopback, they come back from
+        // the matching source.
+        let (readBlock, loopbackSourceRef, flushGeneration): (MIDIReadBlock?, MIDIEndpointRef?, Int) = locked {
+            guard let object = objects[destinationRef] else { return (nil, nil, 0) }
+            var loopbackSourceRef: MIDIEndpointRef?
+            if _loopsBack, let index = destinationRefs.prefix(deviceDestinationCount).firstIndex(of: destinationRef), index < deviceSourceCount {
+                loopbackSourceRef = sourceRefs[index]
+            }
+            return (object.readBlock, loopbackSourceRef, object.flushGeneration)
+        }
+        guard readBlock != nil || loopbackSourceRef != nil else { return }
+
+        let now = SMGetCurrentHostTime()
+        for packet in packets {
+            // Like CoreMIDI, hold packets with future time stamps until then, unless the output is flushed first
+            let delivery = { [weak self] in
+                guard let self, self.locked({ self.objects[destinationRef]?.flushGeneration == flushGeneration }) else { return }
+                if let readBlock {
+                    Self.withPacketList([packet]) { readBlock($0, nil) }
+                }
+                if let loopbackSourceRef, let loopbackPacket = self.packetSurvivingLoopback(packet, destinationRef) {
+                    self.deliver([loopbackPacket], fromSource: loopbackSourceRef)
+                }
+            }
+
+            if packet.timeStamp > now {
+                deliveryQueue.asyncAfter(deadline: DispatchTime(uptimeNanoseconds: SMConvertHostTimeToNanos(packet.timeStamp)), execute: delivery)
+            }
+            else {
+                deliveryQueue.async(execute: delivery)
+            }
+        }
+    }
+
+    private func packetSurvivingLoopback(_ packet: Packet, _ destinationRef: MIDIEndpointRef) -> Packet? {
+        // The bytes that fit in the simulated device's buffer get through. The buffer empties at
+        // `loopbackBytesPerSecond`, starting from when the last packet arrived.
+        locked {
+            guard _loopbackBytesPerSecond > 0, let object = objects[destinationRef] else { return packet }
+
+            let now = SMGetCurrentHostTime()
+            if object.loopbackHostTime != 0 {
+                let elapsedSeconds = Double(SMConvertHostTimeToNanos(now - min(object.loopbackHostTime, now))) / 1_000_000_000
+                object.loopbackBufferedByteCount = max(object.loopbackBufferedByteCount - elapsedSeconds * Double(_loopbackBytesPerSecond), 0)
+            }
+            object.loopbackHostTime = now
+
+            let keptCount = min(packet.bytes.count, max(_loopbackBufferSize - Int(object.loopbackBufferedByteCount.rounded(.up)), 0))
+            object.loopbackBufferedByteCount += Double(keptCount)
+            _loopbackLostByteCount += packet.bytes.count - keptCount
+
+            guard keptCount > 0 else { return nil }
+            return keptCount == packet.bytes.count ? packet : Packet(timeStamp: packet.timeStamp, bytes: Array(packet.bytes.prefix(keptCount)))
+        }
+    }
+
+    private static func withPacketList(_ packets: [Packet], _ body: (UnsafePointer<MIDIPacketList>) -> Void) {
+        let headerSize = MemoryLayout.offset(of: \MIDIPacketList.packet)!
+        let packetHeaderSize = MemoryLayout.offset(of: \MIDIPacket.data)!
+        // Leave room for each packet to be aligned
+        let listSize = headerSize + packets.reduce(0) { $0 + packetHeaderSize + $1.bytes.count + 4 }
+
+        let buffer = UnsafeMutableRawPointer.allocate(byteCount: listSize, alignment: MemoryLayout<MIDIPacketList>.alignment)
+        defer { buffer.deallocate() }
+        let packetListPtr = buffer.bindMemory(to: MIDIPacketList.self, capacity: 1)
+
+        var curPacketPtr: UnsafeMutablePointer<MIDIPacket>? = MIDIPacketListInit(packetListPtr)
+        for packet in packets where !packet.bytes.isEmpty {
+            guard let packetPtr = curPacketPtr else { break }
+            curPacketPtr = packet.bytes.withUnsafeBufferPointer { bytes in
+                SMWorkaroundMIDIPacketListAdd(packetListPtr, listSize, packetPtr, packet.timeStamp, bytes.count, bytes.baseAddress!)
+            }
+        }
+        body(packetListPtr)
+    }
+
+    private static func withEventList(_ packets: [Packet], _ midiProtocol: MIDIProtocolID, _ body: (UnsafePointer<MIDIEventList>) -> Void) {
+        // Convert to MIDI 1.0 Universal MIDI Packets, and add them one at a time, so CoreMIDI puts together the
+        // ones with the same time stamp.
+        // (CoreMIDI would convert voice messages to MIDI 2.0 for a MIDI 2.0 port, but MIDI 1.0 packets are
+        // also valid there, and they are what the parser's converter has to handle from MIDI 1.0 devices.)
+        let wordLists = packets.map { universalMIDIPacketWords($0.bytes) }
+        let packetHeaderSize = MemoryLayout.offset(of: \MIDIEventPacket.words)!
+        // Enough for every UMP to be in its own event packet
+        let listSize = MemoryLayout<MIDIEventList>.size + wordLists.reduce(0) { $0 + $1.count * (packetHeaderSize + 4) }
+
+        let buffer = UnsafeMutableRawPointer.allocate(byteCount: listSize, alignment: MemoryLayout<MIDIEventList>.alignment)
+        defer { buffer.deallocate() }
+        let eventListPtr = buffer.bindMemory(to: MIDIEventList.self, capacity: 1)
+
+        var curPacketPtr: UnsafeMutablePointer<MIDIEventPacket>? = MIDIEventListInit(eventListPtr, midiProtocol)
+        for (packet, words) in zip(packets, wordLists) where !words.isEmpty {
+            words.withUnsafeBufferPointer { words in
+                var index = 0
+                while index < words.count, let packetPtr = curPacketPtr {
+                    // Sysex UMPs (type 3) are two words, the others one
+                    let wordCount = words[index] >> 28 == 3 ? 2 : 1
+                    curPacketPtr = MIDIEventListAdd(eventListPtr, listSize, packetPtr, packet.timeStamp, wordCount, words.baseAddress! + index)
+                    index += wordCount
+                }
+            }
+        }
+        body(eventListPtr)
+    }
+
+    private static func universalMIDIPacketWords(_ bytes: [UInt8]) -> [UInt32] {
+        // The bytes are complete messages, without running status, except that a long sysex message may be
+        // split between packets. Only the first part has F0, and only the last part has F7.
+        var words: [UInt32] = []
+        var index = 0
+        while index < bytes.count {
+            let status = bytes[index]
+            if status == 0xF0 || status < 0x80 {
+                // Sysex: 6 data bytes per packet, with a status saying which part of the message it is
+                let start = status == 0xF0 ? index + 1 : index
+                var end = bytes[start...].firstIndex { $0 >= 0x80 } ?? bytes.count
+                let isStart = status == 0xF0
+                let isEnd = end < bytes.count && bytes[end] == 0xF7
+                for chunkStart in stride(from: start, to: max(end, start + 1), by: 6) {
+                    let chunk = bytes[chunkStart ..< min(chunkStart + 6, end)]
+                    let isFirstChunk = chunkStart == start
+                    let isLastChunk = chunkStart + 6 >= end
+                    let chunkStatus: UInt32
+                    switch (isStart && isFirstChunk, isEnd && isLastChunk) {
+                    case (true, true):  chunkStatus = 0
+                    case (true, false): chunkStatus = 1
+                    case (false, true): chunkStatus = 3
+                    default:            chunkStatus = 2
+                    }
+                    var chunkBytes = [UInt8](repeating: 0, count: 6)
+                    chunkBytes.replaceSubrange(0 ..< chunk.count, with: chunk)
+                    words.append(0x3000_0000 | chunkStatus << 20 | UInt32(chunk.count) << 16 | UInt32(chunkBytes[0]) << 8 | UInt32(chunkBytes[1]))
+                    words.append(UInt32(chunkBytes[2]) << 24 | UInt32(chunkBytes[3]) << 16 | UInt32(chunkBytes[4]) << 8 | UInt32(chunkBytes[5]))
+                }
+                if isEnd {
+                    end += 1
+                }
+                index = end
+            }
+            else {
+                let dataCount: Int
+                switch status {
+                case 0xC0 ..< 0xE0, 0xF1, 0xF3:
+                    dataCount = 1
+                case 0x80 ..< 0xF0, 0xF2:
+                    dataCount = 2
+                default:
+                    dataCount = 0
+                }
+                let data1 = dataCount > 0 && index + 1 < bytes.count ? UInt32(bytes[index + 1]) : 0
+                let data2 = dataCount > 1 && index + 2 < bytes.count ? UInt32(bytes[index + 2]) : 0
+                let messageType: UInt32 = status < 0xF0 ? 0x2000_0000 : 0x1000_0000
+                words.append(messageType | UInt32(status) << 16 | data1 << 8 | data2)
+                index += 1 + dataCount
+            }
+        }
+        return words
+    }
+
+    private static func packets(_ packetListPtr: UnsafePointer<MIDIPacketList>) -> [Packet] {
+        packetListPtr.unsafeSequence().map { packetPtr in
+            let length = Int(packetPtr.pointee.length)
+            let dataPtr = UnsafeRawPointer(packetPtr) + MemoryLayout.offset(of: \MIDIPacket.data)!
+            return Packet(timeStamp: packetPtr.pointee.timeStamp, bytes: Array(UnsafeRawBufferPointer(start: dataPtr, count: length)))
+        }
+    }
+
+    private func record(_ kind: SentPacket.Kind, _ endpointRef: MIDIEndpointRef, _ packets: [Packet]) {
+        var uniqueID: MIDIUniqueID = 0
+        if case .integer(let value) = property(endpointRef, kMIDIPropertyUniqueID) {
+            uniqueID = value
+        }
+        let hostTime = SMGetCurrentHostTime()
+        locked {
+            for packet in packets {
+                _sentByteCount += packet.bytes.count
+                if _recordsSentPackets {
+                    _sentPackets.append(SentPacket(kind: kind, endpointUniqueID: uniqueID, timeStamp: packet.timeStamp, hostTime: hostTime, data: Data(packet.bytes)))
+                }
+            }
+        }
+    }
+
+}
+
+extension SyntheticMIDIInterface: CoreMIDIInterface {
+
+    func clientCreateWithBlock(_ name: CFString, _ outClient: UnsafeMutablePointer<MIDIClientRef>, _ notifyBlock: MIDINotifyBlock?) -> OSStatus {
+        // The device never changes, so there is nothing to notify about
+        outClient.pointee = clientRef
+        return noErr
+    }
+
+    func clientDispose(_ client: MIDIClientRef) -> OSStatus {
+        noErr
+    }
+
+    func objectGetStringProperty(_ obj: MIDIObjectRef, _ propertyID: CFString, _ str: UnsafeMutablePointer<Unmanaged<CFString>?>) -> OSStatus {
+        // The object keeps the string alive, so it can be returned unretained
+        guard case .string(let string) = property(obj, propertyID) else { return OSStatus(kMIDIUnknownProperty) }
+        str.pointee = Unmanaged.passUnretained(string)
+        return noErr
+    }
+
+    func objectSetStringProperty(_ obj: MIDIObjectRef, _ propertyID: CFString, _ str: CFString) -> OSStatus {
+        setProperty(obj, propertyID, .string(str))
+    }
+
+    func objectGetIntegerProperty(_ obj: MIDIObjectRef, _ propertyID: CFString, _ outValue: UnsafeMutablePointer<Int32>) -> OSStatus {
+        guard case .integer(let value) = property(obj, propertyID) else { return OSStatus(kMIDIUnknownProperty) }
+        outValue.pointee = value
+        return noErr
+    }
+
+    func objectSetIntegerProperty(_ obj: MIDIObjectRef, _ propertyID: CFString, _ value: Int32) -> OSStatus {
+        setProperty(obj, propertyID, .integer(value))
+    }
+
+    func objectGetDataProperty(_ obj: MIDIObjectRef, _ propertyID: CFString, _ outData: UnsafeMutablePointer<Unmanaged<CFData>?>) -> OSStatus {
+        guard case .data(let data) = property(obj, propertyID) else { return OSStatus(kMIDIUnknownProperty) }
+        outData.pointee = Unmanaged.passUnretained(data)
+        return noErr
+    }
+
+    func objectSetDataProperty(_ obj: MIDIObjectRef, _ propertyID: CFString, _ data: CFData) -> OSStatus {
+        setProperty(obj, propertyID, .data(data))
+    }
+
+    func objectRemoveProperty(_ obj: MIDIObjectRef, _ propertyID: CFString) -> OSStatus {
+        locked {
+            guard let object = objects[obj] else { return OSStatus(kMIDIObjectNotFound) }
+            object.properties[propertyID as String] = nil
+            return noErr
+        }
+    }
+
+    func getNumberOfDevices() -> Int {
+        1
+    }
+
+    func getDevice(_ deviceIndex0: Int) -> MIDIDeviceRef {
+        deviceIndex0 == 0 ? deviceRef : 0
+    }
+
+    func getNumberOfExternalDevices() -> Int {
+        0
+    }
+
+    func getExternalDevice(_ deviceIndex0: Int) -> MIDIDeviceRef {
+        0
+    }
+
+    func getNumberOfSources() -> Int {
+        locked { sourceRefs.count }
+    }
+
+    func getSource(_ sourceIndex0: Int) -> MIDIEndpointRef {
+        locked { sourceRefs.indices.contains(sourceIndex0) ? sourceRefs[sourceIndex0] : 0 }
+    }
+
+    func getNumberOfDestinations() -> Int {
+        locked { destinationRefs.count }
+    }
+
+    func getDestination(_ destIndex0: Int) -> MIDIEndpointRef {
+        locked { destinationRefs.indices.contains(destIndex0) ? destinationRefs[destIndex0] : 0 }
+    }
+
+    func deviceGetNumberOfEntities(_ device: MIDIDeviceRef) -> Int {
+        device == deviceRef ? 1 : 0
+    }
+
+    func deviceGetEntity(_ device: MIDIDeviceRef, _ entityIndex0: Int) -> MIDIEntityRef {
+        device == deviceRef && entityIndex0 == 0 ? entityRef : 0
+    }
+
+    func entityGetNumberOfSources(_ entity: MIDIEntityRef) -> Int {
+        entity == entityRef ? deviceSourceCount : 0
+    }
+
+    func entityGetSource(_ entity: MIDIEntityRef, _ sourceIndex0: Int) -> MIDIEndpointRef {
+        entity == entityRef && (0 ..< deviceSourceCount).contains(sourceIndex0) ? locked { sourceRefs[sourceIndex0] } : 0
+    }
+
+    func entityGetNumberOfDestinations(_ entity: MIDIEntityRef) -> Int {
+        entity == entityRef ? deviceDestinationCount : 0
+    }
+
+    func entityGetDestination(_ entity: MIDIEntityRef, _ destIndex0: Int) -> MIDIEndpointRef {
+        entity == entityRef && (0 ..< deviceDestinationCount).contains(destIndex0) ? locked { destinationRefs[destIndex0] } : 0
+    }
+
+    func objectFindByUniqueID(_ inUniqueID: MIDIUniqueID, _ outObject: UnsafeMutablePointer<MIDIObjectRef>?, _ outObjectType: UnsafeMutablePointer<MIDIObjectType>?) -> OSStatus {
+        locked {
+            let match = objects.first { objectRef, object in
+                guard case .integer(let uniqueID) = object.properties[kMIDIPropertyUniqueID as String] else { return false }
+                return uniqueID == inUniqueID
+            }
+            guard let (objectRef, object) = match else { return OSStatus(kMIDIObjectNotFound) }
+
+            outObject?.pointee = objectRef
+            switch object.kind {
+            case .device:
+                outObjectType?.pointee = .device
+            case .entity:
+                outObjectType?.pointee = .entity
+            case .source:
+                outObjectType?.pointee = .source
+            case .destination:
+                outObjectType?.pointee = .destination
+            default:
+                outObjectType?.pointee = .other
+            }
+            return noErr
+        }
+    }
+
+    func sourceCreate(_ client: MIDIClientRef, _ name: CFString, _ outSrc: UnsafeMutablePointer<MIDIEndpointRef>) -> OSStatus {
+        outSrc.pointee = locked {
+            let sourceRef = addObject(kind: .source, parent: 0, name: name as String)
+            sourceRefs.append(sourceRef)
+            return sourceRef
+        }
+        return noErr
+    }
+
+    func destinationCreateWithBlock(_ client: MIDIClientRef, _ name: CFString, _ outDest: UnsafeMutablePointer<MIDIEndpointRef>, _ readBlock: @escaping MIDIReadBlock) -> OSStatus {
+        outDest.pointee = locked {
+            let destinationRef = addObject(kind: .destination, parent: 0, name: name as String)
+            objects[destinationRef]!.readBlock = readBlock
+            destinationRefs.append(destinationRef)
+            return destinationRef
+        }
+        return noErr
+    }
+
+    func endpointGetEntity(_ inEndpoint: MIDIEndpointRef, _ outEntity: UnsafeMutablePointer<MIDIEntityRef>?) -> OSStatus {
+        // Virtual endpoints have no entity
+        guard let parent = locked({ objects[inEndpoint]?.parent }), parent != 0 else { return OSStatus(kMIDIObjectNotFound) }
+        outEntity?.pointee = parent
+        return noErr
+    }
+
+    func entityGetDevice(_ inEntity: MIDIEntityRef, _ outDevice: UnsafeMutablePointer<MIDIDeviceRef>?) -> OSStatus {
+        guard inEntity == entityRef else { return OSStatus(kMIDIObjectNotFound) }
+        outDevice?.pointee = deviceRef
+        return noErr
+    }
+
+    func endpointDispose(_ endpt: MIDIEndpointRef) -> OSStatus {
+        locked {
+            // Only virtual endpoints can be disposed
+            guard let object = objects[endpt], object.parent == 0, object.kind == .source || object.kind == .destination else { return OSStatus(kMIDIObjectNotFound) }
+            removeEndpoint(endpt)
+            return noErr
+        }
+    }
+
+    func send(_ port: MIDIPortRef, _ dest: MIDIEndpointRef, _ pktlist: UnsafePointer<MIDIPacketList>) -> OSStatus {
+        let packets = Self.packets(pktlist)
+        record(.send, dest, packets)
+        deliver(packets, toDestination: dest)
+        return noErr
+    }
+
+    func sendSysex(_ request: UnsafeMutablePointer<MIDISysexSendRequest>) -> OSStatus {
+        // Like CoreMIDI, send the data in small pieces, at the speed of a MIDI cable, on another thread,
+        // updating the request as it goes. Stop early if the request is marked complete.
+        let destinationRef = request.pointee.destination
+        let allBytes = Array(UnsafeBufferPointer(start: request.pointee.data, count: Int(request.pointee.bytesToSend)))
+        record(.sysEx, destinationRef, [Packet(timeStamp: 0, bytes: allBytes)])
+
+        // Like CoreMIDI, use the speed set on the endpoint, if there is one
+        var bytesPerSecond = sysExBytesPerSecond
+        if case .integer(let speed) = property(destinationRef, kMIDIPropertyMaxSysExSpeed), speed > 0 {
+            bytesPerSecond = Int(speed)
+        }
+
+        sysExQueue.async { [weak self] in
+            let chunkSize = 256
+            var nextHostTime = SMGetCurrentHostTime()
+            while !request.pointee.complete.boolValue && request.pointee.bytesToSend > 0 {
+                let count = min(Int(request.pointee.bytesToSend), chunkSize)
+                let chunk = Array(UnsafeBufferPointer(start: request.pointee.data, count: count))
+                self?.deliver([Packet(timeStamp: 0, bytes: chunk)], toDestination: destinationRef)
+                request.pointee.data += count
+                request.pointee.bytesToSend -= UInt32(count)
+
+                if bytesPerSecond > 0 {
+                    nextHostTime += SMConvertNanosToHostTime(UInt64(count) * 1_000_000_000 / UInt64(bytesPerSecond))
+                    mach_wait_until(nextHostTime)
+                }
+            }
+
+            request.pointee.complete = true
+            request.pointee.completionProc(request)
+        }
+        return noErr
+    }
+
+    func received(_ src: MIDIEndpointRef, _ pktlist: UnsafePointer<MIDIPacketList>) -> OSStatus {
+        let packets = Self.packets(pktlist)
+        record(.received, src, packets)
+        deliver(packets, fromSource: src)
+        return noErr
+    }
+
+    func flushOutput(_ dest: MIDIEndpointRef) -> OSStatus {
+        // Cancel packets that are waiting for their time stamps. Flushing everything is also allowed.
+        locked {
+            _flushCount += 1
+            if dest == 0 {
+                for object in objects.values where object.kind == .destination {
+                    object.flushGeneration += 1
+                }
+            }
+            else {
+                objects[dest]?.flushGeneration += 1
+            }
+        }
+        return noErr
+    }
+
+    func inputPortCreateWithBlock(_ client: MIDIClientRef, _ portName: CFString, _ outPort: UnsafeMutablePointer<MIDIPortRef>, _ readBlock: @escaping MIDIReadBlock) -> OSStatus {
+        outPort.pointee = locked {
+            let portRef = addObject(kind: .inputPort, parent: client)
+            objects[portRef]!.readBlock = readBlock
+            return portRef
+        }
+        return noErr
+    }
+
+    func inputPortCreateWithProtocol(_ client: MIDIClientRef, _ portName: CFString, _ protocol: MIDIProtocolID, _ outPort: UnsafeMutablePointer<MIDIPortRef>, _ receiveBlock: @escaping MIDIReceiveBlock) -> OSStatus {
+        outPort.pointee = locked {
+            let portRef = addObject(kind: .inputPort, parent: client)
+            objects[portRef]!.receiveBlock = receiveBlock
+            objects[portRef]!.receiveProtocol = `protocol`
+            return portRef
+        }
+        return noErr
+    }
+
+    func outputPortCreate(_ client: MIDIClientRef, _ portName: CFString, _ outPort: UnsafeMutablePointer<MIDIPortRef>) -> OSStatus {
+        outPort.pointee = locked { addObject(kind: .outputPort, parent: client) }
+        return noErr
+    }
+
+    func portConnectSource(_ port: MIDIPortRef, _ source: MIDIEndpointRef, _ connRefCon: UnsafeMutableRawPointer?) -> OSStatus {
+        locked {
+            guard let object = objects[port], object.kind == .inputPort, objects[source]?.kind == .source else { return OSStatus(kMIDIObjectNotFound) }
+            object.connections[source] = .some(connRefCon)
+            return noErr
+        }
+    }
+
+    func portDisconnectSource(_ port: MIDIPortRef, _ source: MIDIEndpointRef) -> OSStatus {
+        locked {
+            guard let object = objects[port], object.connections[source] != nil else { return OSStatus(kMIDINoConnection) }
+            object.connections[source] = nil
+            return noErr
+        }
+    }
+
+    func portDispose(_ port: MIDIPortRef) -> OSStatus {
+        locked {
+            guard objects[port] != nil else { return OSStatus(kMIDIObjectNotFound) }
+            objects[port] = nil
+            return noErr
+        }
+    }
+
+}
@@ -0,0 +1,226 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+import CoreMIDI
+
+public struct SysExSendTimingStatistics {
+
+    // How well a sysex message was sent at its intended speed
+
+    public internal(set) var byteCount = 0
+    public internal(set) var bufferCount = 0
+    public internal(set) var lateBufferCount = 0        // buffers sent after the time they should have started
+
+    // How late the scheduler woke up to send buffers, compared to when it intended to
+    public internal(set) var wakeCount = 0
+    public internal(set) var meanWakeLatenessNanos: Double = 0
+    public internal(set) var maxWakeLatenessNanos: UInt64 = 0
+    public var wakeLatenessStandardDeviationNanos: Double {
+        wakeCount > 1 ? (wakeLatenessVariance / Double(wakeCount - 1)).squareRoot() : 0
+    }
+
+    public internal(set) var intendedBytesPerSecond: Double = 0
+    // From when the first buffer was sent until the last buffer finished
+    public internal(set) var actualBytesPerSecond: Double = 0
+
+    mutating func noteWake(latenessNanos: UInt64) {
+        // Welford's method, so the statistics can be kept without keeping every value
+        wakeCount += 1
+        let lateness = Double(latenessNanos)
+        let delta = lateness - meanWakeLatenessNanos
+        meanWakeLatenessNanos += delta / Double(wakeCount)
+        wakeLatenessVariance += delta * (lateness - meanWakeLatenessNanos)
+        maxWakeLatenessNanos = max(maxWakeLatenessNanos, latenessNanos)
+    }
+
+    private var wakeLatenessVariance: Double = 0
+
+}
+
+final class SysExScheduler {
+
+    // Sends sysex in buffers of a given size, at a given speed, for SysExSendRequests that use a custom buffer size.
+    //
+    // Every buffer's time is computed from when the message started, instead of waiting a fixed delay
+    // after the previous buffer, so lateness in waking up doesn't accumulate and slow the message down.
+    // Buffers are given to CoreMIDI a little ahead of their time, with that time as their timestamp,
+    // so CoreMIDI (or the driver) can send them on time even if we wake up late.
+    //
+    // There's one scheduler per MIDIContext. It uses one output port and one queue for all messages.
+
+    init(midiContext: CoreMIDIContext) {
+        self.midiContext = midiContext
+    }
+
+    // Like MIDISendSysex, but specify a size for each buffer to send, and the speed to send at.
+    // `finished` is called on the scheduler's queue when the last buffer has been sent (or the request
+    // was cancelled), with the time when the last buffer's bytes will have been transmitted, in nanoseconds.
+    // Then the request's completionProc is called.
+    func send(_ request: UnsafeMutablePointer<MIDISysexSendRequest>, bufferSize: Int, bytesPerSecond: Int, finished: @escaping (SysExSendTimingStatistics, UInt64) -> Void) -> OSStatus {
+        guard bufferSize >= 3 && bufferSize <= 32767, bytesPerSecond > 0 else { return OSStatus(-50 /* paramErr */) }
+
+        if request.pointee.bytesToSend == 0 {
+            request.pointee.complete = true
+        }
+
+        if request.pointee.complete.boolValue {
+            request.pointee.completionProc(request)
+            return OSStatus(noErr)
+        }
+
+        let status = createPortIfNecessary()
+        if status != noErr {
+            return status
+        }
+
+        let job = Job(request: request, bufferSize: bufferSize, bytesPerSecond: bytesPerSecond, finished: finished)
+        queue.async {
+            job.firstStartNanos = Self.currentNanos()
+            job.startNanos = job.firstStartNanos
+            job.statistics.intendedBytesPerSecond = Double(bytesPerSecond)
+            // Use the same time as the schedule's start, or the first buffer would always look late
+            self.sendDueBuffers(job, intendedWakeNanos: job.startNanos, nowNanos: job.startNanos)
+        }
+
+        return OSStatus(noErr)
+    }
+
+    // MARK: Private
+
+    private weak var midiContext: CoreMIDIContext?
+    private var port: MIDIPortRef = 0
+
+    private let queue = DispatchQueue(label: "com.snoize.SnoizeMIDI.SysExScheduler", qos: .userInteractive)
+
+    // How far ahead of their time buffers are given to CoreMIDI
+    private static let lookaheadNanos: UInt64 = 20_000_000
+
+    private final class Job {
+        init(request: UnsafeMutablePointer<MIDISysexSendRequest>, bufferSize: Int, bytesPerSecond: Int, finished: @escaping (SysExSendTimingStatistics, UInt64) -> Void) {
+            self.request = request
+            self.bufferSize = bufferSize
+            self.bytesPerSecond = bytesPerSecond
+            self.totalByteCount = Int(request.pointee.bytesToSend)
+            self.finished = finished
+            self.packetListSize = MemoryLayout.offset(of: \MIDIPacketList.packet.data)! + bufferSize
+            self.packetListData = Data(count: packetListSize)
+        }
+
+        let request: UnsafeMutablePointer<MIDISysexSendRequest>
+        let bufferSize: Int
+        let bytesPerSecond: Int
+        let totalByteCount: Int
+        let finished: (SysExSendTimingStatistics, UInt64) -> Void
+
+        let packetListSize: Int
+        var packetListData: Data
+
+        var firstStartNanos: UInt64 = 0
+        var startNanos: UInt64 = 0  // moves later if a buffer is late
+        var statistics = SysExSendTimingStatistics()
+
+        var sentByteCount: Int {
+            totalByteCount - Int(request.pointee.bytesToSend)
+        }
+
+        // When the byte at this offset should start being transmitted
+        func deadlineNanos(byteOffset: Int) -> UInt64 {
+            startNanos + UInt64(byteOffset) * 1_000_000_000 / UInt64(bytesPerSecond)
+        }
+    }
+
+    private static func currentNanos() -> UInt64 {
+        SMConvertHostTimeToNanos(SMGetCurrentHostTime())
+    }
+
+    private func createPortIfNecessary() -> OSStatus {
+        dispatchPrecondition(condition: .onQueue(DispatchQueue.main))
+
+        guard port == 0 else { return OSStatus(noErr) }
+        guard let midiContext else { return OSStatus(-50 /* paramErr */) }
+        return midiContext.interface.outputPortCreate(midiContext.client, "SysExScheduler" as CFString, &port)
+    }
+
+    private func sendDueBuffers(_ job: Job, intendedWakeNanos: UInt64, nowNanos knownNowNanos: UInt64? = nil) {
+        guard let midiContext else { return }
+
+        let request = job.request
+        var nowNanos = knownNowNanos ?? Self.currentNanos()
+        job.statistics.noteWake(latenessNanos: nowNanos > intendedWakeNanos ? nowNanos - intendedWakeNanos : 0)
+
+        if request.pointee.complete.boolValue {
+            // Cancelled. Don't let buffers that were already given to CoreMIDI go out.
+            _ = midiContext.interface.flushOutput(request.pointee.destination)
+            finish(job, finishNanos: nowNanos)
+            return
+        }
+
+        while request.pointee.bytesToSend > 0 {
+            var deadlineNanos = job.deadlineNanos(byteOffset: job.sentByteCount)
+            guard deadlineNanos <= nowNanos + Self.lookaheadNanos else { break }
+
+            if deadlineNanos < nowNanos {
+                // We woke up too late to hand this buffer over in time. Send it now, and move the rest
+                // of the schedule later by the same amount, so the following buffers aren't sent
+                // in a burst to catch up, which could overflow the receiving device's buffer.
+                job.statistics.lateBufferCount += 1
+                job.startNanos += nowNanos - deadlineNanos
+                deadlineNanos = nowNanos
+            }
+
+            let packetDataSize = min(Int(request.pointee.bytesToSend), job.bufferSize)
+            let timeStamp = SMConvertNanosToHostTime(deadlineNanos)
+            let packetListSize = job.packetListSize
+            job.packetListData.withUnsafeMutableBytes { (packetListRawBufferPtr: UnsafeMutableRawBufferPointer) in
+                let packetListPtr = packetListRawBufferPtr.bindMemory(to: MIDIPacketList.self).baseAddress!
+
+                let curPacket = MIDIPacketListInit(packetListPtr)
+                _ = MIDIPacketListAdd(packetListPtr, packetListSize, curPacket, timeStamp, packetDataSize, request.pointee.data)
+
+                _ = midiContext.interface.send(port, request.pointee.destination, packetListPtr)
+            }
+
+            request.pointee.data += packetDataSize
+            request.pointee.bytesToSend -= UInt32(packetDataSize)
+            job.statistics.bufferCount += 1
+            job.statistics.byteCount += packetDataSize
+
+            nowNanos = Self.currentNanos()
+        }
+
+        // Wake up when the next buffer is due to be handed over, or when the last one has been transmitted
+        let nextWakeNanos: UInt64
+        if request.pointee.bytesToSend > 0 {
+            nextWakeNanos = job.deadlineNanos(byteOffset: job.sentByteCount) - Self.lookaheadNanos
+        }
+        else {
+            nextWakeNanos = job.deadlineNanos(byteOffset: job.totalByteCount)
+        }
+
+        if request.pointee.bytesToSend == 0 && nextWakeNanos <= nowNanos {
+            finish(job, finishNanos: nextWakeNanos)
+        }
+        else {
+            queue.asyncAfter(deadline: DispatchTime(uptimeNanoseconds: nextWakeNanos)) {
+                self.sendDueBuffers(job, intendedWakeNanos: nextWakeNanos)
+            }
+        }
+    }
+
+    private func finish(_ job: Job, finishNanos: UInt64) {
+        if finishNanos > job.firstStartNanos {
+            job.statistics.actualBytesPerSecond = Double(job.statistics.byteCount) * 1_000_000_000 / Double(finishNanos - job.firstStartNanos)
+        }
+
+        job.finished(job.statistics, finishNanos)
+
+        job.request.pointee.complete = true
+        job.request.pointee.completionProc(job.request)
+    }
+
+}
@@ -14,17 +14,17 @@ public class SysExSendRequest: NSObject {
         self.message = message
         self.customSysExBufferSize = customSysExBufferSize
 
-        let fullMessageData = message.fullData
         // MIDISysexSendRequest length is "only" a UInt32
-        guard fullMessageData.count < UInt32.max else { return nil }
+        guard message.fullMessageDataLength < UInt32.max else { return nil }
 
         // Swift.Data doesn't provide a way to get a long-lived pointer
         // into its bytes. We need to copy the data to a separate buffer,
         // then make the MIDISysexSendRequest take bytes from there.
-        dataCount = fullMessageData.count
-        let mutableBufferPtr = UnsafeMutableBufferPointer<UInt8>.allocate(capacity: dataCount)
-        _ = mutableBufferPtr.initialize(from: fullMessageData)
-        dataPointer = UnsafePointer(mutableBufferPtr.baseAddress!)
+        // Copy the 0xF0, data, and 0xF7 straight into that buffer, without making a combined copy first.
+        dataCount = message.fullMessageDataLength
+        let mutableBufferPtr = UnsafeMutableRawBufferPointer.allocate(byteCount: dataCount, alignment: 1)
+        message.copyFullMessageBytes(to: mutableBufferPtr)
+        dataPointer = UnsafePointer(mutableBufferPtr.baseAddress!.assumingMemoryBound(to: UInt8.self))
 
         maxSysExSpeed = Int(destination.maxSysExSpeed)
 
@@ -81,16 +81,22 @@ public class SysExSendRequest: NSObject {
             // To avoid this issue, round the buffer size down to be a multiple of 3.
             let actualSysExBufferSize = customSysExBufferSize / 3 * 3
 
-            // Calculate a delay between buffers to get the expected speed:
+            // The scheduler spaces out the buffers to get the expected speed:
             // maxSysExSpeed is in bytes/second (default 3125)
             // Transmitting B bytes, at speed S, takes a duration of (B/S) sec or (B * 1000 / S) milliseconds.
             //
             // Note that MIDI-OX default settings use 256 byte buffers, with 60 ms between buffers,
             // leading to a speed of 1804 bytes/sec, or 57% of normal speed.
             let realMaxSysExSpeed = (maxSysExSpeed > 0) ? maxSysExSpeed : 3125
-            let perBufferDelay = Double(actualSysExBufferSize) / Double(realMaxSysExSpeed)  // seconds
 
-            result = customMIDISendSysex(midiContext, &sysexSendRequest, actualSysExBufferSize, perBufferDelay)
+            // The scheduler calls `finished` on its queue, just before the completion proc,
+            // so these values get set on the main queue before didComplete() happens.
+            result = midiContext.sysExScheduler.send(&sysexSendRequest, bufferSize: actualSysExBufferSize, bytesPerSecond: realMaxSysExSpeed) { statistics, finishNanos in
+                DispatchQueue.main.async {
+                    self.timingStatistics = statistics
+                    self.finishHostTime = SMConvertNanosToHostTime(finishNanos)
+                }
+            }
         }
         else {
             // Use CoreMIDI's sender
@@ -147,6 +153,15 @@ public class SysExSendRequest: NSObject {
         return bytesRemaining == 0
     }
 
+    // For requests with a custom buffer size, how closely the message was sent at the intended speed.
+    // Set when the request finishes.
+    public private(set) var timingStatistics: SysExSendTimingStatistics?
+
+    // When the last byte of the message will have been transmitted, as a host time. Set when the request finishes.
+    // With a custom buffer size, this may be a little later than when the request finished, since buffers
+    // are given to CoreMIDI ahead of time.
+    public private(set) var finishHostTime: MIDITimeStamp = 0
+
     // MARK: Private
 
     private let midiContext: CoreMIDIContext
@@ -171,6 +186,9 @@ public class SysExSendRequest: NSObject {
         // so ensure it's idempotent and only valid state transitions are possible.
         guard state == .sending, newState == .sent || newState == .cancelled else { return }
         state = newState
+        if finishHostTime == 0 || newState == .cancelled {
+            finishHostTime = SMGetCurrentHostTime()
+        }
         delegate?.sysExSendRequestDidFinish(self)
     }
 
@@ -185,63 +203,3 @@ public protocol SysExSendRequestDelegate: NSObjectProtocol {
     func sysExSendRequestDidFinish(_ sysExSendRequest: SysExSendRequest)
 
 }
-
-// Like MIDISendSysex, but specify a size for each buffer to send, and a delay in seconds between sending each buffer.
-private func customMIDISendSysex(_ midiContext: CoreMIDIContext, _ request: UnsafeMutablePointer<MIDISysexSendRequest>, _ bufferSize: Int, _ perBufferDelay: Double) -> OSStatus {
-    guard bufferSize >= 3 && bufferSize <= 32767 else { return OSStatus(-50 /* paramErr */) }
-
-    if request.pointee.bytesToSend == 0 {
-        request.pointee.complete = true
-    }
-
-    if request.pointee.complete.boolValue {
-        request.pointee.completionProc(request)
-        return OSStatus(noErr)
-    }
-
-    var port = MIDIPortRef()
-    let status = midiContext.interface.outputPortCreate(midiContext.client, "CustomMIDISendSysex" as CFString, &port)
-    if status != noErr {
-        return status
-    }
-
-    let packetListSize = MemoryLayout.offset(of: \MIDIPacketList.packet.data)! + bufferSize
-    var packetListData = Data(count: packetListSize)
-
-    let queue = DispatchQueue(label: "com.snoize.SnoizeMIDI.CustomMIDISendSysex", qos: .userInitiated)
-
-    func sendNextBuffer(port: MIDIPortRef) {
-        let packetDataSize = min(Int(request.pointee.bytesToSend), bufferSize)
-
-        packetListData.withUnsafeMutableBytes { (packetListRawBufferPtr: UnsafeMutableRawBufferPointer) in
-            let packetListPtr = packetListRawBufferPtr.bindMemory(to: MIDIPacketList.self).baseAddress!
-
-            let curPacket = MIDIPacketListInit(packetListPtr)
-            _ = MIDIPacketListAdd(packetListPtr, packetListSize, curPacket, 0, packetDataSize, request.pointee.data)
-
-            _ = midiContext.interface.send(port, request.pointee.destination, packetListPtr)
-        }
-
-        request.pointee.data += packetDataSize
-        request.pointee.bytesToSend -= UInt32(packetDataSize)
-        if request.pointee.bytesToSend == 0 {
-            request.pointee.complete = true
-        }
-
-        if !request.pointee.complete.boolValue {
-            queue.asyncAfter(deadline: .now() + perBufferDelay) {
-                sendNextBuffer(port: port)
-            }
-        }
-        else {
-            request.pointee.completionProc(request)
-            _ = midiContext.interface.portDispose(port)
-        }
-    }
-
-    queue.async {
-        sendNextBuffer(port: port)
-    }
-
-    return OSStatus(noErr)
-}
@@ -0,0 +1,313 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public class SysExSpeedCalibrator: NSObject {
+
+    // Finds the fastest speed, and the best custom buffer size, at which sysex can be sent reliably to a destination.
+    //
+    // This needs a loopback: whatever is sent to the destination must come back in through the source.
+    // That could be a cable from the device's MIDI out back to an input, a device that echoes
+    // what it receives, or (for testing) a virtual destination whose messages come back in through a virtual source.
+    //
+    // For each buffer size, test messages are sent at increasing speeds, until a message doesn't come back
+    // exactly as it was sent. A speed only counts as reliable after `trialsPerSpeed` messages in a row
+    // come back intact, since a device that's barely keeping up may get lucky once. When a failure shows
+    // where the limit is, the result steps back `safetyMargin` speeds from the fastest reliable one.
+    // Buffer sizes after the first only need to be tried at speeds faster than the best result so far.
+
+    public init(destination: Destination, source: Source) {
+        self.midiContext = destination.midiContext
+        self.destination = destination
+        self.source = source
+        super.init()
+    }
+
+    // Speeds to try, in bytes per second, slowest first
+    public var speeds = [250, 500, 1000, 1500, 2000, 2500, 2750, 3000, 3125]
+
+    // Custom buffer sizes to try, in order of preference. 0 means to let CoreMIDI send the sysex.
+    public var bufferSizes = [0, 256, 128, 64, 32, 16, 8, 4]
+
+    // How many test messages in a row must come back intact before a speed counts as reliable
+    public var trialsPerSpeed = 3
+
+    // How many speeds to step back from the fastest reliable one, when a faster one failed
+    public var safetyMargin = 1
+
+    // How long each test message takes to send, at the speed it's sent at
+    public var trialDuration: TimeInterval = 1.0
+
+    // How long to wait for a test message to come back, after it has been sent
+    public var echoTimeOut: TimeInterval = 0.5
+
+    public struct Trial {
+        public let bytesPerSecond: Int
+        public let bufferSize: Int
+        public let byteCount: Int
+        public let succeeded: Bool
+    }
+
+    public struct Result {
+        // nil if no speed worked
+        public let bytesPerSecond: Int?
+        public let bufferSize: Int
+        public let trials: [Trial]
+    }
+
+    // Called on the main queue after each trial
+    public var trialHandler: ((Trial) -> Void)?
+
+    // Must be called on the main queue. `completion` is called on the main queue, unless cancelled.
+    // The speeds of the destination and its external devices are changed while calibrating,
+    // and put back when finished. It's up to the caller to use the result.
+    public func start(completion: @escaping (Result) -> Void) {
+        guard self.completion == nil else { return }
+        self.completion = completion
+
+        originalSpeeds = ([destination] + destination.connectedExternalDevices).map { ($0, $0.maxSysExSpeed) }
+
+        let inputStream = PortInputStream(midiContext: midiContext)
+        inputStream.sysExTimeOut = echoTimeOut
+        inputStream.messageDestination = self
+        inputStream.addSource(source)
+        self.inputStream = inputStream
+
+        trials = []
+        bestSpeedIndex = nil
+        bestBufferSize = 0
+        bufferSizeIndex = 0
+        speedIndex = 0
+        reliableSpeedIndex = nil
+        consecutiveSuccesses = 0
+        startTrial()
+    }
+
+    // Stops calibrating. The completion won't be called.
+    public func cancel() {
+        guard completion != nil else { return }
+        completion = nil
+        finish()
+    }
+
+    // MARK: Private
+
+    private let midiContext: MIDIContext
+    private let destination: Destination
+    private let source: Source
+
+    private var completion: ((Result) -> Void)?
+    private var originalSpeeds: [(MIDIObject, Int32)] = []
+    private var inputStream: PortInputStream?
+
+    private var trials: [Trial] = []
+    private var bestSpeedIndex: Int?        // after the safety margin
+    private var bestBufferSize = 0
+    private var bufferSizeIndex = 0
+    private var speedIndex = 0
+    private var reliableSpeedIndex: Int?    // at the current buffer size
+    private var consecutiveSuccesses = 0
+
+    private var sendRequest: SysExSendRequest?
+    private var expectedData: Data?
+    private var trialNumber = 0
+    private var receivedEcho = false
+    private var echoTimeOutWorkItem: DispatchWorkItem?
+
+    // A non-commercial manufacturer ID, so test messages can't be mistaken for a real device's
+    private static let manufacturerIdentifier: UInt8 = 0x7D
+
+}
+
+extension SysExSpeedCalibrator: MessageDestination {
+
+    public func takeMIDIMessages(_ messages: [Message]) {
+        // Ignore anything else the source sends, and anything left from an earlier trial
+        guard let expectedData,
+              let message = messages.compactMap({ $0 as? SystemExclusiveMessage }).last(where: { Self.isTestMessage($0, trialNumber: trialNumber) })
+        else { return }
+
+        // The echo may arrive before CoreMIDI says it's done sending, if the loopback is virtual
+        let succeeded = message.wasReceivedWithEOX && message.data == expectedData
+        if !succeeded || sendRequest == nil {
+            finishTrial(succeeded: succeeded)
+        }
+        else {
+            receivedEcho = true
+        }
+    }
+
+}
+
+extension SysExSpeedCalibrator: SysExSendRequestDelegate {
+
+    public func sysExSendRequestDidFinish(_ sysExSendRequest: SysExSendRequest) {
+        guard sysExSendRequest == sendRequest else { return }
+        sendRequest = nil
+
+        if receivedEcho {
+            finishTrial(succeeded: true)
+        }
+        else {
+            let workItem = DispatchWorkItem { [weak self] in
+                self?.finishTrial(succeeded: false)
+            }
+            echoTimeOutWorkItem = workItem
+            DispatchQueue.main.asyncAfter(deadline: .now() + echoTimeOut, execute: workItem)
+        }
+    }
+
+}
+
+extension SysExSpeedCalibrator /* Private */ {
+
+    private static func isTestMessage(_ message: SystemExclusiveMessage, trialNumber: Int) -> Bool {
+        let data = message.data
+        return data.count >= 2 && data[data.startIndex] == manufacturerIdentifier && data[data.startIndex + 1] == UInt8(trialNumber & 0x7F)
+    }
+
+    private static func testMessageData(byteCount: Int, trialNumber: Int) -> Data {
+        // Manufacturer ID, trial number, then bytes that aren't all the same, so dropped or
+        // repeated bytes are noticed. Always the same bytes, so a failure can be reproduced.
+        var data = Data(capacity: byteCount)
+        data.append(manufacturerIdentifier)
+        data.append(UInt8(trialNumber & 0x7F))
+        var state: UInt32 = 0x2545F491
+        while data.count < byteCount {
+            state = state &* 1664525 &+ 1013904223
+            data.append(UInt8((state >> 24) & 0x7F))
+        }
+        return data
+    }
+
+    private func startTrial() {
+        guard completion != nil else { return }
+
+        while bufferSizeIndex < bufferSizes.count {
+            // After the first buffer size, only speeds faster than the best so far are worth trying
+            if let bestSpeedIndex {
+                speedIndex = max(speedIndex, bestSpeedIndex + 1)
+            }
+            guard speedIndex >= speeds.count else { break }
+
+            // Nothing left to try at this buffer size, and no failure to step back from
+            finishBufferSize(fastestUsableSpeedIndex: reliableSpeedIndex)
+        }
+
+        guard bufferSizeIndex < bufferSizes.count else {
+            succeed()
+            return
+        }
+
+        let bytesPerSecond = speeds[speedIndex]
+        setSpeed(Int32(bytesPerSecond))
+
+        trialNumber += 1
+        receivedEcho = false
+        // Long enough that a device's input buffer would overflow, if it's going to
+        let data = Self.testMessageData(byteCount: max(Int(Double(bytesPerSecond) * trialDuration), 64), trialNumber: trialNumber)
+        expectedData = data
+
+        let message = SystemExclusiveMessage(timeStamp: 0, data: data)
+        guard let request = SysExSendRequest(message: message, destination: destination, customSysExBufferSize: bufferSizes[bufferSizeIndex]) else {
+            finishTrial(succeeded: false)
+            return
+        }
+        sendRequest = request
+        request.delegate = self
+        if !request.send() {
+            sendRequest = nil
+            finishTrial(succeeded: false)
+        }
+    }
+
+    private func finishTrial(succeeded: Bool) {
+        guard let expectedData else { return }
+        self.expectedData = nil
+
+        echoTimeOutWorkItem?.cancel()
+        echoTimeOutWorkItem = nil
+        if let sendRequest {
+            self.sendRequest = nil
+            sendRequest.delegate = nil
+            sendRequest.cancel()
+        }
+
+        let trial = Trial(bytesPerSecond: speeds[speedIndex], bufferSize: bufferSizes[bufferSizeIndex], byteCount: expectedData.count + 2, succeeded: succeeded)
+        trials.append(trial)
+        trialHandler?(trial)
+
+        if succeeded {
+            consecutiveSuccesses += 1
+            if consecutiveSuccesses >= trialsPerSpeed {
+                reliableSpeedIndex = speedIndex
+                speedIndex += 1
+                consecutiveSuccesses = 0
+            }
+        }
+        else {
+            // Anything faster at this buffer size would fail too, and the reliable speed just below
+            // the failure may be marginal. Go on to the next buffer size.
+            finishBufferSize(fastestUsableSpeedIndex: reliableSpeedIndex.map { max($0 - safetyMargin, 0) })
+        }
+
+        // Let the device settle before the next trial, and don't recurse
+        DispatchQueue.main.asyncAfter(deadline: .now() + echoTimeOut) { [weak self] in
+            self?.startTrial()
+        }
+    }
+
+    private func finishBufferSize(fastestUsableSpeedIndex: Int?) {
+        if let fastestUsableSpeedIndex, fastestUsableSpeedIndex > bestSpeedIndex ?? -1 {
+            bestSpeedIndex = fastestUsableSpeedIndex
+            bestBufferSize = bufferSizes[bufferSizeIndex]
+        }
+
+        bufferSizeIndex += 1
+        speedIndex = 0
+        reliableSpeedIndex = nil
+        consecutiveSuccesses = 0
+    }
+
+    private func succeed() {
+        let result = Result(bytesPerSecond: bestSpeedIndex.map { speeds[$0] }, bufferSize: bestBufferSize, trials: trials)
+        let completion = self.completion
+        self.completion = nil
+        finish()
+        completion?(result)
+    }
+
+    private func finish() {
+        echoTimeOutWorkItem?.cancel()
+        echoTimeOutWorkItem = nil
+        if let sendRequest {
+            self.sendRequest = nil
+            sendRequest.delegate = nil
+            sendRequest.cancel()
+        }
+        expectedData = nil
+
+        inputStream?.messageDestination = nil
+        inputStream = nil
+
+        for (midiObject, speed) in originalSpeeds where midiObject.maxSysExSpeed != speed {
+            midiObject.maxSysExSpeed = speed
+        }
+        originalSpeeds = []
+        midiContext.forceCoreMIDIToUseNewSysExSpeed()
+    }
+
+    private func setSpeed(_ bytesPerSecond: Int32) {
+        // The external devices' speeds limit the destination's, so set them all
+        for (midiObject, _) in originalSpeeds where midiObject.maxSysExSpeed != bytesPerSecond {
+            midiObject.maxSysExSpeed = bytesPerSecond
+        }
+        midiContext.forceCoreMIDIToUseNewSysExSpeed()
+    }
+
+}
@@ -82,6 +82,20 @@ public class SystemCommonMessage: Message {
         storage.otherData
     }
 
+    public override func copyFullData(to buffer: UnsafeMutablePointer<UInt8>) -> Int {
+        buffer[0] = statusByte
+        var length = 1
+        if let dataByte1 = storage.dataByte1 {
+            buffer[length] = dataByte1
+            length += 1
+        }
+        if let dataByte2 = storage.dataByte2 {
+            buffer[length] = dataByte2
+            length += 1
+        }
+        return length
+    }
+
     public override var typeForDisplay: String {
         storage.typeForDisplay
     }
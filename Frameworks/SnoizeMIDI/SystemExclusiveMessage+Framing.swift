@@ -0,0 +1,149 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+extension SystemExclusiveMessage {
+
+    // A sysex message as sent or saved is 0xF0, then `data`, then 0xF7.
+    // Instead of making a new copy of the data with the start and end bytes attached,
+    // these functions present the message as three separate buffers, like an iovec array.
+    // That matters when the messages add up to hundreds of megabytes.
+
+    // Call `body` with the buffers that make up the full message: 0xF0, data, 0xF7.
+    // The buffers are only valid during the call.
+    public func withFullMessageBuffers<Result>(_ body: ([UnsafeRawBufferPointer]) throws -> Result) rethrows -> Result {
+        try data.withUnsafeBytes { dataBuffer in
+            try body([Self.startByteBuffer, dataBuffer, Self.endByteBuffer])
+        }
+    }
+
+    // Copy the full message into `destination`, which must have room for fullMessageDataLength bytes.
+    // Returns the number of bytes copied.
+    @discardableResult public func copyFullMessageBytes(to destination: UnsafeMutableRawBufferPointer) -> Int {
+        precondition(destination.count >= fullMessageDataLength)
+
+        return withFullMessageBuffers { buffers in
+            var offset = 0
+            for buffer in buffers where buffer.count > 0 {
+                UnsafeMutableRawBufferPointer(rebasing: destination[offset...]).copyMemory(from: buffer)
+                offset += buffer.count
+            }
+            return offset
+        }
+    }
+
+    // Write the messages to a .syx file, replacing any existing file atomically.
+    // The data is written straight from the messages with writev(), a batch of messages at a time,
+    // so no combined copy of all the data is ever made.
+    public static func writeData(forMessages messages: [SystemExclusiveMessage], to url: URL) throws {
+        let directoryURL = url.deletingLastPathComponent()
+        let temporaryURL = directoryURL.appendingPathComponent(".\(url.lastPathComponent).\(UUID().uuidString)")
+
+        let fileDescriptor = open(temporaryURL.path, O_WRONLY | O_CREAT | O_EXCL, 0o644)
+        guard fileDescriptor >= 0 else { throw posixError() }
+
+        do {
+            defer { close(fileDescriptor) }
+            try writeData(forMessages: messages, toFileDescriptor: fileDescriptor)
+            guard fsync(fileDescriptor) == 0 else { throw posixError() }
+        }
+        catch {
+            unlink(temporaryURL.path)
+            throw error
+        }
+
+        guard rename(temporaryURL.path, url.path) == 0 else {
+            let error = posixError()
+            unlink(temporaryURL.path)
+            throw error
+        }
+    }
+
+    public static func writeData(forMessages messages: [SystemExclusiveMessage], toFileDescriptor fileDescriptor: Int32) throws {
+        var batchStart = messages.startIndex
+        while batchStart < messages.endIndex {
+            let batchEnd = min(batchStart + maxMessagesPerWrite, messages.endIndex)
+
+            var vectors: [iovec] = []
+            vectors.reserveCapacity((batchEnd - batchStart) * 3)
+            try withVectors(for: messages[batchStart ..< batchEnd], appendingTo: &vectors) { vectors in
+                try writeVectors(vectors, toFileDescriptor: fileDescriptor)
+            }
+
+            batchStart = batchEnd
+        }
+    }
+
+    // MARK: Private
+
+    private static let startAndEndBytes: UnsafeMutableRawBufferPointer = {
+        let buffer = UnsafeMutableRawBufferPointer.allocate(byteCount: 2, alignment: 1)
+        buffer[0] = 0xF0
+        buffer[1] = 0xF7
+        return buffer
+    }()
+
+    private static var startByteBuffer: UnsafeRawBufferPointer {
+        UnsafeRawBufferPointer(rebasing: startAndEndBytes[0 ..< 1])
+    }
+
+    private static var endByteBuffer: UnsafeRawBufferPointer {
+        UnsafeRawBufferPointer(rebasing: startAndEndBytes[1 ..< 2])
+    }
+
+    // Keep each writev() under the usual IOV_MAX of 1024 vectors
+    private static let maxMessagesPerWrite = 1024 / 3
+
+    private static func withVectors(for messages: ArraySlice<SystemExclusiveMessage>, appendingTo vectors: inout [iovec], _ body: ([iovec]) throws -> Void) throws {
+        // Each message's buffers are only valid inside its withFullMessageBuffers call,
+        // so nest the calls, one per message, and write from the innermost one.
+        guard let message = messages.first else {
+            try body(vectors)
+            return
+        }
+
+        try message.withFullMessageBuffers { buffers in
+            for buffer in buffers where buffer.count > 0 {
+                vectors.append(iovec(iov_base: UnsafeMutableRawPointer(mutating: buffer.baseAddress), iov_len: buffer.count))
+            }
+            try withVectors(for: messages.dropFirst(), appendingTo: &vectors, body)
+        }
+    }
+
+    private static func writeVectors(_ vectors: [iovec], toFileDescriptor fileDescriptor: Int32) throws {
+        var vectors = vectors
+        var vectorIndex = 0
+        while vectorIndex < vectors.count {
+            let result = vectors[vectorIndex...].withUnsafeBufferPointer {
+                writev(fileDescriptor, $0.baseAddress, Int32($0.count))
+            }
+            if result < 0 {
+                if errno == EINTR {
+                    continue
+                }
+                throw posixError()
+            }
+
+            // Skip past what was written. A short write may end partway through a vector.
+            var remaining = result
+            while vectorIndex < vectors.count && remaining >= vectors[vectorIndex].iov_len {
+                remaining -= vectors[vectorIndex].iov_len
+                vectorIndex += 1
+            }
+            if remaining > 0 {
+                vectors[vectorIndex].iov_base = vectors[vectorIndex].iov_base.map { $0 + remaining }
+                vectors[vectorIndex].iov_len -= remaining
+            }
+        }
+    }
+
+    private static func posixError() -> Error {
+        NSError(domain: NSPOSIXErrorDomain, code: Int(errno), userInfo: nil)
+    }
+
+}
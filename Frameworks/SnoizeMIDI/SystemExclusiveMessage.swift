@@ -57,6 +57,14 @@ public class SystemExclusiveMessage: Message {
         data.count + 1  // Add a byte for the EOX at the end
     }
 
+    public override func copyFullData(to buffer: UnsafeMutablePointer<UInt8>) -> Int {
+        // Copy straight from `data`, without making otherData
+        buffer[0] = statusByte
+        data.copyBytes(to: buffer + 1, count: data.count)
+        buffer[1 + data.count] = 0xF7
+        return data.count + 2
+    }
+
     // Data as received, without starting 0xF0. May or may not include 0xF7.
     public var receivedData: Data {
         wasReceivedWithEOX ? otherData! : data
@@ -116,8 +124,10 @@ public class SystemExclusiveMessage: Message {
     private var cachedDataWithEOX: Data?
 
     private func dataByAddingStartByte(_ someData: Data) -> Data {
-        var result = someData
-        result.insert(0xF0, at: result.startIndex)
+        // Build the result in one allocation, instead of inserting at the start of a copy
+        var result = Data(capacity: someData.count + 1)
+        result.append(0xF0)
+        result.append(someData)
         return result
     }
 
@@ -156,61 +166,65 @@ extension SystemExclusiveMessage {
     public static func messages(fromData data: Data) -> [SystemExclusiveMessage] {
         // Scan through data and make messages out of it.
         // Messages must start with 0xF0.  Messages may end in any byte >= 0x80.
+        // Each message's data is a slice of `data`, not a copy, so this works well on memory-mapped files.
 
         var messages: [SystemExclusiveMessage] = []
 
-        var inMessage = false
-        var messageDataBounds = (lower: data.startIndex, upper: data.startIndex)
+        data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) in
+            guard let baseAddress = bytes.baseAddress else { return }
+
+            var offset = 0
+            while offset < bytes.count,
+                  let startBytePtr = memchr(baseAddress + offset, 0xF0, bytes.count - offset) {
+                let messageStart = baseAddress.distance(to: UnsafeRawPointer(startBytePtr)) + 1
+                let messageEnd = indexOfFirstStatusByte(in: bytes, from: messageStart)
+
+                if messageEnd > messageStart {
+                    let sysexData = data[(data.startIndex + messageStart) ..< (data.startIndex + messageEnd)]
+                    messages.append(SystemExclusiveMessage(timeStamp: 0, data: sysexData))
+                }
 
-        func addMessageIfPossible() {
-            let range = messageDataBounds.lower ..< messageDataBounds.upper
-            if !range.isEmpty {
-                let sysexData = data.subdata(in: range)
-                let message = SystemExclusiveMessage(timeStamp: 0, data: sysexData)
-                messages.append(message)
+                // The byte that ended this message may be the 0xF0 that starts the next one
+                offset = messageEnd
             }
         }
 
-        for (index, byte) in data.enumerated() {
-            if inMessage && byte >= 0x80 {
-                // end of the current message
-                messageDataBounds.upper = index
-                addMessageIfPossible()
-                inMessage = false
-            }
+        return messages
+    }
 
-            if byte == 0xF0 {
-                // start of the next message
-                inMessage = true
-                messageDataBounds.lower = index + 1
+    static private func indexOfFirstStatusByte(in bytes: UnsafeRawBufferPointer, from start: Int) -> Int {
+        var index = start
+
+        // Sysex data is mostly long runs of bytes < 0x80, so check 8 bytes at a time
+        // until one of them has its high bit set.
+        while index + 8 <= bytes.count {
+            let word = bytes.loadUnaligned(fromByteOffset: index, as: UInt64.self)
+            if word & 0x8080_8080_8080_8080 != 0 {
+                break
             }
+            index += 8
         }
 
-        if inMessage {
-            messageDataBounds.upper = data.endIndex
-            addMessageIfPossible()
+        while index < bytes.count && bytes[index] < 0x80 {
+            index += 1
         }
 
-        return messages
+        return index
     }
 
     public static func data(forMessages messages: [SystemExclusiveMessage]) -> Data? {
         guard messages.count > 0 else { return nil }
 
-        var resultData = Data()
-
-        // Reserve capacity for all the data up front, before concatenating.
-        // Each message is represented as 0xF0 + message.data + 0xF7
-        var totalCount: Int = 0
-        for message in messages {
-            totalCount += 1 + message.data.count + 1
-        }
-        resultData.reserveCapacity(totalCount)
-
-        for message in messages {
-            resultData.append(0xF0)
-            resultData.append(message.data)
-            resultData.append(0xF7)
+        // Each message is represented as 0xF0 + message.data + 0xF7.
+        // Copy each one straight into place in the result.
+        // (To write the data to a file, writeData(forMessages:to:) avoids making this copy at all.)
+        let totalCount = messages.reduce(0) { $0 + $1.fullMessageDataLength }
+        var resultData = Data(count: totalCount)
+        resultData.withUnsafeMutableBytes { (resultBuffer: UnsafeMutableRawBufferPointer) in
+            var offset = 0
+            for message in messages {
+                offset += message.copyFullMessageBytes(to: UnsafeMutableRawBufferPointer(rebasing: resultBuffer[offset...]))
+            }
         }
 
         return resultData
@@ -218,147 +232,103 @@ extension SystemExclusiveMessage {
 
 }
 
-import AudioToolbox
-
 extension SystemExclusiveMessage {
 
     // Extract sysex messages from a Standard MIDI file, and vice-versa.
 
     public static func messages(fromStandardMIDIFileData data: Data) -> [SystemExclusiveMessage] {
-        var possibleSequence: MusicSequence?
-        guard NewMusicSequence(&possibleSequence) == noErr, let sequence = possibleSequence else { return [] }
-        defer { _ = DisposeMusicSequence(sequence) }
-
-        guard MusicSequenceFileLoadData(sequence, data as CFData, .midiType, .smf_ChannelsToTracks) == noErr else { return [] }
-
-        // The last track should contain any sysex data.
-        var trackCount: UInt32 = 0
-        if MusicSequenceGetTrackCount(sequence, &trackCount) == noErr {
-            var possibleTrack: MusicTrack?
-            if MusicSequenceGetIndTrack(sequence, trackCount - 1, &possibleTrack) == noErr,
-               let track = possibleTrack {
-                return messages(fromTrack: track)
+        // A sysex message may be split into several events: an 0xF0 event with the start of the message,
+        // then 0xF7 "continuation" events with the rest. The message is complete when its data ends with 0xF7.
+        // Complete messages use a slice of the file's data; only split messages need to be copied.
+        // Messages which are never completed are ignored.
+
+        var found: [(tick: UInt64, message: SystemExclusiveMessage)] = []
+        var accumulatingSysexData: Data?
+        var accumulatingTrackIndex = 0
+        var sawMultipleTracks = false
+
+        func addMessageIfComplete(_ sysexData: Data, tick: UInt64) {
+            if sysexData.count > 1 && sysexData.last! == 0xF7 {
+                // Cut off the ending 0xF7 byte and create a message.
+                found.append((tick, SystemExclusiveMessage(timeStamp: 0, data: sysexData.dropLast())))
+                accumulatingSysexData = nil
+            }
+            else {
+                accumulatingSysexData = sysexData
             }
         }
 
-        return []
-    }
-
-    static private func messages(fromTrack track: MusicTrack) -> [SystemExclusiveMessage] {
-        // Iterate through the events, looking for MIDI "raw data" events, which may contain sysex data.
-        // (The names get confusing, because we also use Swift's "raw pointers" to get to the data
-        // from this old C-based API.)
-
-        var messages: [SystemExclusiveMessage] = []
+        StandardMIDIFileReader(data: data).forEachEvent { event in
+            if event.trackIndex != accumulatingTrackIndex {
+                // Split messages can't continue across tracks
+                accumulatingSysexData = nil
+                accumulatingTrackIndex = event.trackIndex
+                sawMultipleTracks = sawMultipleTracks || !found.isEmpty
+            }
 
-        var possibleIterator: MusicEventIterator?
-        if NewMusicEventIterator(track, &possibleIterator) == noErr,
-           let iterator = possibleIterator {
-            defer { _ = DisposeMusicEventIterator(iterator) }
-
-            var accumulatingSysexData: Data?
-
-            var hasCurrentEvent: DarwinBoolean = false
-            MusicEventIteratorHasCurrentEvent(iterator, &hasCurrentEvent)
-            while hasCurrentEvent.boolValue {
-                var timeStamp: MusicTimeStamp = 0   // ignored
-                var eventType: MusicEventType = kMusicEventType_NULL
-                var eventData: UnsafeRawPointer?
-                var eventDataSize: UInt32 = 0
-
-                let status = MusicEventIteratorGetEventInfo(iterator, &timeStamp, &eventType, &eventData, &eventDataSize)
-
-                if status == noErr && eventType == kMusicEventType_MIDIRawData && eventDataSize > 0,
-                   let eventData {
-                    // eventData is a pointer to a MIDIRawData struct, which contains
-                    // another length field and then the "raw" MIDI data.
-                    let midiRawDataEventPtr = eventData.bindMemory(to: MIDIRawData.self, capacity: Int(eventDataSize))
-                    let midiRawDataLength = Int(midiRawDataEventPtr.pointee.length)
-                    if midiRawDataLength > 0 {
-                        // You might try to do this:
-                        // withUnsafePointer(to: midiRawDataEventPtr.pointee.data) { midiRawDataPtr in
-                        //     let midiRawData = Data(UnsafeBufferPointer(start: midiRawDataPtr, count: midiRawDataLength))
-                        // but ASAN dislikes that, so construct the pointer to the data manually.
-                        let midiRawData = Data(bytes: eventData + MemoryLayout.offset(of: \MIDIRawData.data)!, count: midiRawDataLength)
-
-                        let firstByte = midiRawData.first!
-                        if firstByte == 0xF0 {
-                            // Starting a sysex message. Omit the 0xF0.
-                            accumulatingSysexData = midiRawData.dropFirst()
-                        }
-                        else if accumulatingSysexData != nil {
-                            // Continuing a sysex message.
-                            // (This can happen in theory according to the SMF spec, but I'm not seeing it in practice;
-                            //  it's possible that MusicSequence abstracts this away by concatenating sysex events together
-                            //  before we see them. If this does happen, I'm not sure whether we will see the event data
-                            //  starting with 0xF7 or not, so handle both ways.)
-                            if firstByte == 0xF7 {
-                                accumulatingSysexData?.append(midiRawData.dropFirst())
-                            }
-                            else {
-                                accumulatingSysexData?.append(midiRawData)
-                            }
-                        }
-
-                        if let accumulatedSysexData = accumulatingSysexData,
-                           accumulatedSysexData.count > 1,
-                           accumulatedSysexData.last! == 0xF7 {
-                            // Ending a sysex message.
-                            // Cut off the ending 0xF7 byte and create a message.
-                            let sysexMessage = SystemExclusiveMessage(timeStamp: 0, data: accumulatedSysexData.dropLast())
-                            messages.append(sysexMessage)
-
-                            accumulatingSysexData = nil
-                        }
-                    }
+            switch event.kind {
+            case .sysEx:
+                // Starting a sysex message. (The data does not include the 0xF0.)
+                addMessageIfComplete(event.data, tick: event.tick)
+            case .escape:
+                if var sysexData = accumulatingSysexData {
+                    // Continuing a sysex message.
+                    accumulatingSysexData = nil     // so appending doesn't need to copy
+                    sysexData.append(event.data)
+                    addMessageIfComplete(sysexData, tick: event.tick)
                 }
-
-                _ = MusicEventIteratorNextEvent(iterator)
-                _ = MusicEventIteratorHasCurrentEvent(iterator, &hasCurrentEvent)
+                else if event.data.first == 0xF0 {
+                    // Some files put an entire sysex message in an escape event.
+                    addMessageIfComplete(event.data.dropFirst(), tick: event.tick)
+                }
+            default:
+                break
             }
         }
 
-        return messages
+        // Messages from different tracks should be in time order, as if the tracks were merged.
+        if sawMultipleTracks {
+            found = found.enumerated()
+                .sorted { ($0.element.tick, $0.offset) < ($1.element.tick, $1.offset) }
+                .map(\.element)
+        }
+
+        return found.map(\.message)
     }
 
     public static func standardMIDIFileData(forMessages messages: [SystemExclusiveMessage]) -> Data? {
         guard messages.count > 0 else { return nil }
 
-        var possibleSequence: MusicSequence?
-        guard NewMusicSequence(&possibleSequence) == noErr, let sequence = possibleSequence else { return nil }
-        defer { _ = DisposeMusicSequence(sequence) }
+        let writer = StandardMIDIFileWriter()
+        do {
+            try writeSpacedForSending(messages, to: writer)
+            try writer.finish()
+            return writer.data
+        }
+        catch {
+            return nil
+        }
+    }
 
-        var possibleTrack: MusicTrack?
-        guard MusicSequenceNewTrack(sequence, &possibleTrack) == noErr, let track = possibleTrack else { return nil }
+    // Like standardMIDIFileData(forMessages:), but streams straight to a file.
+    public static func writeStandardMIDIFile(forMessages messages: [SystemExclusiveMessage], to url: URL) throws {
+        try StandardMIDIFileWriter.writeFile(at: url) { writer in
+            try writeSpacedForSending(messages, to: writer)
+        }
+    }
 
-        var timeStamp: MusicTimeStamp = 0
+    static private func writeSpacedForSending(_ messages: [SystemExclusiveMessage], to writer: StandardMIDIFileWriter) throws {
+        var seconds = 0.0
         for message in messages {
-            let messageData = message.fullMessageData
-
-            // Create a buffer large enough for a MIDIRawData struct containing all messageData
-            let structCount = MemoryLayout.offset(of: \MIDIRawData.data)! + messageData.count
-            let mutableRawPointer = UnsafeMutableRawPointer.allocate(byteCount: structCount, alignment: MemoryLayout<MIDIRawData>.alignment)
-            defer { mutableRawPointer.deallocate() }
+            try writer.write(message, atTick: writer.tick(forNanoseconds: UInt64(seconds * 1.0e9)))
 
-            let midiRawDataPtr = mutableRawPointer.bindMemory(to: MIDIRawData.self, capacity: structCount)
-            midiRawDataPtr.pointee.length = UInt32(messageData.count)
-            messageData.copyBytes(to: &midiRawDataPtr.pointee.data, count: messageData.count)
-
-            guard MusicTrackNewMIDIRawDataEvent(track, timeStamp, midiRawDataPtr) == noErr else { return nil }
-
-            // Advance timeStamp by the duration required to send this message,
+            // Advance by the duration required to send this message,
             // plus a gap between messages
             let midiSpeed = 3125.0  // bytes / sec
-            let midiDuration = Double(messageData.count) / midiSpeed
+            let midiDuration = Double(message.fullMessageDataLength) / midiSpeed
             let gapDuration = 0.150 // seconds
-            var durationTimeStamp: MusicTimeStamp = 0
-            MusicSequenceGetBeatsForSeconds(sequence, Float64(midiDuration + gapDuration), &durationTimeStamp)
-            timeStamp += durationTimeStamp
+            seconds += midiDuration + gapDuration
         }
-
-        var unmanagedResultData: Unmanaged<CFData>?
-        guard MusicSequenceFileCreateData(sequence, .midiType, MusicSequenceFileFlags(rawValue: 0), 0, &unmanagedResultData) == noErr else { return nil }
-        return unmanagedResultData?.takeRetainedValue() as Data?
     }
 
 }
@@ -377,4 +347,10 @@ public class HackSystemExclusiveMessage: SystemExclusiveMessage {
         }
     }
 
+    public override func copyFullData(to buffer: UnsafeMutablePointer<UInt8>) -> Int {
+        buffer[0] = statusByte
+        data.copyBytes(to: buffer + 1, count: data.count)
+        return data.count + 1
+    }
+
 }
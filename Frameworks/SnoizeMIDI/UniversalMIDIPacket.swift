@@ -0,0 +1,208 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+// A Universal MIDI Packet (UMP), as delivered in a MIDIEventList: one MIDI 1.0 or 2.0 message
+// in 1 to 4 32-bit words.
+//
+// This file uses only the Swift standard library -- no CoreMIDI, not even Foundation --
+// so the parsing can be built and measured on any platform.
+
+public struct UniversalMIDIPacket {
+
+    // Splits `words` into packets, calling `body` with each one. The first word of each packet says how many
+    // words are in it. If the last packet is missing some of its words, it is ignored.
+    public static func forEachPacket(in words: UnsafeBufferPointer<UInt32>, timeStamp: UInt64, _ body: (UniversalMIDIPacket) -> Void) {
+        var index = 0
+        while index < words.count {
+            let wordCount = Self.wordCount(messageType: UInt8(truncatingIfNeeded: words[index] >> 28))
+            guard index + wordCount <= words.count else { break }
+
+            let packet = UniversalMIDIPacket(
+                words: (words[index],
+                        wordCount > 1 ? words[index + 1] : 0,
+                        wordCount > 2 ? words[index + 2] : 0,
+                        wordCount > 3 ? words[index + 3] : 0),
+                wordCount: wordCount,
+                timeStamp: timeStamp)
+            body(packet)
+
+            index += wordCount
+        }
+    }
+
+    // Unused words are 0. Kept inline, instead of in an array, so making packets doesn't allocate memory.
+    public let words: (UInt32, UInt32, UInt32, UInt32)
+    public let wordCount: Int
+    public let timeStamp: UInt64
+
+    public init(words: (UInt32, UInt32, UInt32, UInt32), wordCount: Int, timeStamp: UInt64) {
+        self.words = words
+        self.wordCount = wordCount
+        self.timeStamp = timeStamp
+    }
+
+    public static func wordCount(messageType: UInt8) -> Int {
+        switch messageType & 0x0F {
+        case 0x0, 0x1, 0x2, 0x6, 0x7:   return 1
+        case 0x3, 0x4, 0x8, 0x9, 0xA:   return 2
+        case 0xB, 0xC:                  return 3
+        default:                        return 4    // 0x5, 0xD, 0xE, 0xF
+        }
+    }
+
+    public var messageType: UInt8 {
+        UInt8(truncatingIfNeeded: words.0 >> 28)
+    }
+
+    public var group: UInt8 {
+        UInt8(truncatingIfNeeded: words.0 >> 24) & 0x0F
+    }
+
+    // The packet's bytes, in order, starting with the most significant byte of the first word
+    public subscript(byteIndex: Int) -> UInt8 {
+        let word: UInt32
+        switch byteIndex / 4 {
+        case 0:     word = words.0
+        case 1:     word = words.1
+        case 2:     word = words.2
+        default:    word = words.3
+        }
+        return UInt8(truncatingIfNeeded: word >> (24 - 8 * UInt32(byteIndex % 4)))
+    }
+
+    // A range of a packet's bytes, for the data in sysex and flex data messages
+    public struct Bytes: RandomAccessCollection {
+        public let packet: UniversalMIDIPacket
+        public let startIndex: Int
+        public let endIndex: Int
+
+        public subscript(position: Int) -> UInt8 {
+            packet[position]
+        }
+    }
+
+    public enum ChunkStatus: UInt8 {
+        case complete = 0
+        case start = 1
+        case `continue` = 2
+        case end = 3
+    }
+
+    // What the packet means. Values are as they are in the packet, not scaled.
+    public enum Event {
+        case utility(status: UInt8, value: UInt16)
+        case system(status: UInt8, data1: UInt8, data2: UInt8)
+        case midi1ChannelVoice(status: UInt8, data1: UInt8, data2: UInt8)   // status includes the channel
+
+        // MIDI 2.0 channel voice messages. Channels are 0-15.
+        case noteOff(channel: UInt8, note: UInt8, velocity: UInt16, attributeType: UInt8, attribute: UInt16)
+        case noteOn(channel: UInt8, note: UInt8, velocity: UInt16, attributeType: UInt8, attribute: UInt16)
+        case polyPressure(channel: UInt8, note: UInt8, value: UInt32)
+        case controlChange(channel: UInt8, index: UInt8, value: UInt32)
+        case programChange(channel: UInt8, program: UInt8, bankMSB: UInt8?, bankLSB: UInt8?)
+        case channelPressure(channel: UInt8, value: UInt32)
+        case pitchBend(channel: UInt8, value: UInt32)
+        case registeredController(channel: UInt8, bank: UInt8, index: UInt8, value: UInt32)
+        case assignableController(channel: UInt8, bank: UInt8, index: UInt8, value: UInt32)
+        case otherChannelVoice(status: UInt8, channel: UInt8)   // per-note and relative controllers, and per-note management
+
+        case sysEx7(ChunkStatus, Bytes)
+        case sysEx8(ChunkStatus, streamID: UInt8, Bytes)
+        case mixedDataSet(status: UInt8)
+        case flexData(format: UInt8, address: UInt8, channel: UInt8, statusBank: UInt8, status: UInt8, Bytes)
+        case stream(status: UInt16)
+        case unknown
+    }
+
+    public var event: Event {
+        let status = self[1]
+        let high = status >> 4
+        let low = status & 0x0F
+
+        switch messageType {
+        case 0x0:
+            return .utility(status: high, value: UInt16(truncatingIfNeeded: words.0))
+
+        case 0x1:
+            return .system(status: status, data1: self[2], data2: self[3])
+
+        case 0x2:
+            return .midi1ChannelVoice(status: status, data1: self[2], data2: self[3])
+
+        case 0x3:
+            guard let chunkStatus = ChunkStatus(rawValue: high) else { return .unknown }
+            let byteCount = min(Int(low), 6)
+            return .sysEx7(chunkStatus, Bytes(packet: self, startIndex: 2, endIndex: 2 + byteCount))
+
+        case 0x4:
+            return midi2ChannelVoiceEvent(status: high, channel: low)
+
+        case 0x5:
+            if let chunkStatus = ChunkStatus(rawValue: high) {
+                // The byte count includes the stream ID
+                let byteCount = max(min(Int(low), 14), 1)
+                return .sysEx8(chunkStatus, streamID: self[2], Bytes(packet: self, startIndex: 3, endIndex: 2 + byteCount))
+            }
+            else {
+                return .mixedDataSet(status: high)
+            }
+
+        case 0xD:
+            return .flexData(format: status >> 6, address: (status >> 4) & 0x03, channel: low, statusBank: self[2], status: self[3], Bytes(packet: self, startIndex: 4, endIndex: 16))
+
+        case 0xF:
+            return .stream(status: UInt16(truncatingIfNeeded: words.0 >> 16) & 0x03FF)
+
+        default:
+            return .unknown
+        }
+    }
+
+    // MARK: Private
+
+    private func midi2ChannelVoiceEvent(status: UInt8, channel: UInt8) -> Event {
+        let byte2 = self[2]
+        let byte3 = self[3]
+        let value = words.1
+
+        switch status {
+        case 0x8:
+            return .noteOff(channel: channel, note: byte2, velocity: UInt16(truncatingIfNeeded: value >> 16), attributeType: byte3, attribute: UInt16(truncatingIfNeeded: value))
+        case 0x9:
+            return .noteOn(channel: channel, note: byte2, velocity: UInt16(truncatingIfNeeded: value >> 16), attributeType: byte3, attribute: UInt16(truncatingIfNeeded: value))
+        case 0xA:
+            return .polyPressure(channel: channel, note: byte2, value: value)
+        case 0xB:
+            return .controlChange(channel: channel, index: byte2, value: value)
+        case 0xC:
+            // The bank is only there if the "bank valid" option flag is set
+            let isBankValid = byte3 & 0x01 != 0
+            return .programChange(channel: channel, program: self[4], bankMSB: isBankValid ? self[6] : nil, bankLSB: isBankValid ? self[7] : nil)
+        case 0xD:
+            return .channelPressure(channel: channel, value: value)
+        case 0xE:
+            return .pitchBend(channel: channel, value: value)
+        case 0x2:
+            return .registeredController(channel: channel, bank: byte2, index: byte3, value: value)
+        case 0x3:
+            return .assignableController(channel: channel, bank: byte2, index: byte3, value: value)
+        default:
+            return .otherChannelVoice(status: status, channel: channel)
+        }
+    }
+
+}
+
+extension UniversalMIDIPacket: Equatable {
+
+    public static func == (lhs: UniversalMIDIPacket, rhs: UniversalMIDIPacket) -> Bool {
+        lhs.wordCount == rhs.wordCount && lhs.timeStamp == rhs.timeStamp
+            && lhs.words.0 == rhs.words.0 && lhs.words.1 == rhs.words.1
+            && lhs.words.2 == rhs.words.2 && lhs.words.3 == rhs.words.3
+    }
+
+}
@@ -0,0 +1,155 @@
+/*
+ Copyright (c) 2026, Kurt Revis.  All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+import Foundation
+
+public class UniversalMIDIPacketConverter {
+
+    // Converts Universal MIDI Packets to MIDI 1.0 messages, following the MIDI 2.0 spec's translation rules.
+    // MIDI 2.0 values are scaled down to 1.0 resolution; registered and assignable controllers become
+    // RPN and NRPN control changes, and a program change with a bank becomes bank select control changes
+    // followed by the program change.
+    //
+    // Sysex that's split across several packets is put back together, separately for each group.
+    // Packets that have no MIDI 1.0 equivalent (like 8-bit sysex, flex data, and utility messages) are skipped.
+
+    public init() {
+    }
+
+    public func messages(for packets: [UniversalMIDIPacket]) -> [Message] {
+        var messages: [Message] = []
+        for packet in packets {
+            appendMessages(for: packet, to: &messages)
+        }
+        return messages
+    }
+
+    // Forgets any sysex that was only partly received
+    public func reset() {
+        sysExInProgress = [:]
+    }
+
+    // MARK: Private
+
+    private var sysExInProgress: [UInt8: (timeStamp: MIDITimeStamp, data: Data)] = [:]   // by group
+
+    private func appendMessages(for packet: UniversalMIDIPacket, to messages: inout [Message]) {
+        let timeStamp = packet.timeStamp
+
+        func appendVoiceMessage(_ status: UInt8, _ channel: UInt8, _ data: [UInt8]) {
+            // Data bytes in a packet could be out of range, but a message's can't be
+            messages.append(VoiceMessage(timeStamp: timeStamp, statusByte: status << 4 | channel, data: data.map { $0 & 0x7F }))
+        }
+
+        func appendControlChange(_ channel: UInt8, _ index: UInt8, _ value: UInt8) {
+            appendVoiceMessage(0xB, channel, [index, value])
+        }
+
+        func appendParameterNumber(_ channel: UInt8, _ msbIndex: UInt8, _ lsbIndex: UInt8, _ bank: UInt8, _ index: UInt8, _ value: UInt32) {
+            // RPN or NRPN: select the parameter, then data entry MSB and LSB
+            let value14 = value >> 18
+            appendControlChange(channel, msbIndex, bank)
+            appendControlChange(channel, lsbIndex, index)
+            appendControlChange(channel, 6, UInt8(value14 >> 7))
+            appendControlChange(channel, 38, UInt8(value14 & 0x7F))
+        }
+
+        switch packet.event {
+        case .system(let status, let data1, let data2):
+            if let type = SystemRealTimeMessage.MessageType(rawValue: status) {
+                messages.append(SystemRealTimeMessage(timeStamp: timeStamp, type: type))
+            }
+            else if let status = SystemCommonMessage.Status(rawValue: status) {
+                let data = Array([data1 & 0x7F, data2 & 0x7F].prefix(status.otherDataLength))
+                messages.append(SystemCommonMessage(timeStamp: timeStamp, status: status, data: data))
+            }
+
+        case .midi1ChannelVoice(let status, let data1, let data2):
+            guard (0x80 ..< 0xF0).contains(status) else { break }
+            let dataCount = (0xC0 ..< 0xE0).contains(status & 0xF0) ? 1 : 2
+            appendVoiceMessage(status >> 4, status & 0x0F, Array([data1, data2].prefix(dataCount)))
+
+        case .noteOff(let channel, let note, let velocity, _, _):
+            appendVoiceMessage(0x8, channel, [note, Self.scale(velocity)])
+
+        case .noteOn(let channel, let note, let velocity, _, _):
+            // A 1.0 note on with velocity 0 means note off, so the lowest a 2.0 note on can become is 1
+            appendVoiceMessage(0x9, channel, [note, max(Self.scale(velocity), 1)])
+
+        case .polyPressure(let channel, let note, let value):
+            appendVoiceMessage(0xA, channel, [note, Self.scale(value)])
+
+        case .controlChange(let channel, let index, let value):
+            appendControlChange(channel, index, Self.scale(value))
+
+        case .programChange(let channel, let program, let bankMSB, let bankLSB):
+            if let bankMSB, let bankLSB {
+                appendControlChange(channel, 0, bankMSB)
+                appendControlChange(channel, 32, bankLSB)
+            }
+            appendVoiceMessage(0xC, channel, [program])
+
+        case .channelPressure(let channel, let value):
+            appendVoiceMessage(0xD, channel, [Self.scale(value)])
+
+        case .pitchBend(let channel, let value):
+            let value14 = value >> 18
+            appendVoiceMessage(0xE, channel, [UInt8(value14 & 0x7F), UInt8(value14 >> 7)])
+
+        case .registeredController(let channel, let bank, let index, let value):
+            appendParameterNumber(channel, 101, 100, bank, index, value)
+
+        case .assignableController(let channel, let bank, let index, let value):
+            appendParameterNumber(channel, 99, 98, bank, index, value)
+
+        case .sysEx7(let chunkStatus, let bytes):
+            appendSysEx(chunkStatus, bytes, group: packet.group, timeStamp: timeStamp, to: &messages)
+
+        default:
+            break
+        }
+    }
+
+    private func appendSysEx(_ chunkStatus: UniversalMIDIPacket.ChunkStatus, _ bytes: UniversalMIDIPacket.Bytes, group: UInt8, timeStamp: MIDITimeStamp, to messages: inout [Message]) {
+        switch chunkStatus {
+        case .complete:
+            messages.append(SystemExclusiveMessage(timeStamp: timeStamp, data: Data(bytes)))
+
+        case .start:
+            // Starting a new one abandons any that wasn't finished
+            if let abandoned = sysExInProgress[group] {
+                messages.append(Self.unfinishedSysExMessage(abandoned))
+            }
+            sysExInProgress[group] = (timeStamp, Data(bytes))
+
+        case .continue, .end:
+            // Ignore the middle or end of a message whose start we didn't get
+            guard sysExInProgress[group] != nil else { return }
+            sysExInProgress[group]!.data.append(contentsOf: bytes)
+
+            if chunkStatus == .end, let finished = sysExInProgress.removeValue(forKey: group) {
+                messages.append(SystemExclusiveMessage(timeStamp: finished.timeStamp, data: finished.data))
+            }
+        }
+    }
+
+    private static func unfinishedSysExMessage(_ sysEx: (timeStamp: MIDITimeStamp, data: Data)) -> SystemExclusiveMessage {
+        let message = SystemExclusiveMessage(timeStamp: sysEx.timeStamp, data: sysEx.data)
+        message.wasReceivedWithEOX = false
+        return message
+    }
+
+    // Scale to 7 bits by keeping the most significant bits, as the spec says to
+    private static func scale(_ value: UInt16) -> UInt8 {
+        UInt8(value >> 9)
+    }
+
+    private static func scale(_ value: UInt32) -> UInt8 {
+        UInt8(value >> 25)
+    }
+
+}
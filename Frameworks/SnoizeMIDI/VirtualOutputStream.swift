@@ -19,7 +19,7 @@ public class VirtualOutputStream: OutputStream {
     }
 
     override func send(_ packetListPtr: UnsafePointer<MIDIPacketList>) {
-        MIDIReceived(endpoint.endpointRef, packetListPtr)
+        _ = midiContext.interface.received(endpoint.endpointRef, packetListPtr)
     }
 
 }
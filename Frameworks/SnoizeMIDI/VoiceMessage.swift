@@ -165,6 +165,18 @@ public class VoiceMessage: Message {
         }
     }
 
+    public override func copyFullData(to buffer: UnsafeMutablePointer<UInt8>) -> Int {
+        let otherDataLength = otherDataLength
+        buffer[0] = statusByte
+        if otherDataLength > 0 {
+            buffer[1] = dataBytes.0
+        }
+        if otherDataLength > 1 {
+            buffer[2] = dataBytes.1
+        }
+        return 1 + otherDataLength
+    }
+
     public override var typeForDisplay: String {
         switch status {
         case .noteOn: